@@ -82,6 +82,7 @@
 #include "errs.h"
 #include "getopt.h"
 #include "convert.h"
+#include "include/apg.hpp"
 
  struct pass_m {
         unsigned int pass;	         /* password generation mode        */
@@ -721,3 +722,69 @@ int construct_mode(char *s_mode, struct  pass_m * mde)
  return (0);
 }
 
+/*
+** apgGenerate() - reentrant password generation
+** INPUT:
+**   const ApgParams & - generation parameters.
+**   char * - password (at least APG_MAX_PASSWORD_LENGTH + 1 bytes).
+** OUTPUT:
+**   int - password length.
+**    -1 - wrong parameters or no random device
+** NOTES:
+**   state is on the stack, random numbers come from the
+**   generator of the calling thread (see rnd.cpp).
+*/
+int
+apgGenerate (const ApgParams & params, char * password)
+{
+ struct pass_m mode;
+ char hyph_pass_string[APG_MAX_PASSWORD_LENGTH * 18];
+ int length = -1;
+ int classes = 0;
+ int i = 0;
+
+ if (params.algorithm < 0 || params.algorithm > 1 ||
+     params.mode.size() > MAX_MODE_LENGTH ||
+     construct_mode(const_cast<char*>( params.mode.c_str() ), &mode) == -1 ||
+     mode.pass == 0)
+   return (-1);
+ /* the filter could never be passed, each class needs a symbol */
+ for (i = 0; i < 4; i++)
+   if ((mode.filter & (1U << i)) > 0)
+     classes++;
+ if (params.maxLength < classes)
+   return (-1);
+
+ try
+  {
+   do
+    {
+     if (params.algorithm == 0)
+       length = gen_pron_pass(password, hyph_pass_string,
+                              params.minLength, params.maxLength, mode.pass);
+     else
+       length = gen_rand_pass(password, params.minLength,
+                              params.maxLength, mode.pass);
+    }
+   while (length > 0 && mode.filter != 0 &&
+          filter_check_pass(password, mode.filter) != 0);
+  }
+ catch (std::runtime_error &)
+  {
+   /* no random numbers (see rnd_next) */
+   rnd_wipe (password, APG_MAX_PASSWORD_LENGTH + 1);
+   length = -1;
+  }
+
+ rnd_wipe (hyph_pass_string, sizeof(hyph_pass_string));
+ return (length);
+}
+
+/*
+** apgWipe() - overwrites memory, not optimized away
+*/
+void
+apgWipe (void * p, std::size_t n)
+{
+ rnd_wipe (p, n);
+}
@@ -1,10 +1,49 @@
 #ifndef APG_HPP
 #define APG_HPP
 
+#include <cstddef>
 #include <vector>
 #include <string>
 #include <utility>
 
 std::vector<std::pair<std::string,std::string>> apg( int argc, char *argv[] );
 
+/* maximal password length (APG_MAX_PASSWORD_LENGTH) */
+const unsigned short APG_MAX_LENGTH = 255;
+
+/* parameters of apgGenerate(), like apg -a, -M, -m and -x */
+struct ApgParams
+{
+   ApgParams() : algorithm( 1 ), mode( "SNCL" ), minLength( 16 ), maxLength( 24 ) {}
+
+   int algorithm;
+   std::string mode;
+   unsigned short minLength;
+   unsigned short maxLength;
+};
+
+/*
+** Reentrant generation of a single password into password
+** (at least APG_MAX_LENGTH + 1 bytes), random numbers are drawn from
+** a generator per thread. Returns password length, -1 if params
+** are invalid or the random device can't be read. Must not run
+** concurrently with apg().
+*/
+int apgGenerate( const ApgParams& params, char* password );
+
+/* overwrites memory, not optimized away */
+void apgWipe( void* p, std::size_t n );
+
+/* generates password directly into string of type S */
+template <typename S>
+S apgGenerate( const ApgParams& params )
+{
+   char password[ APG_MAX_LENGTH + 1 ];
+   const int length( apgGenerate( params, password ) );
+   S result( password, length < 0 ? 0 : length );
+   apgWipe( password, sizeof( password ) );
+
+   return result;
+}
+
 #endif
@@ -1675,8 +1675,8 @@ gen_syllable (char *syllable, USHORT pwlen, USHORT *units_in_syllable,
     USHORT  last_unit = 0;
     SHORT   length_left = 0;
     USHORT  hold_saved_unit = 0;
-    static  USHORT saved_unit;
-    static  USHORT saved_pair[2];
+    static thread_local USHORT saved_unit;
+    static thread_local USHORT saved_pair[2];
 
     /*
      * This is needed if the saved_unit is tries and the syllable then
@@ -27,6 +27,7 @@
 ** SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32) && !defined(__WIN32__)
@@ -37,6 +38,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include "rnd.h"
+#include "errs.h"
 
 #ifndef APG_USE_SHA 
 #  include "./cast/cast.h"
@@ -46,6 +48,97 @@
 
 UINT32 __rnd_seed[2]; /* Random Seed 2*32=64 */
 
+/*
+** rnd_wipe - overwrites memory, not optimized away.
+*/
+void
+rnd_wipe (void *p, size_t n)
+{
+ volatile unsigned char *v = (volatile unsigned char *)p;
+ while (n-- > 0)
+   *v++ = 0;
+}
+
+#ifndef APG_USE_SHA
+/*
+** Per thread generator: CAST-128 in counter mode, keyed from
+** APG_DEVURANDOM and rekeyed every APG_RND_REKEY blocks, so
+** randint() is reentrant and threads never share state.
+*/
+#define APG_RND_REKEY 65536
+
+struct rnd_state
+{
+ cast_key key;
+ uint32_t counter[2];
+ uint32_t block[2];
+ int available;
+ unsigned long blocks;
+ int seeded;
+};
+
+static thread_local struct rnd_state __rnd_state;
+
+/*
+** rnd_rekey - keys the generator of the calling thread.
+** OUTPUT:
+**   int - 0 if keyed from APG_DEVURANDOM, -1 otherwise.
+*/
+static int
+rnd_rekey (struct rnd_state *st)
+{
+ u8 seed[24];
+ FILE * dr;
+ int ok = -1;
+
+ if ( (dr = fopen(APG_DEVURANDOM, "r")) != NULL)
+  {
+   if (fread( (void *)&seed[0], sizeof(seed), 1, dr) == 1)
+     ok = 0;
+   (void) fclose(dr);
+  }
+ if (ok == 0)
+  {
+   cast_setkey(&st->key, &seed[0], 16);
+   (void)memcpy ( (void *)&st->counter[0], (void *)&seed[16], 8);
+   st->available = 0;
+   st->blocks = 0;
+  }
+ rnd_wipe (seed, sizeof(seed));
+ return (ok);
+}
+
+/*
+** rnd_next - next 32 random bits of the calling thread's generator,
+**            fails (err_app_fatal) if there is no random device, the
+**            x917 generator would not be seeded.
+*/
+static uint32_t
+rnd_next (void)
+{
+ struct rnd_state *st = &__rnd_state;
+
+ if (st->seeded == 0 || st->blocks >= APG_RND_REKEY)
+  {
+   if (rnd_rekey (st) == -1)
+     err_app_fatal ("rnd", "failed to read " APG_DEVURANDOM);
+   st->seeded = 1;
+  }
+ if (st->available == 0)
+  {
+   u8 in[8];
+   (void)memcpy ( (void *)&in[0], (void *)&st->counter[0], 8);
+   cast_encrypt (&st->key, &in[0], (u8 *)&st->block[0]);
+   if (++st->counter[0] == 0)
+     ++st->counter[1];
+   st->blocks++;
+   st->available = 2;
+  }
+ return (st->block[--st->available]);
+}
+
+#endif /* APG_USE_SHA */
+
 /*
 ** randint(int n) - Produces a Random number from 0 to n-1.
 ** INPUT:
@@ -59,7 +152,13 @@ UINT
 randint(int n)
 {
 #ifndef APG_USE_SHA
- return ( (UINT)( x917cast_rnd() % (UINT32)n ) );
+ /* reject values above the largest multiple of n (no modulo bias) */
+ uint32_t limit = 0xFFFFFFFFU - (0xFFFFFFFFU % (uint32_t)n);
+ uint32_t r;
+ do
+   r = rnd_next();
+ while (r >= limit);
+ return ( (UINT)( r % (uint32_t)n ) );
 #else /* APG_USE_SHA */
  return ( (UINT)( x917sha1_rnd() % (UINT32)n ) );
 #endif /* APG_USE_SHA */
@@ -30,6 +30,8 @@
 #ifndef APG_RND_H
 #define APG_RND_H	1
 
+#include <stddef.h>
+
 #ifndef APG_OWN_TYPES_H
 #include "owntypes.h"
 #endif /* OWN_TYPES_H */
@@ -46,6 +48,7 @@ extern UINT32 __rnd_seed[2];
 
 extern void x917_setseed (UINT32 seed, int quiet);
 extern UINT randint (int n);
+extern void rnd_wipe (void *p, size_t n);
 #ifndef APG_USE_SHA
 UINT32 x917cast_rnd (void);
 #else /* APG_USE_SHA */
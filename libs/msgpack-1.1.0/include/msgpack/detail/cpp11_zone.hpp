@@ -40,6 +40,43 @@ namespace msgpack {
 MSGPACK_API_VERSION_NAMESPACE(v1) {
 /// @endcond
 
+/// Allocator of zone chunks (the memory objects are unpacked to),
+/// replaceable e.g. to wipe chunks on release.
+struct zone_chunk_allocator {
+    void* (*m_allocate)(size_t size);
+    void (*m_deallocate)(void* p, size_t size);
+};
+
+namespace detail {
+
+inline void* zone_chunk_malloc(size_t size)
+{
+    return ::malloc(size);
+}
+
+inline void zone_chunk_free(void* p, size_t /*size*/)
+{
+    ::free(p);
+}
+
+} // namespace detail
+
+inline zone_chunk_allocator& get_zone_chunk_allocator()
+{
+    static zone_chunk_allocator allocator = {
+        &detail::zone_chunk_malloc, &detail::zone_chunk_free
+    };
+    return allocator;
+}
+
+/// Replaces the allocator of zone chunks, not thread-safe (call before
+/// zones are used concurrently). Chunks allocated before are released
+/// by the allocator that allocated them.
+inline void set_zone_chunk_allocator(zone_chunk_allocator const& allocator)
+{
+    get_zone_chunk_allocator() = allocator;
+}
+
 class zone {
 private:
     struct finalizer {
@@ -122,26 +159,40 @@ private:
     };
     struct chunk {
         chunk* m_next;
-    };
-    struct chunk_list {
-        chunk_list(size_t chunk_size)
+        size_t m_size;
+        void (*m_deallocate)(void* p, size_t size);
+        static chunk* create(size_t size)
         {
-            chunk* c = static_cast<chunk*>(::malloc(sizeof(chunk) + chunk_size));
+            zone_chunk_allocator const& a = get_zone_chunk_allocator();
+            chunk* c = static_cast<chunk*>(a.m_allocate(sizeof(chunk) + size));
             if(!c) {
                 throw std::bad_alloc();
             }
+            c->m_next = nullptr;
+            c->m_size = sizeof(chunk) + size;
+            c->m_deallocate = a.m_deallocate;
+            return c;
+        }
+        static void destroy(chunk* c)
+        {
+            c->m_deallocate(c, c->m_size);
+        }
+    };
+    struct chunk_list {
+        chunk_list(size_t chunk_size)
+        {
+            chunk* c = chunk::create(chunk_size);
 
             m_head = c;
             m_free = chunk_size;
             m_ptr  = reinterpret_cast<char*>(c) + sizeof(chunk);
-            c->m_next = nullptr;
         }
         ~chunk_list()
         {
             chunk* c = m_head;
             while(c) {
                 chunk* n = c->m_next;
-                ::free(c);
+                chunk::destroy(c);
                 c = n;
             }
         }
@@ -151,7 +202,7 @@ private:
             while(true) {
                 chunk* n = c->m_next;
                 if(n) {
-                    ::free(c);
+                    chunk::destroy(c);
                     c = n;
                 } else {
                     m_head = c;
@@ -290,8 +341,7 @@ inline void* zone::allocate_expand(size_t size)
         sz = tmp_sz;
     }
 
-    chunk* c = static_cast<chunk*>(::malloc(sizeof(chunk) + sz));
-    if (!c) throw std::bad_alloc();
+    chunk* c = chunk::create(sz);
 
     char* ptr = reinterpret_cast<char*>(c) + sizeof(chunk);
 
@@ -0,0 +1,63 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include "types.hpp"
+#include "sesame/utils/BloomFilter.hpp"
+
+
+/**
+ * Builds the breached password filter offline:
+ * sesame-bloom WORDLIST FILTER [RATE]
+ */
+int main( int argc, char** argv )
+{
+   if ( argc < 3 || argc > 4 )
+   {
+      std::cerr << "usage: " << argv[ 0 ] << " WORDLIST FILTER [RATE]" << std::endl;
+      return 1;
+   }
+
+   try
+   {
+      const double rate( argc == 4 ? std::atof( argv[ 3 ] ) : 0.0001 );
+      const uint64_t words( sesame::utils::BloomFilter::build( argv[ 1 ], argv[ 2 ], rate ) );
+
+      const sesame::utils::BloomFilter filter( argv[ 2 ] );
+      std::cout << "Wrote " << argv[ 2 ] << ": " << words << " words, " <<
+         filter.getBitCount() << " bits, " << filter.getHashCount() << " hashes." << std::endl;
+   }
+   catch ( std::runtime_error& e )
+   {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+   }
+
+   return 0;
+}
@@ -23,6 +23,7 @@
 ** input grammar file:
 */
 #include <cstdio>
+#include <cstring>
 /************ Begin %include sections from the grammar ************************/
 %%
 /**************** End of %include directives **********************************/
@@ -456,6 +457,36 @@ int ParseStackPeak(void *p){
 }
 #endif
 
+/*
+** Copy the state of the parser pSrc into the parser pDest.  Both
+** parsers must have been created by ParseAlloc().  Semantic values
+** on the stack are copied verbatim, so whatever they point to has to
+** outlive both parsers.  This allows to resume parsing from a saved
+** state instead of feeding all tokens again.
+**
+** Outputs:
+** 0 on success, 1 if the stack of pDest could not be grown.
+*/
+int ParseCopy(void *pDest, const void *pSrc){
+  yyParser *pDst = (yyParser*)pDest;
+  const yyParser *pOrig = (const yyParser*)pSrc;
+  int idx = (int)(pOrig->yytos - pOrig->yystack);
+#if YYSTACKDEPTH<=0
+  while( pDst->yystksz<=idx ){
+    if( yyGrowStack(pDst) ) return 1;
+  }
+#endif
+  memcpy(pDst->yystack, pOrig->yystack, (idx+1)*sizeof(yyStackEntry));
+  pDst->yytos = &pDst->yystack[idx];
+#ifdef YYTRACKMAXSTACKDEPTH
+  pDst->yyhwm = pOrig->yyhwm;
+#endif
+#ifndef YYNOERRORRECOVERY
+  pDst->yyerrcnt = pOrig->yyerrcnt;
+#endif
+  return 0;
+}
+
 /*
 ** Find the appropriate action for a parser given the terminal
 ** look-ahead token iLookAhead.
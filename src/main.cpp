@@ -23,7 +23,10 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -37,6 +40,9 @@
 
 #include "types.hpp"
 #include "sesame/Instance.hpp"
+#include "sesame/Session.hpp"
+#include "sesame/agent/Agent.hpp"
+#include "sesame/commands/EntryTask.hpp"
 #include "sesame/commands/HelpTask.hpp"
 #include "sesame/commands/InstanceTask.hpp"
 #include "sesame/utils/completion.hpp"
@@ -44,15 +50,26 @@
 #include "sesame/utils/resources.hpp"
 #include "sesame/utils/string.hpp"
 #include "sesame/utils/xselection.hpp"
+#include "sesame/utils/zone.hpp"
 #include "sesame/utils/Parser.hpp"
 #include "sesame/utils/ParseResult.hpp"
+#include "sesame/utils/Reader.hpp"
 #include "sesame/utils/TeclaReader.hpp"
 
+using sesame::Session;
+using sesame::agent::Agent;
+using sesame::commands::EntryTask;
 using sesame::commands::HelpTask;
 using sesame::commands::InstanceTask;
 
 String buildPrompt( std::shared_ptr<sesame::Instance>& instance );
 
+int runAgent( const String& path );
+
+int runQuery( int argc, char** argv );
+
+int runBatch( std::shared_ptr<sesame::Instance>& instance );
+
 std::vector<std::pair<std::string,std::string>> apgCache;
 
 bool stopRequested( false );
@@ -103,6 +120,9 @@ int main( int argc, char** argv)
                 << std::endl;
    }
 
+   // Deserialize into locked memory wiped on release.
+   sesame::utils::useSecureZones();
+
    // Handle signals.
    struct sigaction action;
    std::memset( &action, 0, sizeof( action ) );
@@ -116,26 +136,115 @@ int main( int argc, char** argv)
    // Set locale!
    sesame::utils::setLocale();
 
+   // Query agent? Keep output plain for scripts.
+   if ( argc > 2 && String( argv[ 1 ] ) == "--query" )
+   {
+      return runQuery( argc, argv );
+   }
+
+   // Parse options.
+   Vector<String> files;
+   std::unique_ptr<std::istream> scriptOwner;
+   std::istream* script( nullptr );
+   int passwordFd( -1 );
+   bool agent( false );
+   bool valid( true );
+
+   for ( int i = 1; i < argc && valid; ++i )
+   {
+      const String arg( argv[ i ] );
+
+      if ( arg == "--agent" && ! agent )
+      {
+         agent = true;
+      }
+      else if ( arg == "-c" && ! script && ( i + 1 ) < argc )
+      {
+         scriptOwner.reset( new StringStream( String( argv[ ++i ] ) ) );
+         script = scriptOwner.get();
+      }
+      else if ( arg == "-f" && ! script && ( i + 1 ) < argc )
+      {
+         const String path( argv[ ++i ] );
+         if ( path == "-" )
+         {
+            script = &std::cin;
+         }
+         else
+         {
+            scriptOwner.reset( new std::ifstream( path.c_str() ) );
+            script = scriptOwner.get();
+            if ( ! script->good() )
+            {
+               std::cerr << "ERROR: failed to open script" << std::endl;
+               return 1;
+            }
+         }
+      }
+      else if ( arg == "--password-fd" && passwordFd == -1 && ( i + 1 ) < argc )
+      {
+         const String fd( argv[ ++i ] );
+         valid = ( fd.find_first_not_of( "0123456789" ) == String::npos && fd.size() < 6 );
+         passwordFd = valid ? std::atoi( fd.c_str() ) : -1;
+      }
+      else if ( ! arg.empty() && arg[ 0 ] != '-' )
+      {
+         files.push_back( arg );
+      }
+      else
+      {
+         valid = false;
+      }
+   }
+   valid = valid && ! ( agent && ( script || files.size() != 1 ) );
+
+   // Password from fd is for scripts and the agent, interactive mode needs the terminal.
+   valid = valid && ! ( passwordFd >= 0 && ! script && ! agent );
+
    // Start.
    std::shared_ptr<sesame::Instance> instance;
 
-   // Print version info.
-   std::cout << sesame::VERSION_STRING << "\n" << std::endl;
+   // Print version info (not in batch mode).
+   if ( ! script )
+   {
+      std::cout << sesame::VERSION_STRING << "\n" << std::endl;
+   }
 
-   // More than one argument passed?
-   if ( argc > 2 )
+   // Invalid arguments passed?
+   if ( ! valid )
    {
       HelpTask task( HelpTask::USAGE, argv[ 0 ] );
       task.run( instance );
       return 1;
    }
-   // File passed?
-   // Abort immediately if opening the container fails.
-   else if ( argc == 2 )
+
+   // Read lines (and password) without terminal?
+   if ( script || ( agent && passwordFd >= 0 ) )
    {
       try
       {
-         InstanceTask task( InstanceTask::OPEN, argv[ 1 ] );
+         sesame::utils::Reader::setBatchMode( script ? *script : std::cin, passwordFd );
+      }
+      catch ( std::runtime_error& e )
+      {
+         std::cerr << "ERROR: " << e.what() << std::endl;
+         return 1;
+      }
+   }
+
+   // Run agent?
+   if ( agent )
+   {
+      return runAgent( files.front() );
+   }
+
+   // Files passed?
+   // Abort immediately if opening the containers fails.
+   if ( ! files.empty() )
+   {
+      try
+      {
+         InstanceTask task( InstanceTask::OPEN, files );
          task.run( instance );
       }
       catch ( std::runtime_error& e )
@@ -153,6 +262,12 @@ int main( int argc, char** argv)
       }
    }
 
+   // Run script?
+   if ( script )
+   {
+      return runBatch( instance );
+   }
+
    sesame::utils::TeclaReader reader( 1024, 2048 );
    reader.addCompletion( cpl_complete_sesame, static_cast<void*>( &instance ) );
    sesame::utils::Parser parser;
@@ -220,8 +335,10 @@ int main( int argc, char** argv)
       }
       else if ( normalized == "quit\n" )
       {
-         if ( instance )
+         // Close all instances, stop at the first one not closed.
+         while ( instance )
          {
+            const std::shared_ptr<sesame::Instance> current( instance );
             try
             {
                InstanceTask task( InstanceTask::CLOSE );
@@ -238,6 +355,11 @@ int main( int argc, char** argv)
                   std::cerr << "ERROR: " << e.what() << std::endl;;
                }
             }
+
+            if ( instance == current )
+            {
+               break;
+            }
          }
 
          // Quit only if no instance is open!
@@ -282,11 +404,12 @@ int main( int argc, char** argv)
    }
    while ( true );
 
-   // Make sure instance is closed before quit!
-   if ( instance )
+   // Make sure instances are closed before quit!
+   instance.reset();
+   while ( ! Session::getInstances().empty() )
    {
-      const String tmp( instance->getIdAsHexString() );
-      instance.reset();
+      const String tmp( Session::getInstances().back()->getIdAsHexString() );
+      Session::remove( Session::getInstances().back() );
       std::cout << "Closed container #" << tmp << "." << std::endl;
    }
 
@@ -304,9 +427,155 @@ String buildPrompt( std::shared_ptr<sesame::Instance>& instance )
    if ( instance )
    {
       StringStream s;
-      s << "sesame #" << std::hex << std::setw( 8 ) << std::setfill( '0' ) << instance->getId() << "> ";
+      s << "sesame #" << std::hex << std::setw( 8 ) << std::setfill( '0' ) << instance->getId();
+
+      // Several containers open? Show which one is current.
+      const Vector<std::shared_ptr<sesame::Instance>>& instances( Session::getInstances() );
+      if ( instances.size() > 1 )
+      {
+         const std::size_t pos( std::find( instances.begin(), instances.end(), instance ) - instances.begin() );
+         s << std::dec << " [" << ( pos + 1 ) << "/" << instances.size() << "]";
+      }
+      s << "> ";
       prompt = s.str();
    }
 
    return prompt;
 }
+
+int runAgent( const String& path )
+{
+   std::shared_ptr<sesame::Instance> instance;
+
+   try
+   {
+      // Keys to decrypt passwords/keys on request are kept, the password isn't.
+      InstanceTask task( InstanceTask::UNLOCK, path );
+      task.run( instance );
+
+      Agent agent( instance );
+      const String socketPath( Agent::getSocketPath() );
+
+      std::cout << "Serving container #" << instance->getIdAsHexString()
+                << " on " << socketPath << "." << std::endl;
+      agent.serve( socketPath, stopRequested );
+   }
+   catch ( std::exception& e )
+   {
+      if ( ! stopRequested )
+      {
+         std::cerr << "ERROR: " << e.what() << std::endl;
+      }
+      return 1;
+   }
+
+   instance.reset();
+   Session::clear();
+   std::cout << "Goodbye!" << std::endl;
+
+   return 0;
+}
+
+int runQuery( int argc, char** argv )
+{
+   try
+   {
+      Vector<String> request;
+      for ( int i = 2; i < argc; ++i )
+      {
+         request.push_back( argv[ i ] );
+      }
+
+      const Vector<String> response( Agent::query( Agent::getSocketPath(), request ) );
+      if ( response.empty() || response[ 0 ] != "ok" )
+      {
+         throw std::runtime_error( response.size() > 1 ? response[ 1 ].c_str() : "invalid response" );
+      }
+
+      for ( std::size_t i = 1; i < response.size(); ++i )
+      {
+         std::cout << response[ i ] << "\n";
+      }
+      std::cout.flush();
+   }
+   catch ( std::exception& e )
+   {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 1;
+   }
+
+   return 0;
+}
+
+int runBatch( std::shared_ptr<sesame::Instance>& instance )
+{
+   sesame::utils::Reader reader( 1024 );
+   sesame::utils::Parser parser;
+   sesame::utils::ParseResult parseResult;
+   std::size_t lineNumber( 0 );
+   int rc( 0 );
+
+   // Run commands (and read their input) line by line, stop on first failure.
+   while ( ! stopRequested && rc == 0 )
+   {
+      String line;
+      try
+      {
+         line = reader.readLine();
+         lineNumber = sesame::utils::Reader::getLineNumber();
+      }
+      catch ( std::runtime_error& )
+      {
+         // End of script.
+         break;
+      }
+
+      // Skip empty lines and comments.
+      line = sesame::utils::strip( line );
+      if ( line.empty() || line[ 0 ] == '#' )
+      {
+         continue;
+      }
+      else if ( line == "quit" )
+      {
+         break;
+      }
+
+      // Refer to the entry added last by "#." (as a whole word only).
+      String::size_type hit( 0 );
+      while ( ( hit = line.find( "#.", hit ) ) != String::npos )
+      {
+         if ( ( hit == 0 || line[ hit - 1 ] == ' ' ) &&
+              ( hit + 2 == line.size() || line[ hit + 2 ] == ' ' ) )
+         {
+            line.replace( hit + 1, 1, EntryTask::getLastAddedId() );
+         }
+         ++hit;
+      }
+
+      parseResult = parser.parse( line + "\n" );
+      if ( ! parseResult.isValid() || parseResult.getCommand() == nullptr )
+      {
+         std::cerr << "ERROR: invalid command in line " << lineNumber << std::endl;
+         rc = 1;
+         break;
+      }
+
+      try
+      {
+         parseResult.getCommand()->run( instance );
+      }
+      catch ( std::exception& e )
+      {
+         std::cerr << "ERROR: " << e.what() << " in line " << lineNumber << std::endl;
+         rc = 1;
+      }
+   }
+
+   // Unwritten changes are discarded.
+   instance.reset();
+   Session::clear();
+   sesame::utils::xdeselect();
+
+   return ( stopRequested ? 1 : rc );
+}
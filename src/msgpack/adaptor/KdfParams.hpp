@@ -0,0 +1,144 @@
+//
+// MessagePack for C++ static resolution routine
+//
+// Copyright (C) 2008-2015 FURUHASHI Sadayuki
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+#ifndef MSGPACK_TYPE_SESAME_KDFPARAMS_HPP
+#define MSGPACK_TYPE_SESAME_KDFPARAMS_HPP
+
+#include <cstring>
+
+#include "types.hpp"
+#include "msgpack/versioning.hpp"
+#include "msgpack/adaptor/adaptor_base.hpp"
+#include "msgpack/adaptor/Vector_uint8.hpp"
+#include "msgpack/sbuffer.hpp"
+#include "msgpack/unpack.hpp"
+#include "sesame/crypto/KdfParams.hpp"
+
+namespace msgpack {
+
+/// @cond
+MSGPACK_API_VERSION_NAMESPACE(v1) {
+/// @endcond
+
+namespace adaptor {
+
+namespace detail {
+
+// Params are packed as a map of names to packed values
+// (formerly Map<String,Vector<uint8_t>>), names are ASCII,
+// so no transcoding is required.
+
+inline bool kdf_params_name_is(msgpack::object const& o, const char* name) {
+    const std::size_t size = std::strlen(name);
+    return o.type == msgpack::type::STR && o.via.str.size == size &&
+        std::memcmp(o.via.str.ptr, name, size) == 0;
+}
+
+inline bool kdf_params_reference(msgpack::type::object_type, std::size_t, void*) {
+    return true;
+}
+
+template <typename T>
+inline void kdf_params_unpack_value(msgpack::object const& o, T& v) {
+    if (o.type != msgpack::type::BIN) {
+        throw msgpack::type_error();
+    }
+    msgpack::unpacked result;
+    std::size_t offset = 0;
+    msgpack::unpack(&result, o.via.bin.ptr, o.via.bin.size, &offset, nullptr, &kdf_params_reference);
+    if (offset != o.via.bin.size) {
+        throw msgpack::type_error();
+    }
+    v = result.get().as<T>();
+}
+
+template <typename Stream, typename T>
+inline void kdf_params_pack_entry(msgpack::packer<Stream>& o, const char* name, const T& v) {
+    msgpack::sbuffer value;
+    msgpack::pack(value, v);
+    const uint32_t size = static_cast<uint32_t>(std::strlen(name));
+    o.pack_str(size);
+    o.pack_str_body(name, size);
+    o.pack_bin(static_cast<uint32_t>(value.size()));
+    o.pack_bin_body(value.data(), static_cast<uint32_t>(value.size()));
+}
+
+} // namespace detail
+
+template <>
+struct convert<sesame::crypto::KdfParams> {
+    msgpack::object const& operator()(msgpack::object const& o, sesame::crypto::KdfParams& v) const {
+        if (o.type != msgpack::type::MAP) {
+            throw msgpack::type_error();
+        }
+        v = sesame::crypto::KdfParams();
+        for (uint32_t i = 0; i < o.via.map.size; ++i) {
+            msgpack::object const& key = o.via.map.ptr[i].key;
+            msgpack::object const& value = o.via.map.ptr[i].val;
+            if (detail::kdf_params_name_is(key, "ldN")) {
+                detail::kdf_params_unpack_value(value, v.m_LdN);
+            }
+            else if (detail::kdf_params_name_is(key, "p")) {
+                detail::kdf_params_unpack_value(value, v.m_P);
+            }
+            else if (detail::kdf_params_name_is(key, "r")) {
+                detail::kdf_params_unpack_value(value, v.m_R);
+            }
+            else if (detail::kdf_params_name_is(key, "salt")) {
+                detail::kdf_params_unpack_value(value, v.m_Salt);
+            }
+            else {
+                throw msgpack::type_error();
+            }
+        }
+        return o;
+    }
+};
+
+template <>
+struct pack<sesame::crypto::KdfParams> {
+    template <typename Stream>
+    msgpack::packer<Stream>& operator()(msgpack::packer<Stream>& o, const sesame::crypto::KdfParams& v) const {
+        // Unset params are omitted, set ones are ordered by name (like std::map did).
+        const uint32_t size =
+            (v.m_LdN ? 1 : 0) + (v.m_P ? 1 : 0) + (v.m_R ? 1 : 0) + (v.m_Salt.empty() ? 0 : 1);
+        o.pack_map(size);
+        if (v.m_LdN) {
+            detail::kdf_params_pack_entry(o, "ldN", v.m_LdN);
+        }
+        if (v.m_P) {
+            detail::kdf_params_pack_entry(o, "p", v.m_P);
+        }
+        if (v.m_R) {
+            detail::kdf_params_pack_entry(o, "r", v.m_R);
+        }
+        if (!v.m_Salt.empty()) {
+            detail::kdf_params_pack_entry(o, "salt", v.m_Salt);
+        }
+        return o;
+    }
+};
+
+} // namespace adaptor
+
+/// @cond
+} // MSGPACK_API_VERSION_NAMESPACE(v1)
+/// @endcond
+
+} // namespace msgpack
+
+#endif // MSGPACK_TYPE_SESAME_KDFPARAMS_HPP
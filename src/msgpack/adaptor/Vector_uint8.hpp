@@ -37,12 +37,12 @@ struct convert<Vector<uint8_t> > {
     msgpack::object const& operator()(msgpack::object const& o, Vector<uint8_t>& v) const {
         switch (o.type) {
         case msgpack::type::BIN:
-            v.resize(o.via.bin.size);
-            std::memcpy(&v.front(), o.via.bin.ptr, o.via.bin.size);
+            v.assign(reinterpret_cast<const uint8_t*>(o.via.bin.ptr),
+                     reinterpret_cast<const uint8_t*>(o.via.bin.ptr) + o.via.bin.size);
             break;
         case msgpack::type::STR:
-            v.resize(o.via.str.size);
-            std::memcpy(&v.front(), o.via.str.ptr, o.via.str.size);
+            v.assign(reinterpret_cast<const uint8_t*>(o.via.str.ptr),
+                     reinterpret_cast<const uint8_t*>(o.via.str.ptr) + o.via.str.size);
             break;
         default:
             throw msgpack::type_error();
@@ -58,7 +58,7 @@ struct pack<Vector<uint8_t> > {
     msgpack::packer<Stream>& operator()(msgpack::packer<Stream>& o, const Vector<uint8_t>& v) const {
         uint32_t size = checked_get_container_size(v.size());
         o.pack_bin(size);
-        o.pack_bin_body(reinterpret_cast<const char*>(&v.front()), size);
+        o.pack_bin_body(reinterpret_cast<const char*>(v.data()), size);
 
         return o;
     }
@@ -69,7 +69,7 @@ struct object<Vector<uint8_t> > {
     void operator()(msgpack::object& o, const Vector<uint8_t>& v) const {
         uint32_t size = checked_get_container_size(v.size());
         o.type = msgpack::type::BIN;
-        o.via.bin.ptr = reinterpret_cast<const char*>(&v.front());
+        o.via.bin.ptr = reinterpret_cast<const char*>(v.data());
         o.via.bin.size = size;
     }
 };
@@ -82,7 +82,7 @@ struct object_with_zone<Vector<uint8_t> > {
         char* ptr = static_cast<char*>(o.zone.allocate_align(size));
         o.via.bin.ptr = ptr;
         o.via.bin.size = size;
-        std::memcpy(ptr, &v.front(), size);
+        std::memcpy(ptr, v.data(), size);
     }
 };
 
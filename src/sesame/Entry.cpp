@@ -39,7 +39,8 @@ namespace sesame
       m_InstanceId( 0 ),
       m_CreatedAt( system_clock::to_time_t( system_clock::now() ) ),
       m_UpdatedAt( m_CreatedAt ),
-      m_Name()
+      m_Name(),
+      m_Loaded( true )
    {
    }
 
@@ -48,7 +49,8 @@ namespace sesame
       m_InstanceId( 0 ),
       m_CreatedAt( system_clock::to_time_t( system_clock::now() ) ),
       m_UpdatedAt( m_CreatedAt ),
-      m_Name( name )
+      m_Name( name ),
+      m_Loaded( true )
    {
    }
 
@@ -64,6 +66,11 @@ namespace sesame
       return s.str();
    }
 
+   bool Entry::isLoaded() const
+   {
+      return m_Loaded;
+   }
+
    String Entry::getName() const
    {
       return m_Name;
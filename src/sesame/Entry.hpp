@@ -89,6 +89,15 @@ namespace sesame
           */
          String getIdAsHexString() const;
 
+         /**
+          * Returns <tt>true</tt> if the entry is loaded completely.
+          * Entries taken from the index of a container only provide
+          * id, name, tags and timestamps.
+          *
+          * @return <tt>true</tt> if the entry is loaded completely
+          */
+         bool isLoaded() const;
+
          /**
           * Returns the name of the entry.
           *
@@ -291,6 +300,9 @@ namespace sesame
          /** tags for lookup */
          Set<String> m_Tags;
 
+         /** <tt>false</tt> if attributes and labeled data weren't loaded (not serialized) */
+         bool m_Loaded;
+
       // (de)serialization
       public:
          MSGPACK_DEFINE( \
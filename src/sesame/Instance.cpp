@@ -27,51 +27,103 @@
 #include <iomanip>
 #include <memory>
 #include <random>
+#include <regex>
 #include <stdexcept>
 
 #include "sesame/crypto/MachineFactory.hpp"
 #include "sesame/definitions.hpp"
 #include "sesame/Instance.hpp"
 #include "sesame/packaging.hpp"
+#include "sesame/utils/compression.hpp"
+#include "sesame/utils/filesystem.hpp"
+#include "sesame/utils/parallel.hpp"
 #include "sesame/utils/string.hpp"
 #include "sesame/version.hpp"
 
+namespace
+{
+   // Below, threads cost more than they save.
+   const std::size_t MIN_ENTRIES_PER_WORKER( 64 );
+}
 
 namespace sesame
 {
-   void Instance::parse( std::istream& stream )
+   crypto::KdfParams Instance::parse( std::istream& stream )
    {
       uint32_t majorVersion;
       unpack( stream, majorVersion );
+      if ( majorVersion > VERSION_MAJOR )
+      {
+         throw std::runtime_error( "incompatible major version" );
+      }
       Protocol protocol;
       unpack( stream, protocol );
-      Map<String,Vector<uint8_t>> params1;
+      crypto::KdfParams params1;
       unpack( stream, params1 );
-      Map<String,Vector<uint8_t>> params2;
+      crypto::KdfParams params2;
       unpack( stream, params2 );
+      if ( majorVersion == FORMAT_V1 )
+      {
+         uint32_t compression;
+         unpack( stream, compression );
+      }
       Vector<uint8_t> ciphertext;
       unpack( stream, ciphertext );
+      if ( majorVersion == FORMAT_V1 )
+      {
+         Vector<uint8_t> chunks;
+         unpack( stream, chunks );
+      }
       Vector<uint8_t> hmac;
       unpack( stream, hmac );
       Vector<uint8_t> digest;
       unpack( stream, digest );
+
+      // Reject unknown protocols before a password is read. This also
+      // sets up the crypto machine before instances are built concurrently.
+      if ( protocol == PROTOCOL_UNKNOWN )
+      {
+         throw std::runtime_error( "unknown protocol" );
+      }
+      if ( ! getCryptoMachine( protocol ).getKeyDerivationParams( params1 ) )
+      {
+         throw std::runtime_error( "failed to get key derivation params" );
+      }
+
+      return params1;
    }
 
    Instance::Instance() :
       m_Id( std::random_device()() ),
-      m_Protocol( PROTOCOL_UNKNOWN )
+      m_Protocol( PROTOCOL_UNKNOWN ),
+      m_Format( static_cast<Format>( VERSION_MAJOR ) ),
+      m_Compression( COMPRESSION_NONE ),
+      m_StoredFormat( static_cast<Format>( VERSION_MAJOR ) ),
+      m_StoredCompression( COMPRESSION_NONE ),
+      m_Size( 0 ),
+      m_PackedSize( 0 ),
+      m_Journaled( false ),
+      m_Revision( ++revisions )
    {
    }
 
    Instance::Instance(
       const Protocol protocol,
-      const Map<String,Vector<uint8_t>>& params1,
-      const Map<String,Vector<uint8_t>>& params2
+      const crypto::KdfParams& params1,
+      const crypto::KdfParams& params2
       ) :
       m_Id( std::random_device()() ),
       m_Protocol( protocol ),
       m_Params1( params1 ),
-      m_Params2( params2 )
+      m_Params2( params2 ),
+      m_Format( static_cast<Format>( VERSION_MAJOR ) ),
+      m_Compression( COMPRESSION_NONE ),
+      m_StoredFormat( static_cast<Format>( VERSION_MAJOR ) ),
+      m_StoredCompression( COMPRESSION_NONE ),
+      m_Size( 0 ),
+      m_PackedSize( 0 ),
+      m_Journaled( false ),
+      m_Revision( ++revisions )
    {
       throwIfProtocolIsUnknown( m_Protocol );
 
@@ -81,19 +133,47 @@ namespace sesame
       {
          throw std::runtime_error( "failed to get key derivation params" );
       }
-
-      recalcInitialDigest();
    }
 
-   Instance::Instance( std::istream& stream, const String& password )
+   Instance::Instance( std::istream& stream, const String& password ) :
+      m_Format( static_cast<Format>( VERSION_MAJOR ) ),
+      m_Compression( COMPRESSION_NONE ),
+      m_StoredFormat( static_cast<Format>( VERSION_MAJOR ) ),
+      m_StoredCompression( COMPRESSION_NONE ),
+      m_Size( 0 ),
+      m_PackedSize( 0 ),
+      m_Journaled( false ),
+      m_Revision( ++revisions )
    {
       uint32_t majorVersion;
       unpack( stream, majorVersion );
+      if ( majorVersion > VERSION_MAJOR )
+      {
+         throw std::runtime_error( "incompatible major version" );
+      }
       unpack( stream, m_Protocol );
       unpack( stream, m_Params1 );
       unpack( stream, m_Params2 );
+      // Compression (v1).
+      if ( majorVersion == FORMAT_V1 )
+      {
+         uint32_t compression;
+         unpack( stream, compression );
+         if ( compression > COMPRESSION_DEFLATE )
+         {
+            throw std::runtime_error( "unknown compression" );
+         }
+         m_Compression = static_cast<Compression>( compression );
+      }
+      // All entries (v0) or index (v1).
       Vector<uint8_t> ciphertext;
       unpack( stream, ciphertext );
+      // Separately encrypted entries (v1).
+      Vector<uint8_t> chunks;
+      if ( majorVersion == FORMAT_V1 )
+      {
+         unpack( stream, chunks );
+      }
       std::streamsize hmacCheck( stream.tellg() );
       Vector<uint8_t> hmac;
       unpack( stream, hmac );
@@ -122,6 +202,7 @@ namespace sesame
       {
          stream.seekg( end, std::ios_base::beg );
       }
+      const std::streamsize snapshotEnd( stream.tellg() );
 
       Vector<uint8_t> calculatedDigest;
       if ( ! getCryptoMachine().calcDigest( data, calculatedDigest ) )
@@ -134,18 +215,11 @@ namespace sesame
       }
 
       // Some checks.
-      if ( majorVersion != 0 )
-      {
-         throw std::runtime_error( "incompatible major version" );
-      }
       throwIfProtocolIsUnknown( m_Protocol );
 
       // Calc key.
       Vector<uint8_t> key1;
-      if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params1, key1 ) )
-      {
-         throw std::runtime_error( "key derivation failed" );
-      }
+      deriveKey( password, Key::FIRST, key1 );
 
       // Authenticity check.
       Vector<uint8_t> calculatedHmac;
@@ -165,10 +239,57 @@ namespace sesame
          throw std::runtime_error( "decryption failed" );
       }
 
+      if ( m_Compression == COMPRESSION_DEFLATE )
+      {
+         Vector<uint8_t> compressed;
+         compressed.swap( plaintext );
+         utils::decompress( compressed.data(), compressed.size(), plaintext );
+      }
+
       // Deserialize.
       StringStream tmp( String( reinterpret_cast<char*>( plaintext.data() ), plaintext.size() ) );
       Instance instance;
-      tmp >> instance;
+      if ( majorVersion == FORMAT_V0 )
+      {
+         tmp >> instance;
+      }
+      else
+      {
+         unpack( tmp, instance.m_Id );
+         unpack( tmp, instance.m_Hmac1 );
+         unpack( tmp, instance.m_Hmac2 );
+         unpack( tmp, instance.m_Protocol );
+         unpack( tmp, instance.m_Params1 );
+         unpack( tmp, instance.m_Params2 );
+         Map<uint32_t,IndexRecord> index;
+         unpack( tmp, index );
+
+         // Entries are loaded on first access.
+         for ( const auto& record : index )
+         {
+            const IndexRecord& r( record.second );
+            if ( r.m_Offset + r.m_Length > chunks.size() )
+            {
+               throw std::runtime_error( "invalid index" );
+            }
+
+            Entry entry;
+            entry.m_Id = r.m_Id;
+            entry.m_InstanceId = instance.m_Id;
+            entry.m_CreatedAt = r.m_CreatedAt;
+            entry.m_UpdatedAt = r.m_UpdatedAt;
+            entry.m_Name = r.m_Name;
+            entry.m_Tags = r.m_Tags;
+            entry.m_Loaded = false;
+            instance.m_Entries.insert( entry );
+            instance.m_Chunks[ r.m_Id ] = Chunk{ r.m_Offset, r.m_Length };
+         }
+         instance.m_ChunkData.swap( chunks );
+      }
+      instance.m_Format = static_cast<Format>( majorVersion );
+      instance.m_Compression = m_Compression;
+      instance.m_StoredFormat = instance.m_Format;
+      instance.m_StoredCompression = m_Compression;
 
       // Check.
       if ( instance.m_Protocol != m_Protocol )
@@ -187,16 +308,17 @@ namespace sesame
       // Reset m_Dirty of data as default ctor was used for deserialization.
       for ( auto& entry : instance.m_Entries )
       {
-         for ( auto& date : entry.m_LabeledData )
-         {
-            const_cast<Data&>( date.second ).m_Dirty = false;
-         }
+         markClean( entry );
       }
 
-      instance.recalcInitialDigest();
-
       // Now replace current instance with deserialized.
       *this = instance;
+
+      // Remember key and apply journal, if any.
+      cacheKey( password, Key::FIRST, key1 );
+      m_JournalHead = digest;
+      m_Size = snapshotEnd;
+      readJournal( stream, key1 );
    }
 
    bool Instance::isNew() const
@@ -214,6 +336,26 @@ namespace sesame
       return m_Protocol;
    }
 
+   Format Instance::getFormat() const
+   {
+      return m_Format;
+   }
+
+   void Instance::setFormat( const Format format )
+   {
+      m_Format = format;
+   }
+
+   Compression Instance::getCompression() const
+   {
+      return m_Compression;
+   }
+
+   void Instance::setCompression( const Compression compression )
+   {
+      m_Compression = compression;
+   }
+
    uint32_t Instance::getId()
    {
       return m_Id;
@@ -255,6 +397,14 @@ namespace sesame
    }
 
    Set<Entry> Instance::getEntries( const Set<String>& tags ) const
+   {
+      Set<Entry> entries( getIndex( tags ) );
+      load( entries );
+
+      return entries;
+   }
+
+   Set<Entry> Instance::getIndex( const Set<String>& tags ) const
    {
       if ( tags.empty() )
       {
@@ -298,6 +448,14 @@ namespace sesame
    }
 
    Set<Entry> Instance::getUntaggedEntries() const
+   {
+      Set<Entry> entries( getUntaggedIndex() );
+      load( entries );
+
+      return entries;
+   }
+
+   Set<Entry> Instance::getUntaggedIndex() const
    {
       Set<Entry> entries;
 
@@ -344,6 +502,14 @@ namespace sesame
    }
 
    Set<Entry> Instance::findEntries( const String& hexId ) const
+   {
+      Set<Entry> entries( findIndex( hexId ) );
+      load( entries );
+
+      return entries;
+   }
+
+   Set<Entry> Instance::findIndex( const String& hexId ) const
    {
       // Adjust id.
       String s( hexId );
@@ -358,8 +524,7 @@ namespace sesame
       }
 
       Set<Entry> result;
-      Set<Entry> entries( getEntries() );
-      for ( auto& entry : entries )
+      for ( auto& entry : m_Entries )
       {
          StringStream id;
          id << std::hex << std::setw( 8 ) << std::setfill( '0' ) << entry.getId();
@@ -372,16 +537,52 @@ namespace sesame
       return result;
    }
 
-   void Instance::decryptEntry( Entry& entry, const String& password )
+   Set<Entry> Instance::searchIndex( const String& pattern ) const
    {
-      Vector<uint8_t> key;
+      std::regex regex;
+      try
+      {
+         regex.assign(
+            pattern.begin(), pattern.end(),
+            std::regex::extended | std::regex::icase | std::regex::nosubs
+            );
+      }
+      catch ( std::regex_error& )
+      {
+         throw std::runtime_error( "invalid pattern" );
+      }
 
-      if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params2, key ) )
+      Set<Entry> result;
+      for ( auto& entry : m_Entries )
       {
-         throw std::runtime_error( "key derivation failed" );
+         const String name( entry.getName() );
+         bool match( std::regex_search( name.begin(), name.end(), regex ) );
+
+         for ( auto& tag : entry.getTags() )
+         {
+            if ( match )
+            {
+               break;
+            }
+            match = std::regex_search( tag.begin(), tag.end(), regex );
+         }
+
+         if ( match )
+         {
+            result.insert( entry );
+         }
       }
 
+      return result;
+   }
+
+   void Instance::decryptEntry( Entry& entry, const String& password )
+   {
+      Vector<uint8_t> key;
+      deriveKey( password, Key::SECOND, key );
+
       decryptEntry( entry, key );
+      cacheKey( password, Key::SECOND, key );
    }
 
    void Instance::decryptEntry( Entry& entry, const Vector<uint8_t>& key )
@@ -396,33 +597,77 @@ namespace sesame
    void Instance::decryptEntries( const String& password )
    {
       Vector<uint8_t> key;
-
-      if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params2, key ) )
-      {
-         throw std::runtime_error( "key derivation failed" );
-      }
+      deriveKey( password, Key::SECOND, key );
 
       decryptEntries( key );
+      cacheKey( password, Key::SECOND, key );
    }
 
    void Instance::decryptEntries( const Vector<uint8_t>& key )
    {
+      loadAll();
+
+      // Check (and use) key and machine before workers share them.
+      getCryptoMachine();
+      if ( ! isKeyValid( key, Key::SECOND ) )
+      {
+         throw std::runtime_error( "key is invalid" );
+      }
+
+      Vector<Entry*> entries;
       for ( auto& entry : m_Entries )
       {
-         decryptEntry( const_cast<Entry&>( entry ), key );
+         entries.push_back( const_cast<Entry*>( &entry ) );
       }
+
+      utils::runParallel(
+         entries,
+         [ & ]( Entry* entry ) { decryptEntry( *entry, key ); },
+         MIN_ENTRIES_PER_WORKER );
    }
 
    void Instance::decryptData( Data& data, const String& password )
    {
       Vector<uint8_t> key;
+      deriveKey( password, Key::SECOND, key );
 
-      if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params2, key ) )
+      decryptData( data, key );
+      cacheKey( password, Key::SECOND, key );
+   }
+
+   void Instance::decryptData( Data& data )
+   {
+      if ( ! isUnlocked() )
       {
-         throw std::runtime_error( "key derivation failed" );
+         throw std::runtime_error( "container is locked" );
       }
 
-      decryptData( data, key );
+      decryptData( data, m_Key2 );
+   }
+
+   void Instance::unlock( const String& password )
+   {
+      Vector<uint8_t> key;
+
+      // First key is cached on open, so checking it is cheap.
+      deriveKey( password, Key::FIRST, key );
+      if ( ! isKeyValid( key, Key::FIRST ) )
+      {
+         throw std::runtime_error( "key is invalid" );
+      }
+      cacheKey( password, Key::FIRST, key );
+
+      deriveKey( password, Key::SECOND, key );
+      if ( ! isKeyValid( key, Key::SECOND ) )
+      {
+         throw std::runtime_error( "key is invalid" );
+      }
+      cacheKey( password, Key::SECOND, key );
+   }
+
+   bool Instance::isUnlocked() const
+   {
+      return ( ! m_Key2.empty() );
    }
 
    void Instance::decryptData( Data& data, const Vector<uint8_t>& key )
@@ -497,23 +742,11 @@ namespace sesame
          // Entry is new.
          entry.reconfigure( m_Id );
          m_Entries.insert( entry );
+         recordChange( entry, Change::ENTRY_ADDED );
          return true;
       }
    }
 
-   const Vector<uint8_t> Instance::calcDigest() const
-   {
-      Vector<uint8_t> data;
-      Vector<uint8_t> digest;
-      packV( data, *this );
-      if ( ! getCryptoMachine().calcDigest( data, digest ) )
-      {
-         throw std::runtime_error( "calculating digest of sesame failed" );
-      }
-
-      return digest;
-   }
-
    void Instance::calcHmac( uint32_t value, const Vector<uint8_t>& key, Vector<uint8_t>& hmac ) const
    {
       Vector<uint8_t> v;
@@ -606,18 +839,47 @@ namespace sesame
       }
    }
 
+   void Instance::encryptEntries( const String& password )
+   {
+      Vector<uint8_t> key;
+      deriveKey( password, Key::SECOND, key );
+
+      encryptEntries( key );
+      cacheKey( password, Key::SECOND, key );
+   }
+
    void Instance::encryptEntries( const Vector<uint8_t>& key )
    {
+      // Check (and use) key and machine before workers share them.
+      getCryptoMachine();
+      if ( ! isKeyValid( key, Key::SECOND ) )
+      {
+         throw std::runtime_error( "key is invalid" );
+      }
+
+      Vector<Entry*> entries;
       for ( auto& entry : m_Entries )
       {
-         encryptEntry( const_cast<Entry&>( entry ), key );
+         for ( auto& data : entry.m_LabeledData )
+         {
+            if ( data.second.isDirty() )
+            {
+               entries.push_back( const_cast<Entry*>( &entry ) );
+               break;
+            }
+         }
       }
+
+      utils::runParallel(
+         entries,
+         [ & ]( Entry* entry ) { encryptEntry( *entry, key ); },
+         MIN_ENTRIES_PER_WORKER );
    }
 
 
    bool Instance::updateEntry( const Entry& entry )
    {
-      if ( entry.m_InstanceId != m_Id )
+      if ( entry.m_InstanceId != m_Id || ! entry.isLoaded() )
       {
          return false;
       }
@@ -635,6 +897,7 @@ namespace sesame
          // Replace original entry with new one.
          m_Entries.erase( it );
          m_Entries.insert( entry );
+         recordChange( entry, Change::ENTRY_UPDATED );
          return true;
       }
    }
@@ -658,18 +921,20 @@ namespace sesame
       {
          // Delete entry.
          m_Entries.erase( it );
+         m_Chunks.erase( entry.getId() );
+         recordChange( entry, Change::ENTRY_DELETED );
          entry.clear();
          return true;
       }
    }
 
-   void Instance::recalcInitialDigest()
-   {
-      m_InitialDigest = calcDigest();
-   }
-
    bool Instance::isPlain() const
    {
+      if ( ! m_Chunks.empty() )
+      {
+         return false;
+      }
+
       for ( const auto& entry : m_Entries )
       {
          if ( ! entry.isPlain() )
@@ -683,8 +948,8 @@ namespace sesame
 
    bool Instance::isDirty() const
    {
-      // 1. compare digests
-      if ( m_InitialDigest != calcDigest() )
+      // 1. entries added, updated or deleted (or layout changed) since written or read last
+      if ( ! m_Changes.empty() || isLayoutChanged() )
       {
          return true;
       }
@@ -712,102 +977,638 @@ namespace sesame
    {
       // 1. Derive and check first key.
       Vector<uint8_t> key1;
-      if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params1, key1 ) )
-      {
-         throw std::runtime_error( "key derivation failed" );
-      }
+      deriveKey( password, Key::FIRST, key1 );
 
       if ( ! isKeyValid( key1, Key::FIRST ) )
       {
          throw std::runtime_error( "key is invalid" );
       }
+      cacheKey( password, Key::FIRST, key1 );
 
       // 2. Encrypt all entries with second key.
       if ( isDirty() )
       {
          Vector<uint8_t> key2;
-         if ( ! getCryptoMachine().deriveKey( utils::toUtf8( password ), m_Params2, key2 ) )
-         {
-            throw std::runtime_error( "key derivation failed" );
-         }
+         deriveKey( password, Key::SECOND, key2 );
 
          if ( ! isKeyValid( key2, Key::SECOND ) )
          {
             throw std::runtime_error( "key is invalid" );
          }
+         cacheKey( password, Key::SECOND, key2 );
 
          encryptEntries( key2 );
       }
 
-      // 3. Pack and write meta data.
-      StringStream data;
+      // 3. Pack and write meta data (into a buffer sized like the last container).
+      Vector<uint8_t> data;
+      data.reserve( m_Size );
 
-      // sesame major version
-      pack( data, VERSION_MAJOR );
+      // sesame major version (format)
+      appendV( data, static_cast<uint32_t>( m_Format ) );
 
       // protocol
-      pack( data, static_cast<int32_t>( m_Protocol ) );
+      appendV( data, static_cast<int32_t>( m_Protocol ) );
 
       // derivation params
-      pack( data, m_Params1 );
+      appendV( data, m_Params1 );
 
       // derivation params
-      pack( data, m_Params2 );
+      appendV( data, m_Params2 );
+
+      // compression (v1)
+      if ( m_Format == FORMAT_V1 )
+      {
+         appendV( data, static_cast<uint32_t>( m_Compression ) );
+      }
 
       // 4. Serialize and encrypt.
-      Vector<uint8_t> ciphertext;
+      if ( m_Format == FORMAT_V0 )
       {
-         Vector<uint8_t> serialized;
+         loadAll();
+
+         Vector<uint8_t> ciphertext;
          {
-            StringStream tmp;
-            tmp << *this;
-            readIntoVector( tmp, serialized );
-         }
+            Vector<uint8_t> serialized;
+            packV( serialized, *this, m_PackedSize );
 
-         if ( ! getCryptoMachine().encrypt( serialized, key1, ciphertext ) )
+            if ( ! getCryptoMachine().encrypt( serialized, key1, ciphertext ) )
+            {
+               throw std::runtime_error( "encryption failed" );
+            }
+         }
+         appendV( data, ciphertext );
+      }
+      else
+      {
+         // Chunks not loaded have to be recompressed.
+         if ( m_Compression != m_StoredCompression )
          {
-            throw std::runtime_error( "encryption failed" );
+            loadAll();
          }
+         packChunks( data, key1 );
       }
-      pack( data, ciphertext );
 
       // 5. Calc HMAC of data and append.
       Vector<uint8_t> hmac;
+      if ( ! getCryptoMachine().calcHmac( data, key1, hmac ) )
+      {
+         throw std::runtime_error( "failed to calculate HMAC" );
+      }
+      appendV( data, hmac );
+
+      // 6. Calc digest and append.
+      Vector<uint8_t> digest;
+      if ( ! getCryptoMachine().calcDigest( data, digest ) )
+      {
+         throw std::runtime_error( "failed to calculate digest" );
+      }
+      appendV( data, digest );
+
+      // 7. Write to file (at once).
+      stream.write( reinterpret_cast<const char*>( data.data() ), data.size() );
+      m_Size = data.size();
+
+      // Remember saved changes, a journal starts from the new snapshot.
+      m_StoredFormat = m_Format;
+      m_StoredCompression = ( m_Format == FORMAT_V1 ? m_Compression : COMPRESSION_NONE );
+      m_JournalHead = digest;
+      m_Changes.clear();
+   }
+
+   bool Instance::isJournaled() const
+   {
+      return m_Journaled;
+   }
+
+   void Instance::setJournaled( const bool journaled )
+   {
+      m_Journaled = journaled;
+   }
+
+   std::size_t Instance::getNumOfChanges() const
+   {
+      return m_Changes.size();
+   }
+
+   uint64_t Instance::getRevision() const
+   {
+      return m_Revision;
+   }
+
+   std::size_t Instance::getSize() const
+   {
+      return m_Size;
+   }
+
+   bool Instance::isLayoutChanged() const
+   {
+      const Compression compression( m_Format == FORMAT_V1 ? m_Compression : COMPRESSION_NONE );
+
+      return ( m_Format != m_StoredFormat || compression != m_StoredCompression );
+   }
+
+   bool Instance::isStoredIn( std::istream& stream ) const
+   {
+      if ( m_JournalHead.empty() )
+      {
+         return false;
+      }
+
+      stream.seekg( 0, std::ios_base::end );
+      const std::streamsize size( stream.tellg() );
+      if ( size < 0 || static_cast<std::size_t>( size ) != m_Size )
+      {
+         return false;
+      }
+
+      // Last object of container has to be the head of the journal.
+      Vector<uint8_t> expected;
+      packV( expected, m_JournalHead );
+      if ( expected.size() > m_Size )
+      {
+         return false;
+      }
+
+      Vector<uint8_t> tail( expected.size() );
+      stream.seekg( m_Size - expected.size(), std::ios_base::beg );
+      stream.read( reinterpret_cast<char*>( tail.data() ), tail.size() );
+
+      return ( stream.good() && tail == expected );
+   }
+
+   std::size_t Instance::writeJournal(
+      std::ostream& stream,
+      const String& password
+      )
+   {
+      Vector<uint8_t> data;
+      Vector<uint8_t> head;
+      packJournal( password, data, head );
+
+      stream.write( reinterpret_cast<const char*>( data.data() ), data.size() );
+      if ( ! stream.good() )
+      {
+         throw std::runtime_error( "failed to write journal" );
+      }
+
+      return commitJournal( data.size(), head );
+   }
+
+   std::size_t Instance::appendJournal(
+      const String& path,
+      const String& password
+      )
+   {
+      Vector<uint8_t> data;
+      Vector<uint8_t> head;
+      packJournal( password, data, head );
+
+      utils::appendFile( path, reinterpret_cast<const char*>( data.data() ), data.size() );
+
+      return commitJournal( data.size(), head );
+   }
+
+   void Instance::packJournal( const String& password, Vector<uint8_t>& data, Vector<uint8_t>& head )
+   {
+      if ( isNew() || m_JournalHead.empty() )
+      {
+         throw std::runtime_error( "write container first" );
+      }
+
+      crypto::IMachine& machine( getCryptoMachine() );
+
+      // 1. Derive (or reuse) and check first key.
+      Vector<uint8_t> key1;
+      deriveKey( password, Key::FIRST, key1 );
+
+      if ( ! isKeyValid( key1, Key::FIRST ) )
+      {
+         throw std::runtime_error( "key is invalid" );
+      }
+      cacheKey( password, Key::FIRST, key1 );
+
+      // 2. Encrypt changed entries with second key (if required).
+      Vector<Entry*> dirtyEntries;
+      for ( const auto& change : m_Changes )
+      {
+         if ( change.second == Change::ENTRY_DELETED )
+         {
+            continue;
+         }
+
+         Entry lookup;
+         lookup.m_Id = change.first;
+         Set<Entry>::iterator it( m_Entries.find( lookup ) );
+         if ( it == m_Entries.end() )
+         {
+            throw std::runtime_error( "entry not found" );
+         }
+
+         bool dirty( false );
+         for ( auto& data : it->getLabeledData() )
+         {
+            dirty = ( dirty || data.second.isDirty() );
+         }
+
+         if ( dirty )
+         {
+            dirtyEntries.push_back( const_cast<Entry*>( &( *it ) ) );
+         }
+      }
+      if ( ! dirtyEntries.empty() )
+      {
+         Vector<uint8_t> key2;
+         deriveKey( password, Key::SECOND, key2 );
+
+         if ( ! isKeyValid( key2, Key::SECOND ) )
+         {
+            throw std::runtime_error( "key is invalid" );
+         }
+         cacheKey( password, Key::SECOND, key2 );
+
+         utils::runParallel(
+            dirtyEntries,
+            [ & ]( Entry* entry ) { encryptEntry( *entry, key2 ); },
+            MIN_ENTRIES_PER_WORKER );
+      }
+
+      // 3. Encrypt records, chain and pack them.
+      data.clear();
+      head = m_JournalHead;
+      for ( const auto& change : m_Changes )
       {
          Vector<uint8_t> serialized;
-         readIntoVector( data, serialized );
+         appendV( serialized, static_cast<uint8_t>( change.second ) );
+         appendV( serialized, change.first );
+         if ( change.second != Change::ENTRY_DELETED )
+         {
+            Entry lookup;
+            lookup.m_Id = change.first;
+            appendV( serialized, *( m_Entries.find( lookup ) ) );
+         }
+
+         Vector<uint8_t> ciphertext;
+         if ( ! machine.encrypt( serialized, key1, ciphertext ) )
+         {
+            throw std::runtime_error( "encryption failed" );
+         }
+
+         // HMAC covers head of journal and the packed ciphertext.
+         Vector<uint8_t> chained( head );
+         appendV( chained, ciphertext );
 
-         if ( ! getCryptoMachine().calcHmac( serialized, key1, hmac ) )
+         Vector<uint8_t> hmac;
+         if ( ! machine.calcHmac( chained, key1, hmac ) )
          {
             throw std::runtime_error( "failed to calculate HMAC" );
          }
+
+         appendV( data, ciphertext );
+         appendV( data, hmac );
+         head = hmac;
       }
-      pack( data, hmac );
 
-      // 6. Calc digest and append.
-      Vector<uint8_t> digest;
+   }
+
+   std::size_t Instance::commitJournal( const std::size_t size, const Vector<uint8_t>& head )
+   {
+      // Remember saved changes.
+      const std::size_t count( m_Changes.size() );
+      m_Size += size;
+      m_JournalHead = head;
+      m_Changes.clear();
+
+      return count;
+   }
+
+   void Instance::deriveKey( const String& password, const Key type, Vector<uint8_t>& key ) const
+   {
+      const String utf8Password( utils::toUtf8( password ) );
+      const Vector<uint8_t>& cachedKey( type == Key::FIRST ? m_Key1 : m_Key2 );
+
+      // Reuse cached key, if password matches.
+      if ( ! cachedKey.empty() )
+      {
+         Vector<uint8_t> passwordHmac;
+         if ( ! getCryptoMachine().calcHmac(
+                 reinterpret_cast<const uint8_t*>( utf8Password.data() ),
+                 utf8Password.size(),
+                 cachedKey,
+                 passwordHmac
+                 )
+            )
+         {
+            throw std::runtime_error( "failed to calculate HMAC" );
+         }
+
+         if ( passwordHmac == ( type == Key::FIRST ? m_PasswordHmac1 : m_PasswordHmac2 ) )
+         {
+            key = cachedKey;
+            return;
+         }
+      }
+
+      crypto::KdfParams params( type == Key::FIRST ? m_Params1 : m_Params2 );
+      if ( ! getCryptoMachine().deriveKey( utf8Password, params, key ) )
       {
-         Vector<uint8_t> serialized;
-         readIntoVector( data, serialized );
+         throw std::runtime_error( "key derivation failed" );
+      }
+   }
+
+   void Instance::cacheKey( const String& password, const Key type, const Vector<uint8_t>& key ) const
+   {
+      const String utf8Password( utils::toUtf8( password ) );
+      Vector<uint8_t>& cachedKey( type == Key::FIRST ? m_Key1 : m_Key2 );
+      Vector<uint8_t>& passwordHmac( type == Key::FIRST ? m_PasswordHmac1 : m_PasswordHmac2 );
+
+      if ( ! getCryptoMachine().calcHmac(
+              reinterpret_cast<const uint8_t*>( utf8Password.data() ),
+              utf8Password.size(),
+              key,
+              passwordHmac
+              )
+         )
+      {
+         throw std::runtime_error( "failed to calculate HMAC" );
+      }
+      cachedKey = key;
+   }
+
+   void Instance::recordChange( const Entry& entry, const Change change )
+   {
+      m_Revision = ++revisions;
+
+      Map<uint32_t,Change>::iterator it( m_Changes.find( entry.getId() ) );
+
+      if ( it == m_Changes.end() )
+      {
+         m_Changes[ entry.getId() ] = change;
+      }
+      else if ( change == Change::ENTRY_DELETED )
+      {
+         // Entry added and deleted before written? Forget it.
+         if ( it->second == Change::ENTRY_ADDED )
+         {
+            m_Changes.erase( it );
+         }
+         else
+         {
+            it->second = change;
+         }
+      }
+      // Updates of added entries remain additions.
+   }
+
+   void Instance::readJournal( std::istream& stream, const Vector<uint8_t>& key1 )
+   {
+      crypto::IMachine& machine( getCryptoMachine() );
+
+      while ( stream.good() && stream.peek() != std::char_traits<char>::eof() )
+      {
+         Vector<uint8_t> ciphertext;
+         Vector<uint8_t> hmac;
+         try
+         {
+            unpack( stream, ciphertext );
+            unpack( stream, hmac );
+         }
+         catch ( std::runtime_error& )
+         {
+            // Torn record at the end (e.g. crash while appending), ignore it.
+            if ( stream.eof() )
+            {
+               break;
+            }
+
+            throw std::runtime_error( "journal is corrupted" );
+         }
+
+         // Check authenticity and order.
+         Vector<uint8_t> chained( m_JournalHead );
+         appendV( chained, ciphertext );
+
+         Vector<uint8_t> calculatedHmac;
+         if ( ! machine.calcHmac( chained, key1, calculatedHmac ) )
+         {
+            throw std::runtime_error( "failed to calculate HMAC" );
+         }
+         if ( calculatedHmac != hmac )
+         {
+            throw std::runtime_error( "journal integrity check failed" );
+         }
+
+         // Decrypt and apply.
+         Vector<uint8_t> plaintext;
+         if ( ! machine.decrypt( ciphertext, key1, plaintext ) )
+         {
+            throw std::runtime_error( "decryption failed" );
+         }
+
+         StringStream tmp( String( reinterpret_cast<char*>( plaintext.data() ), plaintext.size() ) );
+         uint8_t change;
+         unpack( tmp, change );
+         uint32_t id;
+         unpack( tmp, id );
+
+         Entry entry;
+         entry.m_Id = id;
+         m_Entries.erase( entry );
+         m_Chunks.erase( id );
+
+         switch ( static_cast<Change>( change ) )
+         {
+            case Change::ENTRY_ADDED:
+            case Change::ENTRY_UPDATED:
+            {
+               tmp >> entry;
+               if ( entry.m_Id != id || entry.m_InstanceId != m_Id )
+               {
+                  throw std::runtime_error( "unexpected journal record" );
+               }
+
+               // Reset m_Dirty of data as default ctor was used for deserialization.
+               markClean( entry );
+
+               m_Entries.insert( entry );
+               break;
+            }
+            case Change::ENTRY_DELETED:
+            {
+               break;
+            }
+            default:
+            {
+               throw std::runtime_error( "unknown journal record" );
+            }
+         }
+
+         // Remember position of last complete record.
+         if ( stream.eof() )
+         {
+            stream.clear();
+            stream.seekg( 0, std::ios_base::end );
+         }
+         m_Size = stream.tellg();
+         m_JournalHead = hmac;
+         m_Journaled = true;
+      }
+   }
+
+   void Instance::load( Set<Entry>& entries ) const
+   {
+      Set<Entry> loaded;
+
+      for ( const auto& entry : entries )
+      {
+         Map<uint32_t,Chunk>::iterator chunk( m_Chunks.find( entry.getId() ) );
+         if ( chunk == m_Chunks.end() )
+         {
+            loaded.insert( entry );
+            continue;
+         }
+
+         if ( m_Key1.empty() )
+         {
+            throw std::runtime_error( "key is missing" );
+         }
+         if ( chunk->second.m_Offset + chunk->second.m_Length > m_ChunkData.size() )
+         {
+            throw std::runtime_error( "invalid chunk" );
+         }
 
-         if ( ! getCryptoMachine().calcDigest( serialized, digest ) )
+         Vector<uint8_t> plaintext;
+         if ( ! getCryptoMachine().decrypt(
+                 m_ChunkData.data() + chunk->second.m_Offset,
+                 chunk->second.m_Length,
+                 m_Key1,
+                 plaintext
+                 )
+            )
+         {
+            throw std::runtime_error( "decryption failed" );
+         }
+         if ( m_StoredCompression == COMPRESSION_DEFLATE )
+         {
+            Vector<uint8_t> compressed;
+            compressed.swap( plaintext );
+            utils::decompress( compressed.data(), compressed.size(), plaintext );
+         }
+
+         Entry full;
+         {
+            StringStream tmp( String( reinterpret_cast<char*>( plaintext.data() ), plaintext.size() ) );
+            tmp >> full;
+         }
+         if ( full.m_Id != entry.getId() || full.m_InstanceId != m_Id )
          {
-            throw std::runtime_error( "failed to calculate digest" );
+            throw std::runtime_error( "unexpected entry" );
          }
+         markClean( full );
+
+         m_Entries.erase( full );
+         m_Entries.insert( full );
+         m_Chunks.erase( chunk );
+         loaded.insert( full );
       }
-      pack( data, digest );
 
-      // 7. Write to file.
-      data.seekg( 0, std::ios_base::beg );
-      Vector<char> buffer( 128 );
-      while ( data.good() )
+      entries.swap( loaded );
+   }
+
+   void Instance::loadAll() const
+   {
+      if ( ! m_Chunks.empty() )
       {
-         data.read( buffer.data(), buffer.size() );
-         stream.write( buffer.data(), data.gcount() );
+         Set<Entry> entries( m_Entries );
+         load( entries );
       }
+   }
 
-      // Remember saved changes.
-      recalcInitialDigest();
+   void Instance::packChunks( Vector<uint8_t>& data, const Vector<uint8_t>& key1 ) const
+   {
+      crypto::IMachine& machine( getCryptoMachine() );
+
+      // Encrypt entries separately.
+      Map<uint32_t,IndexRecord> index;
+      Vector<uint8_t> chunks;
+      chunks.reserve( m_ChunkData.size() );
+      for ( const auto& entry : m_Entries )
+      {
+         IndexRecord record;
+         record.m_Id = entry.m_Id;
+         record.m_CreatedAt = entry.m_CreatedAt;
+         record.m_UpdatedAt = entry.m_UpdatedAt;
+         record.m_Name = entry.m_Name;
+         record.m_Tags = entry.m_Tags;
+         record.m_Offset = chunks.size();
+
+         Map<uint32_t,Chunk>::const_iterator chunk( m_Chunks.find( entry.m_Id ) );
+         if ( chunk != m_Chunks.end() )
+         {
+            // Not loaded, not changed: reuse ciphertext.
+            chunks.insert(
+               chunks.end(),
+               m_ChunkData.begin() + chunk->second.m_Offset,
+               m_ChunkData.begin() + chunk->second.m_Offset + chunk->second.m_Length
+               );
+         }
+         else
+         {
+            Vector<uint8_t> serialized;
+            packV( serialized, entry );
+            if ( m_Compression == COMPRESSION_DEFLATE )
+            {
+               Vector<uint8_t> compressed;
+               utils::compress( serialized, compressed );
+               serialized.swap( compressed );
+            }
+
+            Vector<uint8_t> ciphertext;
+            if ( ! machine.encrypt( serialized, key1, ciphertext ) )
+            {
+               throw std::runtime_error( "encryption failed" );
+            }
+            chunks.insert( chunks.end(), ciphertext.begin(), ciphertext.end() );
+         }
+
+         record.m_Length = chunks.size() - record.m_Offset;
+         index[ entry.m_Id ] = record;
+      }
+
+      // Encrypt index.
+      Vector<uint8_t> ciphertext;
+      {
+         Vector<uint8_t> serialized;
+         appendV( serialized, m_Id );
+         appendV( serialized, m_Hmac1 );
+         appendV( serialized, m_Hmac2 );
+         appendV( serialized, m_Protocol );
+         appendV( serialized, m_Params1 );
+         appendV( serialized, m_Params2 );
+         appendV( serialized, index );
+         if ( m_Compression == COMPRESSION_DEFLATE )
+         {
+            Vector<uint8_t> compressed;
+            utils::compress( serialized, compressed );
+            serialized.swap( compressed );
+         }
+
+         if ( ! machine.encrypt( serialized, key1, ciphertext ) )
+         {
+            throw std::runtime_error( "encryption failed" );
+         }
+      }
+
+      appendV( data, ciphertext );
+      appendV( data, chunks );
+   }
+
+   void Instance::markClean( const Entry& entry )
+   {
+      for ( auto& date : entry.m_LabeledData )
+      {
+         const_cast<Data&>( date.second ).m_Dirty = false;
+      }
    }
 
    void Instance::throwIfProtocolIsUnknown( const Protocol protocol )
@@ -819,15 +1620,18 @@ namespace sesame
    }
 
    Map<Protocol,std::shared_ptr<crypto::IMachine>> Instance::machines;
+   std::atomic<uint64_t> Instance::revisions( 0 );
 
    crypto::IMachine& Instance::getCryptoMachine( Protocol protocol )
    {
-      if ( machines.find( protocol ) == machines.end() )
+      // Lookups only, once built (see parse()).
+      Map<Protocol,std::shared_ptr<crypto::IMachine>>::const_iterator it( machines.find( protocol ) );
+      if ( it == machines.end() )
       {
-         machines[ protocol ] = crypto::MachineFactory::buildMachine( protocol );
+         it = machines.insert( std::make_pair( protocol, crypto::MachineFactory::buildMachine( protocol ) ) ).first;
       }
 
-      return *( machines[ protocol ] );
+      return *( it->second );
    }
 
    crypto::IMachine& Instance::getCryptoMachine() const
@@ -26,11 +26,13 @@
 #ifndef SESAME_INSTANCE_HPP
 #define SESAME_INSTANCE_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 
 #include "types.hpp"
 #include "sesame/crypto/IMachine.hpp"
+#include "sesame/crypto/KdfParams.hpp"
 #include "sesame/definitions.hpp"
 #include "sesame/Entry.hpp"
 #include "sesame/packaging.hpp"
@@ -54,13 +56,54 @@ namespace sesame
             SECOND   /* inner */
          };
 
+         /**
+          * Types of changes recorded in the journal.
+          */
+         enum class Change : uint8_t
+         {
+            ENTRY_ADDED = 1,
+            ENTRY_UPDATED = 2,
+            ENTRY_DELETED = 3
+         };
+
+         /**
+          * Location of a separately encrypted entry (format v1).
+          */
+         struct Chunk
+         {
+            /** offset of ciphertext */
+            uint64_t m_Offset;
+            /** length of ciphertext */
+            uint64_t m_Length;
+         };
+
+         /**
+          * Index record of an entry (format v1).
+          */
+         struct IndexRecord
+         {
+            uint32_t m_Id;
+            int64_t m_CreatedAt;
+            int64_t m_UpdatedAt;
+            String m_Name;
+            Set<String> m_Tags;
+            uint64_t m_Offset;
+            uint64_t m_Length;
+
+            MSGPACK_DEFINE( m_Id, m_CreatedAt, m_UpdatedAt, m_Name, m_Tags, m_Offset, m_Length )
+         };
+
       public:
          /**
           * Parses data read from stream.
           *
-          * @throw std::runtime_error if parsing fails
+          * @param stream the stream to read from
+          *
+          * @return the params to derive the key for decryption with
+          *
+          * @throw std::runtime_error if parsing fails or protocol is unknown
           */
-         static void parse( std::istream& stream );
+         static crypto::KdfParams parse( std::istream& stream );
 
          /**
           * Creates an empty instance.
@@ -73,8 +116,8 @@ namespace sesame
           */
          explicit Instance(
             const Protocol protocol,
-            const Map<String,Vector<uint8_t>>& params1 = Map<String,Vector<uint8_t>>(),
-            const Map<String,Vector<uint8_t>>& params2 = Map<String,Vector<uint8_t>>()
+            const crypto::KdfParams& params1 = crypto::KdfParams(),
+            const crypto::KdfParams& params2 = crypto::KdfParams()
             );
 
          /**
@@ -105,6 +148,37 @@ namespace sesame
           */
          Protocol getProtocol() const;
 
+         /**
+          * Returns the format used to write the container.
+          *
+          * @return the format
+          */
+         Format getFormat() const;
+
+         /**
+          * Sets the format used to write the container
+          * (to convert from or to format v0).
+          *
+          * @param format the format
+          */
+         void setFormat( const Format format );
+
+         /**
+          * Returns the compression applied before encryption (format v1).
+          *
+          * @return the compression
+          */
+         Compression getCompression() const;
+
+         /**
+          * Sets the compression applied before encryption on next
+          * snapshot write, journal records are never compressed
+          * (format v1, ignored by format v0).
+          *
+          * @param compression the compression
+          */
+         void setCompression( const Compression compression );
+
          /**
           * Returns the crypto machine used by the instance.
           *
@@ -147,6 +221,17 @@ namespace sesame
          Set<Entry> getEntries(
             const Set<String>& tags = Set<String>() ) const;
 
+         /**
+          * Returns all entries of the container with specified tags applied,
+          * without loading them (see Entry::isLoaded()).
+          *
+          * @param tags tags to use as filter
+          *
+          * @return all entries of the container with specified tags applied
+          */
+         Set<Entry> getIndex(
+            const Set<String>& tags = Set<String>() ) const;
+
          /**
           * Returns number of entries of the container with no tags applied.
           *
@@ -161,6 +246,14 @@ namespace sesame
           */
          Set<Entry> getUntaggedEntries() const;
 
+         /**
+          * Returns all entries of the container with no tags applied,
+          * without loading them (see Entry::isLoaded()).
+          *
+          * @return all entries of the container with no tags applied
+          */
+         Set<Entry> getUntaggedIndex() const;
+
          /**
           * Returns all tags applied to container entries.
           *
@@ -189,6 +282,28 @@ namespace sesame
           */
          Set<Entry> findEntries( const String& hexId ) const;
 
+         /**
+          * Finds entries by (partial) hex id,
+          * without loading them (see Entry::isLoaded()).
+          *
+          * @param id the (partial) hex id
+          *
+          * @return set with the entries found
+          */
+         Set<Entry> findIndex( const String& hexId ) const;
+
+         /**
+          * Searches entries whose name or tags match the pattern,
+          * without loading them (see Entry::isLoaded()).
+          *
+          * @param pattern the extended regular expression (case insensitive)
+          *
+          * @throw std::runtime_error if pattern is invalid
+          *
+          * @return set with the entries found
+          */
+         Set<Entry> searchIndex( const String& pattern ) const;
+
          /**
           * Decrypts an entry.
           *
@@ -218,6 +333,44 @@ namespace sesame
           */
          void decryptData( Data& data, const String& password );
 
+         /**
+          * Decrypts data with the cached key (see unlock()),
+          * so the password doesn't have to be kept.
+          *
+          * @param data the data to decrypt
+          *
+          * @throw std::runtime_error if locked or on failure
+          */
+         void decryptData( Data& data );
+
+         /**
+          * Checks the password against both keys and caches them,
+          * so data can be decrypted without the password afterwards.
+          *
+          * @param password the password to use
+          *
+          * @throw std::runtime_error if password is invalid
+          */
+         void unlock( const String& password );
+
+         /**
+          * Returns <tt>true</tt> if data can be decrypted
+          * without password (see unlock()).
+          *
+          * @return <tt>true</tt> if unlocked
+          */
+         bool isUnlocked() const;
+
+         /**
+          * Encrypts changed data of all entries in parallel,
+          * the key is derived once and cached.
+          *
+          * @param password the password to use
+          *
+          * @throw std::runtime_error on failure
+          */
+         void encryptEntries( const String& password );
+
          /**
           * Adds the passed entry.
           *
@@ -230,7 +383,7 @@ namespace sesame
          /**
           * Updates the passed entry.
           *
-          * @param entry the entry to update
+          * @param entry the entry to update (has to be loaded)
           *
           * @return <tt>true</tt> for success, otherwise <tt>false</tt>
           */
@@ -245,11 +398,6 @@ namespace sesame
           */
          bool deleteEntry( Entry& entry );
 
-         /**
-          * Recalcs initial digest.
-          */
-         void recalcInitialDigest();
-
          /**
           * Returns <tt>true</tt> if all entries are plain,
           * meaning plaintexts of all data are available.
@@ -260,7 +408,9 @@ namespace sesame
          bool isPlain() const;
 
          /**
-          * Returns <tt>true</tt> if there are unsafed changes.
+          * Returns <tt>true</tt> if there are unsafed changes
+          * (entries changed or data not encrypted since written
+          * or read last).
           *
           * @return <tt>true</tt> if there are unsafed changes
           */
@@ -279,6 +429,98 @@ namespace sesame
             const String& password
             );
 
+         /**
+          * Returns <tt>true</tt> if journal mode is enabled. In journal mode
+          * changes are appended to the container written or read last.
+          *
+          * @return <tt>true</tt> if journal mode is enabled
+          */
+         bool isJournaled() const;
+
+         /**
+          * Enables or disables journal mode.
+          *
+          * @param journaled <tt>true</tt> to enable journal mode
+          */
+         void setJournaled( const bool journaled );
+
+         /**
+          * Returns the number of changes not written so far.
+          *
+          * @return the number of unsaved changes
+          */
+         std::size_t getNumOfChanges() const;
+
+         /**
+          * Returns the revision of the entries. It changes whenever an entry
+          * is added, updated or deleted and is unique across all instances.
+          *
+          * @return the revision
+          */
+         uint64_t getRevision() const;
+
+         /**
+          * Returns the size of the container written or read last.
+          *
+          * @return the size in bytes (<tt>0</tt> if never written or read)
+          */
+         std::size_t getSize() const;
+
+         /**
+          * Returns <tt>true</tt> if format or compression were changed
+          * since the container was written or read last. Journal records
+          * can't carry such a change, a snapshot has to be written.
+          *
+          * @return <tt>true</tt> if format or compression were changed
+          */
+         bool isLayoutChanged() const;
+
+         /**
+          * Returns <tt>true</tt> if <tt>stream</tt> contains exactly the
+          * container written or read last, so journal records
+          * can be appended to it.
+          *
+          * @param stream the stream to check
+          *
+          * @return <tt>true</tt> if journal records can be appended
+          */
+         bool isStoredIn( std::istream& stream ) const;
+
+         /**
+          * Encrypts the unsaved changes (entries added, updated or deleted)
+          * and writes them as HMAC-chained journal records to <tt>stream</tt>.
+          * The records have to be appended to the container written or
+          * read last (see isStoredIn()).
+          *
+          * @param stream the stream to write to
+          * @param password the password
+          *
+          * @return the number of records written
+          *
+          * @throw std::runtime_error on failure
+          */
+         std::size_t writeJournal(
+            std::ostream& stream,
+            const String& password
+            );
+
+         /**
+          * Like writeJournal(), but appends the records to the file
+          * at <tt>path</tt>. The changes are only marked as saved
+          * if appending succeeded.
+          *
+          * @param path the file holding the container (see isStoredIn())
+          * @param password the password
+          *
+          * @return the number of records appended
+          *
+          * @throw std::runtime_error on failure
+          */
+         std::size_t appendJournal(
+            const String& path,
+            const String& password
+            );
+
       private:
          /**
           * Creates an empty instance, required by msgpack.
@@ -309,13 +551,6 @@ namespace sesame
           */
          bool isNewKey( const Key type ) const;
 
-         /**
-          * Calculates digest of container (used to detect changes).
-          *
-          * @return digest of container
-          */
-         const Vector<uint8_t> calcDigest() const;
-
          /**
           * Calculates the HMAC of the passed value.
           *
@@ -349,6 +584,110 @@ namespace sesame
           */
          bool isKeyValid( const Vector<uint8_t>& key, const Key type ) const;
 
+         /**
+          * Derives the key of passed type from password. A cached key
+          * is used, if the password matches the one used before.
+          *
+          * @param password the password
+          * @param type type of the key
+          * @param[out] key the derived key
+          *
+          * @throw std::runtime_error on failure
+          */
+         void deriveKey( const String& password, const Key type, Vector<uint8_t>& key ) const;
+
+         /**
+          * Caches a valid key, so it hasn't to be derived again.
+          * The password is only remembered as HMAC keyed with the key.
+          *
+          * @param password the password the key was derived from
+          * @param type type of the key
+          * @param key the key to cache
+          *
+          * @throw std::runtime_error on failure
+          */
+         void cacheKey( const String& password, const Key type, const Vector<uint8_t>& key ) const;
+
+         /**
+          * Records a change of an entry for the journal.
+          *
+          * @param entry the entry changed
+          * @param change type of the change
+          */
+         void recordChange( const Entry& entry, const Change change );
+
+         /**
+          * Encrypts the unsaved changes and packs them as HMAC-chained
+          * journal records. The changes aren't marked as saved
+          * (see commitJournal()).
+          *
+          * @param password the password
+          * @param[out] data the packed records
+          * @param[out] head the HMAC of the last record
+          *
+          * @throw std::runtime_error on failure
+          */
+         void packJournal( const String& password, Vector<uint8_t>& data, Vector<uint8_t>& head );
+
+         /**
+          * Marks the unsaved changes as saved, after their journal
+          * records were written successfully.
+          *
+          * @param size the size of the records written
+          * @param head the HMAC of the last record
+          *
+          * @return the number of records written
+          */
+         std::size_t commitJournal( const std::size_t size, const Vector<uint8_t>& head );
+
+         /**
+          * Reads journal records from stream and applies them.
+          * A torn (incomplete) last record is ignored,
+          * a corrupted record in between makes reading fail.
+          *
+          * @param stream the stream to read from
+          * @param key1 the first key
+          *
+          * @throw std::runtime_error on failure
+          */
+         void readJournal( std::istream& stream, const Vector<uint8_t>& key1 );
+
+         /**
+          * Loads (decrypts and deserializes) the passed entries, if required.
+          * Replaces the passed entries with the loaded ones.
+          *
+          * @param[in,out] entries the entries to load
+          *
+          * @throw std::runtime_error on failure
+          */
+         void load( Set<Entry>& entries ) const;
+
+         /**
+          * Loads all entries.
+          *
+          * @throw std::runtime_error on failure
+          */
+         void loadAll() const;
+
+         /**
+          * Encrypts the index and the entries separately and packs them (format v1).
+          * Entries not loaded are packed as they are, so all entries have to be
+          * loaded if compression was changed.
+          *
+          * @param data the buffer to append to
+          * @param key1 the first key
+          *
+          * @throw std::runtime_error on failure
+          */
+         void packChunks( Vector<uint8_t>& data, const Vector<uint8_t>& key1 ) const;
+
+         /**
+          * Resets dirty flags of deserialized data.
+          *
+          * @param entry the entry deserialized
+          */
+         static void markClean( const Entry& entry );
+
          /**
           * Encrypts an entry.
           *
@@ -418,22 +757,51 @@ namespace sesame
 
          /** a map with crypto machine for each used protocol */
          static Map<Protocol,std::shared_ptr<crypto::IMachine>> machines;
+         /** the revision handed out last */
+         static std::atomic<uint64_t> revisions;
          /** unique id of the instance */
          uint32_t m_Id;
          /** HMAC of id, used to check password (build with first key) */
          mutable Vector<uint8_t> m_Hmac1;
          /** HMAC of id, used to check password (build with second key) */
          mutable Vector<uint8_t> m_Hmac2;
-         /** initial digest of container */
-         Vector<uint8_t> m_InitialDigest;
          /** the protocol to use */
          Protocol m_Protocol;
          /** the key derivation params to use (for first key) */
-         Map<String,Vector<uint8_t>> m_Params1;
+         crypto::KdfParams m_Params1;
          /** the key derivation params to use (for second key) */
-         Map<String,Vector<uint8_t>> m_Params2;
-         /** the covered entries */
-         Set<Entry> m_Entries;
+         crypto::KdfParams m_Params2;
+         /** the covered entries (not loaded entries are replaced on first access) */
+         mutable Set<Entry> m_Entries;
+         /** the format to use */
+         Format m_Format;
+         /** the compression to use (format v1) */
+         Compression m_Compression;
+         /** the format of container written or read last */
+         Format m_StoredFormat;
+         /** the compression of container written or read last (and of chunk data) */
+         Compression m_StoredCompression;
+         /** the separately encrypted entries (format v1) */
+         Vector<uint8_t> m_ChunkData;
+         /** chunks of entries not loaded so far by entry id */
+         mutable Map<uint32_t,Chunk> m_Chunks;
+         /** cached keys and HMACs of the passwords they were derived from */
+         mutable Vector<uint8_t> m_Key1;
+         mutable Vector<uint8_t> m_PasswordHmac1;
+         mutable Vector<uint8_t> m_Key2;
+         mutable Vector<uint8_t> m_PasswordHmac2;
+         /** unsaved changes by entry id */
+         Map<uint32_t,Change> m_Changes;
+         /** digest of snapshot or HMAC of last journal record written or read */
+         Vector<uint8_t> m_JournalHead;
+         /** size of container written or read last */
+         std::size_t m_Size;
+         /** size of instance packed last (to size buffers) */
+         mutable std::size_t m_PackedSize;
+         /** journal mode enabled? */
+         bool m_Journaled;
+         /** revision of entries */
+         uint64_t m_Revision;
 
       // (de)serialization
       public:
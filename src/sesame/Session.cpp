@@ -0,0 +1,99 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <algorithm>
+#include <stdexcept>
+#include "sesame/Session.hpp"
+
+
+namespace sesame
+{
+   Vector<std::shared_ptr<Instance>> Session::instances;
+
+   void Session::add( const std::shared_ptr<Instance>& instance )
+   {
+      if ( instance && std::find( instances.begin(), instances.end(), instance ) == instances.end() )
+      {
+         instances.push_back( instance );
+      }
+   }
+
+   void Session::replace(
+      const std::shared_ptr<Instance>& instance,
+      const std::shared_ptr<Instance>& replacement
+      )
+   {
+      std::replace( instances.begin(), instances.end(), instance, replacement );
+   }
+
+   std::shared_ptr<Instance> Session::remove( const std::shared_ptr<Instance>& instance )
+   {
+      instances.erase( std::remove( instances.begin(), instances.end(), instance ), instances.end() );
+
+      return ( instances.empty() ? std::shared_ptr<Instance>() : instances.back() );
+   }
+
+   std::shared_ptr<Instance> Session::find( const String& hexId )
+   {
+      // Adjust id.
+      String s( hexId );
+      if ( s.find( "#" ) == 0 )
+      {
+         s.replace( 0, 1, "" );
+      }
+
+      std::shared_ptr<Instance> result;
+      for ( auto& instance : instances )
+      {
+         if ( s.empty() || instance->getIdAsHexString().find( s ) != 0 )
+         {
+            continue;
+         }
+         else if ( result )
+         {
+            throw std::runtime_error( "container id is ambiguous" );
+         }
+         result = instance;
+      }
+
+      if ( ! result )
+      {
+         throw std::runtime_error( "container not open" );
+      }
+
+      return result;
+   }
+
+   const Vector<std::shared_ptr<Instance>>& Session::getInstances()
+   {
+      return instances;
+   }
+
+   void Session::clear()
+   {
+      instances.clear();
+   }
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifndef SESAME_SESSION_HPP
+#define SESAME_SESSION_HPP
+
+#include <memory>
+#include "types.hpp"
+#include "sesame/Instance.hpp"
+
+
+namespace sesame
+{
+   /**
+    * Keeps track of the containers open in a session. Commands work
+    * on the current container, the others stay open (with their keys
+    * cached) until switched to.
+    */
+   class Session
+   {
+      public:
+         /**
+          * Adds an open container.
+          *
+          * @param instance the container
+          */
+         static void add( const std::shared_ptr<Instance>& instance );
+
+         /**
+          * Replaces an open container (e.g. by a recrypted one).
+          *
+          * @param instance the container to replace
+          * @param replacement the container replacing it
+          */
+         static void replace(
+            const std::shared_ptr<Instance>& instance,
+            const std::shared_ptr<Instance>& replacement
+            );
+
+         /**
+          * Removes a container closed.
+          *
+          * @param instance the container
+          *
+          * @return the container opened last of the remaining ones
+          *     (<tt>nullptr</tt> if there is none)
+          */
+         static std::shared_ptr<Instance> remove( const std::shared_ptr<Instance>& instance );
+
+         /**
+          * Returns the open container with the given id.
+          *
+          * @param hexId the id (or a unique prefix of it)
+          *
+          * @return the container
+          *
+          * @throw std::runtime_error if no or several containers match
+          */
+         static std::shared_ptr<Instance> find( const String& hexId );
+
+         /**
+          * Returns the open containers (in the order they were opened).
+          *
+          * @return the open containers
+          */
+         static const Vector<std::shared_ptr<Instance>>& getInstances();
+
+         /**
+          * Forgets all containers.
+          */
+         static void clear();
+
+      private:
+         /** the open containers */
+         static Vector<std::shared_ptr<Instance>> instances;
+   };
+}
+
+#endif
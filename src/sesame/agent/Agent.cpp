@@ -0,0 +1,319 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <iomanip>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "sesame/agent/Agent.hpp"
+#include "sesame/packaging.hpp"
+#include "sesame/utils/socket.hpp"
+
+namespace {
+   /** max size of a request (bytes) */
+   const std::size_t MAX_REQUEST_SIZE( 64 * 1024 );
+
+   /** max size of a response (bytes) */
+   const std::size_t MAX_RESPONSE_SIZE( 64 * 1024 * 1024 );
+
+   /** timeout for a client to send its request (ms) */
+   const int CLIENT_TIMEOUT( 1000 );
+
+   struct EntrySorter
+   {
+      bool operator()( const sesame::Entry& a, const sesame::Entry& b )
+      {
+         return ( a.getName() < b.getName() );
+      }
+   };
+
+   void appendIndex( Vector<String>& lines, const Set<sesame::Entry>& entries )
+   {
+      Vector<sesame::Entry> sorted( entries.begin(), entries.end() );
+      std::sort( sorted.begin(), sorted.end(), EntrySorter() );
+
+      for ( auto& entry : sorted )
+      {
+         lines.push_back( entry.getIdAsHexString() + "\t" + entry.getName() );
+      }
+   }
+
+   String toHexString( const Vector<uint8_t>& data )
+   {
+      StringStream s;
+      s << std::hex << std::setfill( '0' );
+      for ( auto byte : data )
+      {
+         s << std::setw( 2 ) << static_cast<uint32_t>( byte );
+      }
+      return s.str();
+   }
+
+   // Creates the directory (if missing) and checks that only the owner can access it.
+   const String& checkPrivateDir( const String& path )
+   {
+      if ( ::mkdir( path.c_str(), 0700 ) == -1 && errno != EEXIST )
+      {
+         throw std::runtime_error( "failed to create socket directory" );
+      }
+
+      struct stat buf;
+      if ( ::lstat( path.c_str(), &buf ) == -1 || ! S_ISDIR( buf.st_mode ) ||
+           buf.st_uid != getuid() || ( buf.st_mode & 077 ) != 0 )
+      {
+         throw std::runtime_error( "socket directory is not private" );
+      }
+
+      return path;
+   }
+
+   std::size_t toPos( const String& pos, const std::size_t size )
+   {
+      const String s( pos.find( "#" ) == 0 ? pos.substr( 1 ) : pos );
+
+      if ( s.empty() || s.find_first_not_of( "0123456789" ) != String::npos )
+      {
+         throw std::runtime_error( "elem not found" );
+      }
+
+      const std::size_t p( std::strtoul( s.c_str(), nullptr, 10 ) );
+      if ( p < 1 || p > size )
+      {
+         throw std::runtime_error( "elem not found" );
+      }
+
+      return p - 1;
+   }
+}
+
+namespace sesame { namespace agent {
+
+Agent::Agent( const std::shared_ptr<Instance>& instance ) :
+   m_Instance( instance )
+{
+   if ( ! m_Instance )
+   {
+      throw std::runtime_error( "no instance open" );
+   }
+
+   if ( ! m_Instance->isUnlocked() )
+   {
+      throw std::runtime_error( "container is locked" );
+   }
+}
+
+Agent::Agent( const std::shared_ptr<Instance>& instance, const String& password ) :
+   m_Instance( instance )
+{
+   if ( ! m_Instance )
+   {
+      throw std::runtime_error( "no instance open" );
+   }
+
+   // Check password against the keys once, serve with the cached key.
+   m_Instance->unlock( password );
+}
+
+String Agent::getSocketPath()
+{
+   const char* path( std::getenv( "SESAME_AGENT_SOCK" ) );
+   if ( path && *path )
+   {
+      return path;
+   }
+
+   const char* runtimeDir( std::getenv( "XDG_RUNTIME_DIR" ) );
+   if ( runtimeDir && *runtimeDir )
+   {
+      return String( runtimeDir ) + "/sesame-agent";
+   }
+
+   // Other users can create files in /tmp, so use a private directory.
+   StringStream s;
+   s << "/tmp/sesame-" << getuid();
+   return checkPrivateDir( s.str() ) + "/agent";
+}
+
+Vector<String> Agent::handle( const Vector<String>& request )
+{
+   Vector<String> response;
+
+   try
+   {
+      const String command( request.empty() ? "" : request[ 0 ] );
+
+      if ( command == "list" && request.size() == 1 )
+      {
+         appendIndex( response, m_Instance->getIndex() );
+      }
+      else if ( command == "search" && request.size() == 2 )
+      {
+         appendIndex( response, m_Instance->searchIndex( request[ 1 ] ) );
+      }
+      else if ( command == "show" && request.size() == 2 )
+      {
+         const Entry entry( m_Instance->findEntry( request[ 1 ] ) );
+
+         response.push_back( "id\t" + entry.getIdAsHexString() );
+         response.push_back( "name\t" + entry.getName() );
+         for ( auto& tag : entry.getTags() )
+         {
+            response.push_back( "tag\t" + tag );
+         }
+         for ( auto& attribute : entry.getAttributes() )
+         {
+            response.push_back( "attribute\t" + attribute.first + "\t" + attribute.second );
+         }
+         for ( auto& labeledDate : entry.getLabeledData() )
+         {
+            response.push_back(
+               ( labeledDate.second.getType() == DATA_TEXT ? "password\t" : "key\t" ) +
+               labeledDate.first
+               );
+         }
+      }
+      else if ( command == "export" && ( request.size() == 2 || request.size() == 3 ) )
+      {
+         const Entry entry( m_Instance->findEntry( request[ 1 ] ) );
+         const Map<String,Data> labeledData( entry.getLabeledData() );
+
+         Map<String,Data>::const_iterator it( labeledData.begin() );
+         std::advance( it, toPos( request.size() == 3 ? request[ 2 ] : "1", labeledData.size() ) );
+
+         Data date( it->second );
+         m_Instance->decryptData( date );
+
+         if ( date.getType() == DATA_TEXT )
+         {
+            response.push_back( date.getPlaintext<String>() );
+         }
+         else
+         {
+            response.push_back( toHexString( date.getPlaintext<Vector<uint8_t>>() ) );
+         }
+      }
+      else
+      {
+         throw std::runtime_error( "invalid request" );
+      }
+
+      response.insert( response.begin(), "ok" );
+   }
+   catch ( std::runtime_error& e )
+   {
+      response = { "error", e.what() };
+   }
+
+   return response;
+}
+
+void Agent::serve( const String& path, const bool& stopRequested )
+{
+   const int fd( utils::listenOn( path ) );
+
+   while ( ! stopRequested )
+   {
+      // Wake up regularly to check for stop requests.
+      struct pollfd pending = { fd, POLLIN, 0 };
+      if ( ::poll( &pending, 1, 500 ) <= 0 )
+      {
+         continue;
+      }
+
+      int client( -1 );
+      try
+      {
+         client = utils::acceptOn( fd, CLIENT_TIMEOUT );
+
+         // Serve owner only.
+         if ( utils::isPeerTrusted( client ) )
+         {
+            Vector<uint8_t> data;
+            utils::receiveAll( client, data, MAX_REQUEST_SIZE );
+
+            Vector<String> request;
+            unpackV( data, request );
+            packV( data, handle( request ) );
+
+            utils::sendAll( client, data );
+         }
+      }
+      catch ( std::runtime_error& )
+      {
+         // Drop request, keep serving.
+      }
+
+      if ( client != -1 )
+      {
+         utils::closeSocket( client );
+      }
+   }
+
+   utils::closeSocket( fd );
+   ::unlink( path.c_str() );
+}
+
+Vector<String> Agent::query( const String& path, const Vector<String>& request )
+{
+   const int fd( utils::connectTo( path ) );
+
+   Vector<String> response;
+   try
+   {
+      // Talk to an agent of the owner only, anyone else could forge responses.
+      if ( ! utils::isPeerTrusted( fd ) )
+      {
+         throw std::runtime_error( "agent not trusted" );
+      }
+
+      Vector<uint8_t> data;
+      packV( data, request );
+      utils::sendAll( fd, data );
+      utils::receiveAll( fd, data, MAX_RESPONSE_SIZE );
+
+      if ( data.empty() )
+      {
+         throw std::runtime_error( "request rejected by agent" );
+      }
+      unpackV( data, response );
+   }
+   catch ( std::runtime_error& )
+   {
+      utils::closeSocket( fd );
+      throw;
+   }
+   utils::closeSocket( fd );
+
+   return response;
+}
+
+} }
@@ -0,0 +1,126 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SESAME_AGENT_AGENT_HPP
+#define SESAME_AGENT_AGENT_HPP
+
+#include <memory>
+#include "types.hpp"
+#include "sesame/Instance.hpp"
+
+
+namespace sesame { namespace agent {
+
+/**
+ * Serves an open container over a unix socket (like ssh-agent),
+ * so clients don't have to open the container and derive keys
+ * on every lookup.
+ *
+ * Requests and responses are msgpack encoded string arrays, one
+ * request per connection. Requests are <tt>list</tt>,
+ * <tt>search PATTERN</tt>, <tt>show ID</tt> and <tt>export ID [POS]</tt>.
+ * Responses start with <tt>ok</tt> or <tt>error</tt>, followed by
+ * tab separated lines or the error message.
+ */
+class Agent
+{
+   public:
+      /**
+       * Ctor.
+       *
+       * @param instance the open and unlocked instance to serve
+       *     (see Instance::unlock())
+       *
+       * @throw std::runtime_error if instance is locked
+       */
+      explicit Agent( const std::shared_ptr<Instance>& instance );
+
+      /**
+       * Ctor, unlocks the instance first. The password isn't kept.
+       *
+       * @param instance the open instance to serve
+       * @param password the password or phrase to decrypt passwords/keys
+       *
+       * @throw std::runtime_error if password is invalid
+       */
+      Agent( const std::shared_ptr<Instance>& instance, const String& password );
+
+      /**
+       * Dtor.
+       */
+      virtual ~Agent() = default;
+
+      /**
+       * Returns the socket path to use, which is <tt>$SESAME_AGENT_SOCK</tt>,
+       * <tt>$XDG_RUNTIME_DIR/sesame-agent</tt> or <tt>/tmp/sesame-UID/agent</tt>
+       * (the directory is created accessible by the owner only).
+       *
+       * @throw std::runtime_error if <tt>/tmp/sesame-UID</tt> isn't private
+       *
+       * @return the socket path
+       */
+      static String getSocketPath();
+
+      /**
+       * Handles a request.
+       *
+       * @param request the request (command and arguments)
+       *
+       * @return the response
+       */
+      Vector<String> handle( const Vector<String>& request );
+
+      /**
+       * Serves requests of the owner (checked by <tt>SO_PEERCRED</tt>)
+       * until stop is requested, one at a time.
+       *
+       * @param path the socket path
+       * @param stopRequested flag set to stop serving
+       *
+       * @throw std::runtime_error if socket setup fails
+       */
+      void serve( const String& path, const bool& stopRequested );
+
+      /**
+       * Sends a request to an agent.
+       *
+       * @param path the socket path
+       * @param request the request (command and arguments)
+       *
+       * @throw std::runtime_error if agent is not reachable
+       *     (or not run by the owner)
+       *
+       * @return the response
+       */
+      static Vector<String> query( const String& path, const Vector<String>& request );
+
+   private:
+      /** the open instance */
+      std::shared_ptr<Instance> m_Instance;
+};
+
+} }
+
+#endif
@@ -23,6 +23,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
@@ -33,6 +34,7 @@
 
 #include "types.hpp"
 #include "sesame/commands/ApgTask.hpp"
+#include "sesame/utils/BloomFilter.hpp"
 #include "sesame/utils/lines.hpp"
 #include "sesame/utils/string.hpp"
 
@@ -64,6 +66,23 @@ void ApgTask::run( std::shared_ptr<Instance>& instance )
    apgCache.clear();
    apgCache = apg( m_Tokens.size(), args.data() );
 
+   // Never offer passwords found in breached password dictionary.
+   std::size_t breached( 0 );
+   const utils::BloomFilter* filter( utils::BloomFilter::getDefault() );
+   if ( filter )
+   {
+      const std::size_t generated( apgCache.size() );
+      apgCache.erase(
+            std::remove_if( apgCache.begin(), apgCache.end(),
+               [ filter ]( const std::pair<std::string,std::string>& tuple )
+               {
+                  return filter->contains( tuple.first.c_str() );
+               } ),
+            apgCache.end()
+            );
+      breached = generated - apgCache.size();
+   }
+
    if ( ! apgCache.empty() )
    {
       std::size_t maxLength( 0 );
@@ -96,6 +115,12 @@ void ApgTask::run( std::shared_ptr<Instance>& instance )
       std::cout << "\nYou can reference a password by entering ";
       std::cout << "\nits id in the password dialog." << std::endl;
    }
+
+   if ( breached > 0 )
+   {
+      std::cout << "\nDropped " << breached << " generated password(s) listed " <<
+         "in breached password dictionary." << std::endl;
+   }
 }
 
 } }
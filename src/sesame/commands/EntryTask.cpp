@@ -23,6 +23,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -37,9 +38,12 @@
 #include "sesame/utils/completion.hpp"
 #include "sesame/utils/filesystem.hpp"
 #include "sesame/utils/lines.hpp"
+#include "sesame/utils/passwords.hpp"
 #include "sesame/utils/string.hpp"
 #include "sesame/utils/xselection.hpp"
+#include "sesame/utils/BloomFilter.hpp"
 #include "sesame/utils/Reader.hpp"
+#include "sesame/utils/RecordWriter.hpp"
 #include "sesame/utils/TeclaReader.hpp"
 
 extern std::vector<std::pair<std::string,std::string>> apgCache;
@@ -160,6 +164,37 @@ namespace {
       return result;
    }
 
+   void checkBreached( const String& password )
+   {
+      const utils::BloomFilter* filter( utils::BloomFilter::getDefault() );
+      if ( filter && filter->contains( password ) )
+      {
+         std::cerr << "WARNING: Password is listed in breached password dictionary!" << std::endl;
+      }
+   }
+
+   const String HISTORY_PREFIX( " (rotated " );
+
+   bool isHistoryLabel( const String& label )
+   {
+      return label.find( HISTORY_PREFIX ) != String::npos;
+   }
+
+   String getHistoryLabel( const Entry& entry, const String& label, const String& date )
+   {
+      const Map<String,Data> labeledData( entry.getLabeledData() );
+
+      StringStream historyLabel;
+      historyLabel << label << HISTORY_PREFIX << date << ")";
+      for ( std::size_t i = 2; labeledData.count( historyLabel.str() ) > 0; ++i )
+      {
+         historyLabel.str( "" );
+         historyLabel << label << HISTORY_PREFIX << date << " #" << i << ")";
+      }
+
+      return historyLabel.str();
+   }
+
    String preProcessTag( std::shared_ptr<Instance>& instance, const String& tag )
    {
       String result( tag );
@@ -186,8 +221,88 @@ namespace {
 
       return result;
    }
+
+   bool isTextOutput()
+   {
+      return utils::RecordWriter::getFormat() == OUTPUT_TEXT;
+   }
+
+   void writeTags( utils::RecordWriter& writer, const Set<String>& tags )
+   {
+      writer.beginArray( tags.size() );
+      for ( const auto& tag : tags )
+      {
+         writer.value( tag );
+      }
+      writer.end();
+   }
+
+   void writeIndex( const Vector<Entry>& entries )
+   {
+      utils::RecordWriter writer( std::cout );
+
+      for ( const auto& entry : entries )
+      {
+         writer.beginMap( 3 );
+         writer.value( "id" ).value( entry.getIdAsHexString() );
+         writer.value( "name" ).value( entry.getName() );
+         writer.value( "tags" );
+         writeTags( writer, entry.getTags() );
+         writer.end();
+      }
+   }
+
+   void writeEntry( const Entry& entry )
+   {
+      utils::RecordWriter writer( std::cout );
+      const Vector<std::pair<String,String>> attributes( toSortedVector( entry.getAttributes() ) );
+      const Vector<std::pair<String,Data>> data( toSortedVector( entry.getLabeledData() ) );
+
+      writer.beginMap( 5 );
+      writer.value( "id" ).value( entry.getIdAsHexString() );
+      writer.value( "name" ).value( entry.getName() );
+      writer.value( "tags" );
+      writeTags( writer, entry.getTags() );
+
+      writer.value( "attributes" ).beginMap( attributes.size() );
+      for ( const auto& attribute : attributes )
+      {
+         writer.value( attribute.first ).value( attribute.second );
+      }
+      writer.end();
+
+      // Passwords as plaintext, keys by size only (like text output).
+      writer.value( "data" ).beginArray( data.size() );
+      for ( const auto& date : data )
+      {
+         const bool isPassword( date.second.getType() == DATA_TEXT );
+
+         writer.beginMap( 3 );
+         writer.value( "label" ).value( date.first );
+         writer.value( "type" ).value( isPassword ? "password" : "key" );
+         writer.value( isPassword ? "value" : "size" );
+         if ( ! date.second.isPlaintextAvailable() )
+         {
+            writer.nil();
+         }
+         else if ( isPassword )
+         {
+            writer.value( date.second.getPlaintext<String>() );
+         }
+         else
+         {
+            writer.value( static_cast<uint64_t>( date.second.getPlaintext<Vector<uint8_t>>().size() ) );
+         }
+         writer.end();
+      }
+      writer.end();
+
+      writer.end();
+   }
 }
 
+String EntryTask::lastAddedId;
+
 EntryTask::EntryTask( const Type taskType, const String& id, const String& pos ) :
    ICommand(),
    m_TaskType( taskType ),
@@ -215,12 +330,15 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
          {
             if ( instance->getNumOfEntries() == 0 )
             {
-               std::cout << "No entries yet." << std::endl;
+               if ( isTextOutput() )
+               {
+                  std::cout << "No entries yet." << std::endl;
+               }
                break;
             }
             else
             {
-               entries = toSortedVector( instance->getEntries() );
+               entries = toSortedVector( instance->getIndex() );
             }
          }
          // Untagged entries.
@@ -233,7 +351,7 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
             else
             {
                tag = "Untagged";
-               entries = toSortedVector( instance->getUntaggedEntries() );
+               entries = toSortedVector( instance->getUntaggedIndex() );
             }
          }
          // Tagged entries.
@@ -250,10 +368,16 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
             }
             else
             {
-               entries = toSortedVector( instance->getEntries( filter ) );
+               entries = toSortedVector( instance->getIndex( filter ) );
             }
          }
 
+         if ( ! isTextOutput() )
+         {
+            writeIndex( entries );
+            break;
+         }
+
          // List entries.
          if ( m_Id.empty() )
          {
@@ -293,13 +417,45 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
       }
       case SEARCH:
       {
-         std::cout << "Some day i will search for /" << m_Id << "/ ..." << std::endl;
+         const Vector<Entry> entries( toSortedVector( instance->searchIndex( m_Id ) ) );
+
+         if ( ! isTextOutput() )
+         {
+            writeIndex( entries );
+            break;
+         }
+
+         if ( entries.empty() )
+         {
+            std::cout << "No entries found." << std::endl;
+            break;
+         }
+
+         std::cout << "Entries matching /" << m_Id << "/:" << std::endl;
+
+         std::size_t i( entries.size() );
+         for ( const auto& entry : entries )
+         {
+            std::cout << ( i-- > 1 ? utils::branch() : utils::corner() );
+            std::cout << "[#" << entry.getIdAsHexString() << "] "
+                      << utils::ESC_SEQ_BOLD
+                      << entry.getName()
+                      << utils::ESC_SEQ_RESET
+                      << std::endl;
+         }
          break;
       }
       case TREE:
       {
          const Vector<String> tags( setToSortedVector( instance->getTags() ) );
-         Vector<Entry> entries( toSortedVector( instance->getEntries() ) );
+         Vector<Entry> entries( toSortedVector( instance->getIndex() ) );
+
+         // Tags are part of every record.
+         if ( ! isTextOutput() )
+         {
+            writeIndex( entries );
+            break;
+         }
 
          // No entries!
          if ( entries.empty() )
@@ -342,7 +498,7 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
 
             Set<String> filter;
             filter.insert( tag );
-            entries = toSortedVector( instance->getEntries( filter ) );
+            entries = toSortedVector( instance->getIndex( filter ) );
 
             std::size_t k( entries.size() );
             for ( const auto& entry : entries )
@@ -363,6 +519,20 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
       {
          const Vector<String> tags( setToSortedVector( instance->getTags() ) );
 
+         if ( ! isTextOutput() )
+         {
+            utils::RecordWriter writer( std::cout );
+            std::size_t k( 1 );
+            for ( const auto& tag : tags )
+            {
+               writer.beginMap( 2 );
+               writer.value( "pos" ).value( static_cast<uint64_t>( k++ ) );
+               writer.value( "tag" ).value( tag );
+               writer.end();
+            }
+            break;
+         }
+
          if ( tags.empty() )
          {
             std::cout << "No tags yet." << std::endl;
@@ -390,6 +560,12 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
       case SHOW:
       {
          const Entry entry( instance->findEntry( m_Id ) );
+         if ( ! isTextOutput() )
+         {
+            writeEntry( entry );
+            break;
+         }
+
          std::cout << "[#" << entry.getIdAsHexString() << "] "
                    << utils::ESC_SEQ_BOLD
                    << entry.getName()
@@ -498,6 +674,7 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
          {
             throw std::runtime_error( "failed to add entry" );
          }
+         lastAddedId = entry.getIdAsHexString();
          std::cout << "Added entry #" << entry.getIdAsHexString() << "." << std::endl;
          break;
       }
@@ -630,6 +807,7 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
          password = utils::strip( password );
          checkInput( password, "empty password or phrase" );
          password = preProcessPassword( password );
+         checkBreached( password );
 
          if ( ! entry.addLabeledData( label, Data( password ) ) )
          {
@@ -725,6 +903,10 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
                std::cout << "No changes." << std::endl;
                break;
             }
+            if ( ! password.empty() )
+            {
+               checkBreached( password );
+            }
 
             if ( ! entry.updateLabeledData(
                      labeledDate.first,
@@ -950,6 +1132,102 @@ void EntryTask::run( std::shared_ptr<Instance>& instance )
             entry.getIdAsHexString() << "." << std::endl;
          break;
       }
+      case ROTATE:
+      {
+         const String tag( preProcessTag( instance, m_Id ) );
+         if ( instance->getTags().count( tag ) == 0 )
+         {
+            throw std::runtime_error( "tag not found" );
+         }
+
+         Set<String> filter;
+         filter.insert( tag );
+         Vector<Entry> entries( toSortedVector( instance->getEntries( filter ) ) );
+
+         // Passwords to rotate (keys and kept history are skipped).
+         Vector<std::pair<std::size_t,String>> rotations;
+         for ( std::size_t i = 0; i < entries.size(); ++i )
+         {
+            for ( const auto& labeledDate : toSortedVector( entries[ i ].getLabeledData() ) )
+            {
+               if ( labeledDate.second.getType() == DATA_TEXT && ! isHistoryLabel( labeledDate.first ) )
+               {
+                  rotations.push_back( std::make_pair( i, labeledDate.first ) );
+               }
+            }
+         }
+
+         if ( rotations.empty() )
+         {
+            std::cout << "No passwords tagged with " << tag << "." << std::endl;
+            break;
+         }
+
+         // Derive (and check) key once, encryption reuses the cached key.
+         utils::Reader reader( 1024 );
+         String password( reader.readLine( "password or phrase: ", true ) );
+         password = utils::strip( password );
+         checkInput( password, "empty password or phrase" );
+         instance->encryptEntries( password );
+
+         const Vector<String> secrets( utils::generatePasswords( ApgParams(), rotations.size() ) );
+
+         char date[ 16 ];
+         const std::time_t now( std::time( nullptr ) );
+         std::strftime( date, sizeof( date ), "%Y-%m-%d", std::localtime( &now ) );
+
+         // Keep old data (still encrypted) under history label.
+         for ( std::size_t i = 0; i < rotations.size(); ++i )
+         {
+            Entry& entry( entries[ rotations[ i ].first ] );
+            const String& label( rotations[ i ].second );
+            const Data old( entry.getLabeledData().at( label ) );
+
+            if ( ! entry.addLabeledData( getHistoryLabel( entry, label, date ), old ) ||
+                 ! entry.updateLabeledData( label, label, Data( secrets[ i ] ) )
+               )
+            {
+               throw std::runtime_error( "failed to rotate password" );
+            }
+         }
+
+         Set<std::size_t> rotated;
+         for ( const auto& rotation : rotations )
+         {
+            rotated.insert( rotation.first );
+         }
+         for ( const auto i : rotated )
+         {
+            if ( ! instance->updateEntry( entries[ i ] ) )
+            {
+               throw std::runtime_error( "failed to update entry" );
+            }
+         }
+         instance->encryptEntries( password );
+
+         std::cout << "Passwords tagged with " << tag << ":" << std::endl;
+         std::size_t i( 0 );
+         while ( i < rotations.size() )
+         {
+            const std::size_t first( i );
+            const Entry& entry( entries[ rotations[ i ].first ] );
+            std::cout << ( rotations.back().first != rotations[ i ].first ? utils::branch() : utils::corner() );
+            std::cout << "[#" << entry.getIdAsHexString() << "] "
+                      << utils::ESC_SEQ_BOLD
+                      << entry.getName()
+                      << utils::ESC_SEQ_RESET
+                      << ": ";
+            for ( ; i < rotations.size() && rotations[ i ].first == rotations[ first ].first; ++i )
+            {
+               std::cout << ( i > first ? ", " : "" ) << rotations[ i ].second;
+            }
+            std::cout << std::endl;
+         }
+         std::cout << "\nRotated " << rotations.size() << " password(s) of " << rotated.size() <<
+            " entr" << ( rotated.size() == 1 ? "y" : "ies" ) << ", old ones are kept as" <<
+            " 'LABEL" << HISTORY_PREFIX << date << ")'." << std::endl;
+         break;
+      }
       default:
       {
          throw std::runtime_error( "command not implemented yet" );
@@ -1016,6 +1294,11 @@ const Vector<uint8_t> EntryTask::askForInputFileAndRead( const Data* date )
    return data;
 }
 
+const String& EntryTask::getLastAddedId()
+{
+   return lastAddedId;
+}
+
 void EntryTask::decryptEntry( std::shared_ptr<Instance>& instance, Entry& entry )
 {
    if ( ! entry.isPlain() )
@@ -58,14 +58,15 @@ class EntryTask : public ICommand
          EXPORT_KEY,
          ADD_TAG,
          UPDATE_TAG,
-         DELETE_TAG
+         DELETE_TAG,
+         ROTATE
       };
 
       /**
        * Ctor for entry task.
        *
        * @param taskType the task type
-       * @param id the id of the entry
+       * @param id the id of the entry (or the tag for rotate task)
        * @param pos the position of the attribute or labeled data (starting with 1)
        */
       EntryTask( const Type taskType, const String& id = "", const String& pos = "" );
@@ -84,6 +85,8 @@ class EntryTask : public ICommand
        */
       virtual void run( std::shared_ptr<Instance>& instance );
 
+      static const String& getLastAddedId();
+
    private:
       /**
        * Decrypts the passed entry.
@@ -121,6 +124,8 @@ class EntryTask : public ICommand
       void checkInput( const String& input, const String& message );
 
       /** task type */
+      static String lastAddedId;
+
       const Type m_TaskType;
       /** the id of the entry to edit */
       String m_Id;
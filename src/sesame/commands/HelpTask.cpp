@@ -60,6 +60,24 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
             std::cout << ESC_SEQ_BOLD << "emacs" << ESC_SEQ_RESET << " or ";
             std::cout << ESC_SEQ_BOLD << "vi" << ESC_SEQ_RESET;
 
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "output" << ESC_SEQ_RESET;
+            std::cout << " (" << ESC_SEQ_BOLD << "text" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "json" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "msgpack" << ESC_SEQ_RESET << ")";
+            std::cout << "\n" << std::setw( 14 ) << " " << "sets output format of ";
+            std::cout << ESC_SEQ_BOLD << "list" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "tree" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "tags" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "search" << ESC_SEQ_RESET << " and ";
+            std::cout << ESC_SEQ_BOLD << "show" << ESC_SEQ_RESET << ",";
+            std::cout << "\n" << std::setw( 14 ) << " " << "json and msgpack write one record per entry";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "capacity" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "estimates how many bytes can be embedded into jpeg ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "(or a comma separated list of jpegs)";
+
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "clear" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "clears the screen";
 
@@ -70,9 +88,10 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
             std::cout << "\n" << std::setw( 14 ) << " " << "creates a new empty container";
 
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "open" << ESC_SEQ_RESET;
-            std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
-            std::cout << "\n" << std::setw( 14 ) << " " << "opens an existing container stored in ";
-            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "...";
+            std::cout << "\n" << std::setw( 14 ) << " " << "opens existing containers stored in ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "s";
+            std::cout << "\n" << std::setw( 14 ) << " " << "(or split across a comma separated list of jpegs)";
 
             std::cout << "\n" << std::endl;
          }
@@ -90,16 +109,83 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
             std::cout << ESC_SEQ_BOLD << "emacs" << ESC_SEQ_RESET << " or ";
             std::cout << ESC_SEQ_BOLD << "vi" << ESC_SEQ_RESET;
 
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "output" << ESC_SEQ_RESET;
+            std::cout << " (" << ESC_SEQ_BOLD << "text" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "json" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "msgpack" << ESC_SEQ_RESET << ")";
+            std::cout << "\n" << std::setw( 14 ) << " " << "sets output format of ";
+            std::cout << ESC_SEQ_BOLD << "list" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "tree" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "tags" << ESC_SEQ_RESET << ", ";
+            std::cout << ESC_SEQ_BOLD << "search" << ESC_SEQ_RESET << " and ";
+            std::cout << ESC_SEQ_BOLD << "show" << ESC_SEQ_RESET << ",";
+            std::cout << "\n" << std::setw( 14 ) << " " << "json and msgpack write one record per entry";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "capacity" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "estimates how many bytes can be embedded into jpeg ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "(or a comma separated list of jpegs)";
+
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "clear" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "clears the screen";
 
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "write " << ESC_SEQ_RESET;
             std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << " [" << ESC_SEQ_ULINE << "BACKUPS" << ESC_SEQ_RESET << "]";
             std::cout << "\n" << std::setw( 14 ) << " " << "writes current container to ";
             std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " or";
             std::cout << "\n" << std::setw( 14 ) << " " << "embeds container, if ";
             std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
             std::cout << " is a JPEG image";
+            std::cout << "\n" << std::setw( 14 ) << " " << "(matrix encoded to change fewer coefficients, if ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " is large enough)";
+            std::cout << "\n" << std::setw( 14 ) << " " << "splits container across jpegs, if ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " is a comma separated list of them";
+            std::cout << "\n" << std::setw( 14 ) << " " << "keeps ";
+            std::cout << ESC_SEQ_ULINE << "BACKUPS" << ESC_SEQ_RESET << " rolling backups (";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << ".1, ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << ".2, ...), if given";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "journal" << ESC_SEQ_RESET;
+            std::cout << " (" << ESC_SEQ_BOLD << "on" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "off" << ESC_SEQ_RESET << ")";
+            std::cout << "\n" << std::setw( 14 ) << " " << "enables or disables journal mode, ";
+            std::cout << ESC_SEQ_BOLD << "write" << ESC_SEQ_RESET << " appends changes";
+            std::cout << "\n" << std::setw( 14 ) << " " << "to the file read or written last in journal mode";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "compact " << ESC_SEQ_RESET;
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "folds the journal of ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " back into a full snapshot";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "convert" << ESC_SEQ_RESET;
+            std::cout << " (" << ESC_SEQ_BOLD << "v0" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "v1" << ESC_SEQ_RESET << ")";
+            std::cout << "\n" << std::setw( 14 ) << " " << "sets the container format used by ";
+            std::cout << ESC_SEQ_BOLD << "write" << ESC_SEQ_RESET;
+            std::cout << ", v1 (default) loads entries on demand";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "compress" << ESC_SEQ_RESET;
+            std::cout << " (" << ESC_SEQ_BOLD << "on" << ESC_SEQ_RESET << "|";
+            std::cout << ESC_SEQ_BOLD << "off" << ESC_SEQ_RESET << ")";
+            std::cout << "\n" << std::setw( 14 ) << " " << "enables or disables compression (deflate) of ";
+            std::cout << "entries before encryption (v1),";
+            std::cout << "\n" << std::setw( 14 ) << " " << "applied on next ";
+            std::cout << ESC_SEQ_BOLD << "write" << ESC_SEQ_RESET << " or ";
+            std::cout << ESC_SEQ_BOLD << "compact" << ESC_SEQ_RESET;
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "import " << ESC_SEQ_RESET;
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "adds the entries stored in ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " (.csv or .json),";
+            std::cout << "\n" << std::setw( 14 ) << " " << "CSV columns: name, tags, group, password, ";
+            std::cout << "password:LABEL, key:LABEL (hex), attributes";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "export " << ESC_SEQ_RESET;
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "writes all entries (unencrypted!) to ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << " (.csv or .json)";
 
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "recrypt" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " ";
@@ -108,6 +194,22 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "close" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "closes the current container";
 
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "new" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "creates a new empty container (others stay open)";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "open" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "...";
+            std::cout << "\n" << std::setw( 14 ) << " " << "opens further containers stored in ";
+            std::cout << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "s (others stay open)";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "containers" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "lists the open containers (current one is marked by *)";
+
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "switch" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "ID" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "makes the open container with ";
+            std::cout << ESC_SEQ_ULINE << "ID" << ESC_SEQ_RESET << " the current one";
+
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "quit" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "quits sesame";
 
@@ -132,6 +234,12 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "tags" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "lists all tags assigned to entries";
 
+            std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "rotate" << ESC_SEQ_RESET;
+            std::cout << " " << ESC_SEQ_ULINE << "TAG" << ESC_SEQ_RESET;
+            std::cout << "\n" << std::setw( 14 ) << " " << "replaces all passwords of entries tagged with ";
+            std::cout << ESC_SEQ_ULINE << "TAG" << ESC_SEQ_RESET << " by generated ones";
+            std::cout << "\n" << std::setw( 14 ) << " " << "(old ones are kept as history)";
+
             std::cout << "\n\n" << std::setw( 7 ) << " " << ESC_SEQ_BOLD << "add" << ESC_SEQ_RESET;
             std::cout << "\n" << std::setw( 14 ) << " " << "adds an entry to the current container";
 
@@ -204,7 +312,23 @@ void HelpTask::run( std::shared_ptr<Instance>& instance )
 
          std::cout << "\n\n" << std::setw( 7 ) << " ";
          std::cout << ESC_SEQ_BOLD << m_Program << ESC_SEQ_RESET;
-         std::cout << " [" << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "]";
+         std::cout << " [(-c " << ESC_SEQ_ULINE << "COMMANDS" << ESC_SEQ_RESET
+                   << "|-f " << ESC_SEQ_ULINE << "SCRIPT" << ESC_SEQ_RESET << ")";
+         std::cout << " [--password-fd " << ESC_SEQ_ULINE << "FD" << ESC_SEQ_RESET << "]]";
+         std::cout << " [" << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET << "...]";
+
+         std::cout << "\n" << std::setw( 7 ) << " ";
+         std::cout << ESC_SEQ_BOLD << m_Program << ESC_SEQ_RESET;
+         std::cout << " --agent";
+         std::cout << " [--password-fd " << ESC_SEQ_ULINE << "FD" << ESC_SEQ_RESET << "]";
+         std::cout << " " << ESC_SEQ_ULINE << "FILE" << ESC_SEQ_RESET;
+
+         std::cout << "\n" << std::setw( 7 ) << " ";
+         std::cout << ESC_SEQ_BOLD << m_Program << ESC_SEQ_RESET;
+         std::cout << " --query (list|search " << ESC_SEQ_ULINE << "PATTERN" << ESC_SEQ_RESET
+                   << "|show " << ESC_SEQ_ULINE << "ENTRY" << ESC_SEQ_RESET
+                   << "|export " << ESC_SEQ_ULINE << "ENTRY" << ESC_SEQ_RESET
+                   << " [" << ESC_SEQ_ULINE << "ID" << ESC_SEQ_RESET << "])";
 
          std::cout << "\n" << std::endl;
 
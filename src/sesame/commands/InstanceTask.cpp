@@ -25,46 +25,177 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 
 #include "sesame/Instance.hpp"
+#include "sesame/Session.hpp"
+#include "sesame/transfer.hpp"
 #include "sesame/commands/InstanceTask.hpp"
 #include "sesame/crypto/F4.hpp"
 #include "sesame/utils/filesystem.hpp"
+#include "sesame/utils/parallel.hpp"
+#include "sesame/utils/resources.hpp"
 #include "sesame/utils/string.hpp"
 #include "sesame/utils/Reader.hpp"
+#include "sesame/utils/RecordWriter.hpp"
 
 extern std::vector<std::pair<std::string,std::string>> apgCache;
 
 
 namespace sesame { namespace commands {
 
-InstanceTask::InstanceTask( const Type taskType, const String& path ) :
+namespace
+{
+   void checkCapacity( const String& path, const std::size_t capacity, const std::size_t size )
+   {
+      if ( size <= capacity )
+      {
+         return;
+      }
+
+      // Capacity grows with the number of pixels (at same quality).
+      StringStream s;
+      s << path << " holds about " << capacity << " bytes, container needs " << size << " bytes";
+      if ( capacity > 0 )
+      {
+         const std::size_t factor( ( ( size * 10 ) + capacity - 1 ) / capacity );
+         s << " (use a jpeg with about " << ( factor / 10 ) << "." << ( factor % 10 ) <<
+            " times as many pixels)";
+      }
+      throw std::runtime_error( s.str().c_str() );
+   }
+
+   bool isJpeg( const String& path )
+   {
+      String ext( utils::getExtension( path ) );
+      std::transform( ext.begin(), ext.end(), ext.begin(), ::toupper );
+
+      return ( "JPEG" == ext || "JPG" == ext );
+   }
+
+   // A comma separated list of jpeg images is a set of carriers sharing a container.
+   Vector<String> getCarriers( const String& path )
+   {
+      Vector<String> carriers;
+      StringStream s( path );
+      String carrier;
+      while ( std::getline( s, carrier, ',' ) )
+      {
+         if ( ! isJpeg( carrier ) )
+         {
+            return Vector<String>();
+         }
+         carriers.push_back( carrier );
+      }
+
+      return ( carriers.size() > 1 ) ? carriers : Vector<String>();
+   }
+
+   // Reads container from file or jpeg carrier(s), checks it and rewinds.
+   std::shared_ptr<std::istream> readContainer( const String& path, uint64_t& memory )
+   {
+      const Vector<String> carriers( getCarriers( path ) );
+
+      // open and parse first, carriers are checked on extraction
+      if ( carriers.empty() && ! utils::exists( path ) )
+      {
+         throw std::runtime_error( "file not found" );
+      }
+      else if ( carriers.empty() && ! utils::isFile( path ) )
+      {
+         StringStream s;
+         s << path << " is no file";
+         throw std::runtime_error( s.str().c_str() );
+      }
+
+      std::shared_ptr<std::istream> stream;
+
+      // No jpeg.
+      if ( carriers.empty() && ! isJpeg( path ) )
+      {
+         stream.reset( new std::ifstream( path.c_str(), std::ios_base::in | std::ios_base::binary ) );
+         if ( ! stream->good() )
+         {
+            throw std::runtime_error( "failed to open container" );
+         }
+      }
+      // Jpeg.
+      else
+      {
+         Vector<char> data;
+         crypto::F4 algorithm;
+         if ( carriers.empty() )
+         {
+            algorithm.extract( path, data );
+         }
+         else
+         {
+            algorithm.extract( carriers, data );
+         }
+         stream.reset( new StringStream( String( data.data(), data.size() ) ) );
+      }
+
+      memory = Instance::parse( *stream ).getMemory();
+
+      stream->clear();
+      stream->seekg( 0, std::ios_base::beg );
+
+      return stream;
+   }
+
+   /** A container to open. */
+   struct Opening
+   {
+      /** path to container */
+      String m_Path;
+      /** container data */
+      std::shared_ptr<std::istream> m_Stream;
+      /** memory needed to derive key */
+      uint64_t m_Memory;
+      /** password or phrase */
+      String m_Password;
+      /** the opened container */
+      std::shared_ptr<Instance> m_Instance;
+      /** error message if opening failed */
+      String m_Error;
+   };
+}
+
+InstanceTask::InstanceTask( const Type taskType, const String& path, const String& backups ) :
+   ICommand(),
+   m_TaskType( taskType ),
+   m_Path( path ),
+   m_Paths( 1, path ),
+   m_Backups( backups )
+{
+}
+
+InstanceTask::InstanceTask( const Type taskType, const Vector<String>& paths ) :
    ICommand(),
    m_TaskType( taskType ),
-   m_Path( path )
+   m_Path( paths.empty() ? String() : paths.front() ),
+   m_Paths( paths ),
+   m_Backups()
 {
 }
 
 void InstanceTask::run( std::shared_ptr<Instance>& instance )
 {
-   if ( m_TaskType == RECRYPT || m_TaskType == CLOSE || m_TaskType == WRITE )
+   if ( m_TaskType == RECRYPT || m_TaskType == CLOSE || m_TaskType == WRITE ||
+        m_TaskType == JOURNAL || m_TaskType == COMPACT || m_TaskType == CONVERT ||
+        m_TaskType == COMPRESS || m_TaskType == IMPORT || m_TaskType == EXPORT ||
+        m_TaskType == SWITCH || m_TaskType == CONTAINERS )
    {
       if ( ! instance )
       {
          throw std::runtime_error( "open container first" );
       }
    }
-   else
-   {
-      if ( instance )
-      {
-         throw std::runtime_error( "close container first" );
-      }
-   }
 
    switch ( m_TaskType )
    {
@@ -82,12 +213,8 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
          else if ( choice == u8"2" ) { ldN = 20; }
          else if ( choice == u8"3" ) { ldN = 21; }
          else { throw std::runtime_error( "invalid choice" ); }
-         Map<String,Vector<uint8_t>> params1;
-         {
-            Vector<uint8_t> ldNVector;
-            packV( ldNVector, ldN );
-            params1[ utils::fromUtf8( u8"ldN" ) ] = ldNVector;
-         }
+         crypto::KdfParams params1;
+         params1.m_LdN = ldN;
 
          std::cout << "Second you have to specify how much memory should be used for\n";
          std::cout << "derivation of the key used for encryption of the embedded secrets:" << std::endl;
@@ -97,88 +224,109 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
          else if ( choice == u8"2" ) { ldN = 17; }
          else if ( choice == u8"3" ) { ldN = 18; }
          else { throw std::runtime_error( "invalid choice" ); }
-         Map<String,Vector<uint8_t>> params2;
-         {
-            Vector<uint8_t> ldNVector;
-            packV( ldNVector, ldN );
-            params2[ utils::fromUtf8( u8"ldN" ) ] = ldNVector;
-         }
+         crypto::KdfParams params2;
+         params2.m_LdN = ldN;
 
+         // Containers open so far stay open.
          instance.reset( new Instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 ) );
+         Session::add( instance );
          std::cout << "Created new container #" <<
             instance->getIdAsHexString() << "." << std::endl;
          break;
       }
       case OPEN:
+      case UNLOCK:
       {
-         // open and parse first
-         if ( ! utils::exists( m_Path ) )
-         {
-            throw std::runtime_error( "file not found" );
-         }
-         else if ( ! utils::isFile( m_Path ) )
+         // Unlock: open and keep the keys to decrypt passwords/keys (agent).
+         const bool unlock( m_TaskType == UNLOCK );
+
+         // Read and check all containers before asking for passwords.
+         Vector<Opening> openings;
+         for ( auto& path : m_Paths )
          {
-            StringStream s;
-            s << m_Path << " is no file";
-            throw std::runtime_error( s.str().c_str() );
+            Opening opening;
+            opening.m_Path = path;
+            opening.m_Stream = readContainer( path, opening.m_Memory );
+            openings.push_back( opening );
          }
 
-         String ext( utils::getExtension( m_Path ) );
-         std::transform( ext.begin(), ext.end(), ext.begin(), ::toupper );
-
-         // No jpeg.
-         if ( "JPEG" != ext && "JPG" != ext )
+         utils::Reader reader( 1024 );
+         for ( auto& opening : openings )
          {
-            std::ifstream file( m_Path.c_str(), std::ios_base::in | std::ios_base::binary );
-            if ( ! file.good() )
+            String prompt( "password or phrase: " );
+            if ( openings.size() > 1 )
             {
-               throw std::runtime_error( "failed to open container" );
+               prompt = "password or phrase for " + opening.m_Path + ": ";
             }
+            opening.m_Password = utils::strip( reader.readLine( prompt, true ) );
 
-            Instance::parse( file );
-
-            // then try to construct
-            utils::Reader reader( 1024 );
-            String password( reader.readLine( "password or phrase: ", true ) );
-            password = utils::strip( password );
-
-            if ( password.empty() )
+            if ( opening.m_Password.empty() )
             {
                throw std::runtime_error( "empty password or phrase" );
             }
-
-            file.clear();
-            file.seekg( 0, std::ios_base::beg );
-            instance.reset( new Instance( file, password ) );
          }
-         // Jpeg.
-         else
-         {
-            StringStream stream;
-            Vector<char> data;
-            crypto::F4 algorithm;
-            algorithm.extract( m_Path, data );
-            String buf( data.data(), data.size() );
-            stream.str( buf );
 
-            Instance::parse( stream );
+         // Derive keys concurrently, but not more at once than fit into memory.
+         utils::runBudgeted(
+               openings,
+               [ unlock ]( Opening& opening )
+               {
+                  try
+                  {
+                     opening.m_Instance.reset( new Instance( *opening.m_Stream, opening.m_Password ) );
+                     if ( unlock )
+                     {
+                        opening.m_Instance->unlock( opening.m_Password );
+                     }
+                  }
+                  catch ( std::exception& e )
+                  {
+                     opening.m_Error = e.what();
+                  }
+                  opening.m_Password.clear();
+               },
+               []( const Opening& opening ) { return opening.m_Memory; },
+               utils::getAvailableMemory()
+               );
 
-            // then try to construct
-            utils::Reader reader( 1024 );
-            String password( reader.readLine( "password or phrase: ", true ) );
-            password = utils::strip( password );
+         // Open all or none.
+         Set<String> ids;
+         for ( auto& opening : openings )
+         {
+            if ( ! opening.m_Error.empty() )
+            {
+               throw std::runtime_error( ( openings.size() > 1 ?
+                        opening.m_Path + ": " + opening.m_Error : opening.m_Error ).c_str() );
+            }
 
-            if ( password.empty() )
+            const String id( opening.m_Instance->getIdAsHexString() );
+            bool open( ! ids.insert( id ).second );
+            for ( auto& other : Session::getInstances() )
             {
-               throw std::runtime_error( "empty password or phrase" );
+               open = open || ( other->getId() == opening.m_Instance->getId() );
             }
+            if ( open )
+            {
+               throw std::runtime_error( ( "container #" + id + " is already open" ).c_str() );
+            }
+         }
 
-            stream.clear();
-            stream.seekg( 0, std::ios_base::beg );
+         // Containers open so far stay open, the last one opened becomes current.
+         for ( auto& opening : openings )
+         {
+            instance = opening.m_Instance;
+            Session::add( instance );
 
-            instance.reset( new Instance( stream, password ) );
+            std::cout << "Opened container #" << instance->getIdAsHexString() << "." << std::endl;
+            if ( instance->isJournaled() )
+            {
+               std::cout << "Container has a journal, journal mode enabled." << std::endl;
+            }
+            if ( instance->getFormat() == FORMAT_V0 )
+            {
+               std::cout << "Container uses format v0, use 'convert v1' to upgrade it." << std::endl;
+            }
          }
-         std::cout << "Opened container #" << instance->getIdAsHexString() << "." << std::endl;
          break;
       }
       case RECRYPT:
@@ -211,12 +359,8 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
          else if ( choice == u8"2" ) { ldN = 20; }
          else if ( choice == u8"3" ) { ldN = 21; }
          else { throw std::runtime_error( "invalid choice" ); }
-         Map<String,Vector<uint8_t>> params1;
-         {
-            Vector<uint8_t> ldNVector;
-            packV( ldNVector, ldN );
-            params1[ utils::fromUtf8( u8"ldN" ) ] = ldNVector;
-         }
+         crypto::KdfParams params1;
+         params1.m_LdN = ldN;
 
          std::cout << "Second you have to specify how much memory should be used for\n";
          std::cout << "derivation of the key used for encryption of the embedded secrets:" << std::endl;
@@ -226,14 +370,11 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
          else if ( choice == u8"2" ) { ldN = 17; }
          else if ( choice == u8"3" ) { ldN = 18; }
          else { throw std::runtime_error( "invalid choice" ); }
-         Map<String,Vector<uint8_t>> params2;
-         {
-            Vector<uint8_t> ldNVector;
-            packV( ldNVector, ldN );
-            params2[ utils::fromUtf8( u8"ldN" ) ] = ldNVector;
-         }
+         crypto::KdfParams params2;
+         params2.m_LdN = ldN;
 
          std::shared_ptr<Instance> newInstance( new Instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 ) );
+         newInstance->setCompression( instance->getCompression() );
          Set<Entry> entries( instance->getEntries() );
          for ( auto& entry : entries )
          {
@@ -241,6 +382,7 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
             alias.clear();
             newInstance->addEntry( alias );
          }
+         Session::replace( instance, newInstance );
          instance = newInstance;
 
          std::cout << "Copied entries to new container #" << instance->getIdAsHexString() << ".\n";
@@ -250,12 +392,32 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
 
       case WRITE:
       {
-         String ext( utils::getExtension( m_Path ) );
-         std::transform( ext.begin(), ext.end(), ext.begin(), ::toupper );
+         getBackups(); // validate early
+         const Vector<String> carriers( getCarriers( m_Path ) );
 
          // No jpeg.
-         if ( "JPEG" != ext && "JPG" != ext )
+         if ( carriers.empty() && ! isJpeg( m_Path ) )
          {
+            // Journal mode? Append changes only, if file holds the container
+            // and neither format nor compression were changed.
+            if ( instance->isJournaled() && ! instance->isLayoutChanged() && utils::isFile( m_Path ) )
+            {
+               std::ifstream file( m_Path.c_str(), std::ios_base::in | std::ios_base::binary );
+               if ( file.good() && instance->isStoredIn( file ) )
+               {
+                  file.close();
+
+                  utils::Reader reader( 1024 );
+                  String password( reader.readLine( "password or phrase: ", true ) );
+                  password = utils::strip( password );
+
+                  const std::size_t count( instance->appendJournal( m_Path, password ) );
+                  std::cout << "Appended " << count << " change(s) of container #" <<
+                     instance->getIdAsHexString() << " to " << m_Path << std::endl;
+                  break;
+               }
+            }
+
             bool alreadyExists( utils::exists( m_Path.c_str() ) );
             if ( alreadyExists )
             {
@@ -277,16 +439,6 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
                }
             }
 
-            std::ofstream file(
-               m_Path.c_str(),
-               std::ios_base::out | std::ios_base::trunc | std::ios_base::binary
-               );
-
-            if ( ! file.good() )
-            {
-               throw std::runtime_error( "failed to open file" );
-            }
-
             utils::Reader reader( 1024 );
             String password( reader.readLine( "password or phrase: ", true ) );
             if ( instance->isNew() )
@@ -294,41 +446,41 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
                String confirmation( reader.readLine( "please confirm: ", true ) );
                if ( password != confirmation )
                {
-                  if ( ! alreadyExists )
-                  {
-                     file.close();
-                     utils::removeFile( m_Path );
-                  }
                   throw std::runtime_error( "confirmation failed" );
                }
             }
 
             password = utils::strip( password );
-            try
-            {
-               instance->write( file, password );
-               instance->recalcInitialDigest();
-               std::cout << "Wrote container #" << instance->getIdAsHexString() <<
-                  " to " << m_Path << std::endl;
-            }
-            catch ( std::runtime_error& )
+            Vector<char> dump;
             {
-               if ( ! alreadyExists )
-               {
-                  file.close();
-                  utils::removeFile( m_Path );
-               }
-               throw;
+               StringStream s;
+               instance->write( s, password );
+               readIntoVector( s, dump );
             }
+
+            // Never truncate the target, replace it atomically instead.
+            utils::writeFile( m_Path, dump.data(), dump.size(), getBackups() );
+            std::cout << "Wrote container #" << instance->getIdAsHexString() <<
+               " to " << m_Path << std::endl;
          }
          // Jpeg.
          else
          {
-            if ( ! utils::exists( m_Path.c_str() ) )
+            if ( carriers.empty() && ! utils::exists( m_Path.c_str() ) )
             {
                throw std::runtime_error( "file not found" );
             }
 
+            // Size of an unchanged container is known, fail before deriving keys.
+            // Matrix encoding is used as far as the image allows, it changes fewer coefficients.
+            crypto::F4 algorithm( crypto::F4::AUTO );
+            const std::size_t capacity( carriers.empty() ?
+               algorithm.getCapacity( m_Path ) : algorithm.getCapacity( carriers ) );
+            if ( ! instance->isDirty() )
+            {
+               checkCapacity( m_Path, capacity, instance->getSize() );
+            }
+
             utils::Reader reader( 1024 );
             String password( reader.readLine( "password or phrase: ", true ) );
             if ( instance->isNew() )
@@ -348,15 +500,242 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
                readIntoVector( s, dump );
             }
 
-            const String fileOut( utils::incrementFileName( m_Path ) );
-            crypto::F4 algorithm;
-            algorithm.embed( m_Path, fileOut, dump );
-            instance->recalcInitialDigest();
+            // Fail before transcoding the image.
+            checkCapacity( m_Path, capacity, dump.size() );
+
+            String fileOut;
+            if ( carriers.empty() )
+            {
+               fileOut = utils::incrementFileName( m_Path );
+               algorithm.embed( m_Path, fileOut, dump );
+            }
+            else
+            {
+               Vector<String> carriersOut;
+               for ( auto& carrier : carriers )
+               {
+                  carriersOut.push_back( utils::incrementFileName( carrier ) );
+                  fileOut += ( fileOut.empty() ? "" : "," ) + carriersOut.back();
+               }
+               algorithm.embed( carriers, carriersOut, dump );
+            }
             std::cout << "Wrote container #" << instance->getIdAsHexString() <<
                " to " << fileOut << std::endl;
          }
          break;
       }
+      case JOURNAL:
+      {
+         const String mode( utils::strip( utils::toUtf8( m_Path ) ) );
+         if ( mode == u8"on" )
+         {
+            instance->setJournaled( true );
+            std::cout << "Journal mode enabled, changes are appended on write." << std::endl;
+         }
+         else if ( mode == u8"off" )
+         {
+            instance->setJournaled( false );
+            std::cout << "Journal mode disabled." << std::endl;
+         }
+         else
+         {
+            throw std::runtime_error( "invalid mode" );
+         }
+         break;
+      }
+      case COMPACT:
+      {
+         {
+            std::ifstream file( m_Path.c_str(), std::ios_base::in | std::ios_base::binary );
+            if ( ! utils::isFile( m_Path ) || ! file.good() || ! instance->isStoredIn( file ) )
+            {
+               StringStream s;
+               s << m_Path << " doesn't hold current container";
+               throw std::runtime_error( s.str().c_str() );
+            }
+         }
+
+         utils::Reader reader( 1024 );
+         String password( reader.readLine( "password or phrase: ", true ) );
+         password = utils::strip( password );
+
+         Vector<char> dump;
+         {
+            StringStream s;
+            instance->write( s, password );
+            readIntoVector( s, dump );
+         }
+
+         utils::writeFile( m_Path, dump.data(), dump.size() );
+         std::cout << "Compacted container #" << instance->getIdAsHexString() <<
+            " in " << m_Path << std::endl;
+         break;
+      }
+      case CONVERT:
+      {
+         const String format( utils::strip( utils::toUtf8( m_Path ) ) );
+         if ( format == u8"v0" )
+         {
+            instance->setFormat( FORMAT_V0 );
+         }
+         else if ( format == u8"v1" )
+         {
+            instance->setFormat( FORMAT_V1 );
+         }
+         else
+         {
+            throw std::runtime_error( "invalid format" );
+         }
+         std::cout << "Container will be written in format " << m_Path << "." << std::endl;
+         std::cout << "Don't forget to write your changes!" << std::endl;
+         break;
+      }
+      case COMPRESS:
+      {
+         const String mode( utils::strip( utils::toUtf8( m_Path ) ) );
+         if ( mode == u8"on" )
+         {
+            instance->setCompression( COMPRESSION_DEFLATE );
+            std::cout << "Container will be written compressed." << std::endl;
+         }
+         else if ( mode == u8"off" )
+         {
+            instance->setCompression( COMPRESSION_NONE );
+            std::cout << "Container will be written uncompressed." << std::endl;
+         }
+         else
+         {
+            throw std::runtime_error( "invalid mode" );
+         }
+         if ( instance->getFormat() == FORMAT_V0 )
+         {
+            std::cout << "Format v0 doesn't support compression, use 'convert v1' first." << std::endl;
+         }
+         std::cout << "Don't forget to write (or compact) your changes!" << std::endl;
+         break;
+      }
+      case IMPORT:
+      {
+         const TransferFormat format( getTransferFormat( m_Path ) );
+         std::ifstream file( m_Path.c_str(), std::ios_base::in | std::ios_base::binary );
+         if ( ! file.good() )
+         {
+            throw std::runtime_error( "failed to open file" );
+         }
+
+         // Progress isn't useful in scripts.
+         const bool showProgress( ! utils::Reader::isBatchMode() );
+         bool progressShown( false );
+         auto progress = [ & ]( const std::size_t count )
+         {
+            if ( showProgress )
+            {
+               std::cout << "\rRead " << count << " entries..." << std::flush;
+               progressShown = true;
+            }
+         };
+
+         const auto start( std::chrono::steady_clock::now() );
+         std::size_t count;
+         try
+         {
+            count = importEntries( *instance, file, format, progress );
+         }
+         catch ( std::runtime_error& )
+         {
+            if ( progressShown )
+            {
+               std::cout << std::endl;
+            }
+            throw;
+         }
+         const std::chrono::duration<double> seconds( std::chrono::steady_clock::now() - start );
+
+         std::cout << ( progressShown ? "\r" : "" ) << "Imported " << count << " entries ("
+                   << static_cast<uint64_t>( count / std::max( seconds.count(), 1e-6 ) )
+                   << " entries/s)." << std::endl;
+         std::cout << "Don't forget to write (or compact) your changes!" << std::endl;
+         break;
+      }
+      case EXPORT:
+      {
+         const TransferFormat format( getTransferFormat( m_Path ) );
+
+         if ( ! instance->isPlain() )
+         {
+            // decrypt first
+            utils::Reader reader( 1024 );
+            String password( reader.readLine( "password or phrase: ", true ) );
+            password = utils::strip( password );
+
+            if ( password.empty() )
+            {
+               throw std::runtime_error( "empty password or phrase" );
+            }
+
+            instance->decryptEntries( password );
+         }
+
+         const auto start( std::chrono::steady_clock::now() );
+         StringStream s;
+         const std::size_t count( exportEntries( *instance, s, format ) );
+         const String data( s.str() );
+         utils::writeFile( m_Path, data.data(), data.size() );
+         const std::chrono::duration<double> seconds( std::chrono::steady_clock::now() - start );
+
+         std::cout << "Exported " << count << " entries to " << m_Path << " ("
+                   << static_cast<uint64_t>( count / std::max( seconds.count(), 1e-6 ) )
+                   << " entries/s)." << std::endl;
+         std::cout << "Passwords and keys are stored unencrypted, keep the file safe!" << std::endl;
+         break;
+      }
+      case OUTPUT:
+      {
+         const String format( utils::strip( utils::toUtf8( m_Path ) ) );
+         if ( format == u8"text" )
+         {
+            utils::RecordWriter::setFormat( OUTPUT_TEXT );
+         }
+         else if ( format == u8"json" )
+         {
+            utils::RecordWriter::setFormat( OUTPUT_JSON );
+         }
+         else if ( format == u8"msgpack" )
+         {
+            utils::RecordWriter::setFormat( OUTPUT_MSGPACK );
+         }
+         else
+         {
+            throw std::runtime_error( "invalid format" );
+         }
+         break;
+      }
+      case CAPACITY:
+      {
+         const Vector<String> carriers( getCarriers( m_Path ) );
+         if ( carriers.empty() && ! utils::isFile( m_Path ) )
+         {
+            throw std::runtime_error( "file not found" );
+         }
+
+         if ( carriers.empty() && ! isJpeg( m_Path ) )
+         {
+            throw std::runtime_error( "no jpeg" );
+         }
+
+         crypto::F4 algorithm;
+         const std::size_t capacity( carriers.empty() ?
+            algorithm.getCapacity( m_Path ) : algorithm.getCapacity( carriers ) );
+         std::cout << m_Path << " holds about " << capacity << " bytes." << std::endl;
+
+         if ( instance && instance->getSize() > 0 )
+         {
+            std::cout << "Container #" << instance->getIdAsHexString() << " needs about " <<
+               instance->getSize() << " bytes" << ( instance->isDirty() ? " (as read or written last)" : "" ) <<
+               ", it " << ( instance->getSize() <= capacity ? "fits." : "doesn't fit." ) << std::endl;
+         }
+         break;
+      }
       case CLOSE:
       {
          apgCache.resize( 0 );
@@ -372,7 +751,28 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
             }
          }
          std::cout << "Closed container #" << instance->getIdAsHexString() << "." << std::endl;
-         instance.reset();
+         instance = Session::remove( instance );
+         crypto::F4::clearCache();
+         if ( instance )
+         {
+            std::cout << "Switched to container #" << instance->getIdAsHexString() << "." << std::endl;
+         }
+         break;
+      }
+      case SWITCH:
+      {
+         instance = Session::find( m_Path );
+         std::cout << "Switched to container #" << instance->getIdAsHexString() << "." << std::endl;
+         break;
+      }
+      case CONTAINERS:
+      {
+         for ( auto& other : Session::getInstances() )
+         {
+            std::cout << ( other == instance ? "* " : "  " ) << "#" << other->getIdAsHexString() <<
+               ": " << other->getNumOfEntries() << " entries" <<
+               ( other->isDirty() ? ", modified" : "" ) << std::endl;
+         }
          break;
       }
       default:
@@ -382,4 +782,23 @@ void InstanceTask::run( std::shared_ptr<Instance>& instance )
    }
 }
 
+std::size_t InstanceTask::getBackups() const
+{
+   std::size_t backups( 0 );
+
+   if ( ! m_Backups.empty() )
+   {
+      const String digits( utils::toUtf8( m_Backups ) );
+      if ( ! std::all_of( digits.begin(), digits.end(), ::isdigit ) )
+      {
+         throw std::runtime_error( "invalid number of backups" );
+      }
+
+      StringStream s( digits );
+      s >> backups;
+   }
+
+   return backups;
+}
+
 } }
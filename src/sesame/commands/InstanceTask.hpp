@@ -42,7 +42,18 @@ class InstanceTask : public ICommand
          OPEN,
          RECRYPT,
          WRITE,
-         CLOSE
+         JOURNAL,
+         COMPACT,
+         CONVERT,
+         COMPRESS,
+         IMPORT,
+         EXPORT,
+         OUTPUT,
+         CAPACITY,
+         CLOSE,
+         SWITCH,
+         CONTAINERS,
+         UNLOCK
       };
 
       /**
@@ -50,8 +61,23 @@ class InstanceTask : public ICommand
        *
        * @param taskType the task type
        * @param path path to sesame file to consider by task
+       *     (or <tt>on</tt>/<tt>off</tt> for journal task,
+       *     <tt>v0</tt>/<tt>v1</tt> for convert task,
+       *     <tt>on</tt>/<tt>off</tt> for compress task,
+       *     <tt>text</tt>/<tt>json</tt>/<tt>msgpack</tt> for output task,
+       *     jpeg image to check for capacity task,
+       *     id of the container to switch to for switch task)
+       * @param backups number of rolling backups to keep on write
        */
-      InstanceTask( const Type taskType, const String& path = "" );
+      InstanceTask( const Type taskType, const String& path = "", const String& backups = "" );
+
+      /**
+       * Ctor for instance task with several paths (open task).
+       *
+       * @param taskType the task type
+       * @param paths paths to sesame files to consider by task
+       */
+      InstanceTask( const Type taskType, const Vector<String>& paths );
 
       /**
        * Dtor.
@@ -68,10 +94,23 @@ class InstanceTask : public ICommand
       virtual void run( std::shared_ptr<Instance>& instance );
 
    private:
+      /**
+       * Returns the number of rolling backups to keep on write.
+       *
+       * @return the number of backups
+       *
+       * @throw std::runtime_error if number of backups is invalid
+       */
+      std::size_t getBackups() const;
+
       /** task type */
       const Type m_TaskType;
       /** path to the sesame file */
       String m_Path;
+      /** paths to the sesame files (open task) */
+      Vector<String> m_Paths;
+      /** number of rolling backups (FILE.1 ... FILE.N) to keep on write */
+      String m_Backups;
 };
 
 } }
@@ -23,57 +23,323 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
 #include <stdexcept>
 
 #include "sesame/crypto/F4.hpp"
 #include "sesame/crypto/jpegtranf4.h"
 #include "sesame/utils/filesystem.hpp"
+#include "sesame/utils/parallel.hpp"
 
 
 namespace sesame { namespace crypto {
 
-void F4::embed(
-   const String& fileNameIn,
-   const String& fileNameOut,
-   const Vector<char>& data
-   )
-   const
+namespace
 {
-   if ( data.size() == 0 )
+   // Cover decoded last, repeated writes to the same image only re-embed.
+   struct CachedCover
+   {
+      ~CachedCover()
+      {
+         f4_cover_close( m_Cover );
+      }
+
+      String m_Path;
+      std::size_t m_Size = 0;
+      uint64_t m_ModificationTime = 0;
+      f4_cover* m_Cover = nullptr;
+   };
+
+   std::mutex coverMutex;
+   CachedCover cachedCover;
+
+   // Data of each carrier of a split container starts with
+   // PART_MAGIC, id of set, index, number of carriers (16 bit each)
+   // and length of the container (32 bit), all big endian.
+   const char PART_MAGIC[] = "SFP1";
+   const std::size_t PART_MAGIC_SIZE( 4 );
+   const std::size_t PART_HEADER_SIZE( 16 );
+
+   // Carrier of a split container, processed by a thread of its own.
+   struct Carrier
    {
-      throw std::runtime_error( "nothing to embed" );
+      Carrier() = default;
+      Carrier( const Carrier& ) = delete;
+      Carrier& operator=( const Carrier& ) = delete;
+
+      ~Carrier()
+      {
+         f4_cover_close( m_Cover );
+      }
+
+      String m_FileNameIn;
+      String m_FileNameOut;
+      f4_cover* m_Cover = nullptr;
+      std::size_t m_Capacity = 0;
+      Vector<char> m_Data;
+   };
+
+   void putBigEndian( char* out, const std::size_t value, const std::size_t bytes )
+   {
+      for ( std::size_t i = 0; i < bytes; ++i )
+      {
+         out[ i ] = static_cast<char>( ( value >> ( 8 * ( bytes - i - 1 ) ) ) & 0xff );
+      }
+   }
+
+   std::size_t getBigEndian( const char* in, const std::size_t bytes )
+   {
+      std::size_t value( 0 );
+      for ( std::size_t i = 0; i < bytes; ++i )
+      {
+         value = ( value << 8 ) | static_cast<unsigned char>( in[ i ] );
+      }
+
+      return value;
+   }
+
+   void readImage( const String& fileNameIn, Vector<char>& image )
+   {
+      if ( ! utils::isFile( fileNameIn ) )
+      {
+         StringStream s;
+         s << "failed to open " << fileNameIn;
+         throw std::runtime_error( s.str().c_str() );
+      }
+
+      image.resize( utils::getFileSize( fileNameIn ) );
+      std::ifstream file( fileNameIn.c_str(), std::ios_base::in | std::ios_base::binary );
+      if ( ! file.read( image.data(), image.size() ) )
+      {
+         StringStream s;
+         s << "failed to open " << fileNameIn;
+         throw std::runtime_error( s.str().c_str() );
+      }
    }
 
-   int rc( f4_embed( fileNameIn.c_str(), fileNameOut.c_str(), data.data(), data.size() ) );
+   // Parts of split containers are useless on their own.
+   void checkNoPart( const Vector<char>& data, const String& fileNameIn )
+   {
+      if ( data.size() >= PART_HEADER_SIZE && std::memcmp( data.data(), PART_MAGIC, PART_MAGIC_SIZE ) == 0 )
+      {
+         StringStream s;
+         s << fileNameIn << " holds part " << ( getBigEndian( data.data() + 8, 2 ) + 1 ) << " of " <<
+            getBigEndian( data.data() + 10, 2 ) << " of a container, open all of them";
+         throw std::runtime_error( s.str().c_str() );
+      }
+   }
 
-   if ( rc != 0 )
+   void frame( const Vector<char>& data, const int k, Vector<char>& framed )
    {
-      if ( utils::isFile( fileNameOut ) )
+      if ( data.size() == 0 )
       {
-         utils::removeFile( fileNameOut );
+         throw std::runtime_error( "nothing to embed" );
       }
 
+      if ( data.size() > UINT32_MAX )
+      {
+         throw std::runtime_error( "too much data to embed" );
+      }
+
+      // Prefix data with a header, extract() stops once payload is complete.
+      framed.resize( F4_HEADER_SIZE + data.size() );
+      std::memcpy( framed.data(), F4_MAGIC, F4_MAGIC_SIZE );
+      framed[ F4_MAGIC_SIZE - 1 ] = static_cast<char>( '0' + k );
+      putBigEndian( framed.data() + F4_MAGIC_SIZE, data.size(), 4 );
+      std::copy( data.begin(), data.end(), framed.begin() + F4_HEADER_SIZE );
+   }
+
+   f4_cover* openCover( const char* image, const std::size_t size )
+   {
+      f4_cover* cover( nullptr );
+      int rc( f4_cover_open( image, size, &cover ) );
+
       switch ( rc )
       {
-         case 1:
+         case 0:
+            return cover;
          case 2:
+            throw std::runtime_error( "out of memory" );
+         default:
             throw std::runtime_error( "internal libjpeg-turbo error" );
-         case 3:
+      }
+   }
+
+   // Caller has to hold coverMutex.
+   f4_cover* getCover( const String& fileNameIn )
+   {
+      if ( ! utils::isFile( fileNameIn ) )
+      {
+         StringStream s;
+         s << "failed to open " << fileNameIn;
+         throw std::runtime_error( s.str().c_str() );
+      }
+
+      const std::size_t size( utils::getFileSize( fileNameIn ) );
+      const uint64_t modificationTime( utils::getModificationTime( fileNameIn ) );
+
+      if ( cachedCover.m_Cover != nullptr && cachedCover.m_Path == fileNameIn &&
+           cachedCover.m_Size == size && cachedCover.m_ModificationTime == modificationTime )
+      {
+         return cachedCover.m_Cover;
+      }
+
+      Vector<char> image;
+      readImage( fileNameIn, image );
+
+      f4_cover* cover( openCover( image.data(), image.size() ) );
+
+      f4_cover_close( cachedCover.m_Cover );
+      cachedCover.m_Path = fileNameIn;
+      cachedCover.m_Size = size;
+      cachedCover.m_ModificationTime = modificationTime;
+      cachedCover.m_Cover = cover;
+
+      return cover;
+   }
+
+   std::size_t estimateCapacity( f4_cover* cover, const int k )
+   {
+      std::size_t capacity( 0 );
+      if ( f4_cover_capacity( cover, k, &capacity ) != 0 )
+      {
+         throw std::runtime_error( "internal libjpeg-turbo error" );
+      }
+
+      // Header is not available for data.
+      return ( capacity > F4_HEADER_SIZE ) ? ( capacity - F4_HEADER_SIZE ) : 0;
+   }
+
+   // Returns image allocated by libjpeg-turbo, to be released by free().
+   char* embedInto( f4_cover* cover, const Vector<char>& data, const int k, std::size_t& size )
+   {
+      // Fewest changes first, a failed attempt costs about as much as an estimate.
+      for ( int current( ( k == F4::AUTO ) ? F4_MAX_K : k ); ; --current )
+      {
+         Vector<char> framed;
+         frame( data, current, framed );
+
+         char* image( nullptr );
+         int rc( f4_cover_embed( cover, framed.data(), framed.size(), &image, &size ) );
+
+         switch ( rc )
          {
-            StringStream s;
-            s << "failed to open " << fileNameIn;
-            throw std::runtime_error( s.str().c_str() );
+            case 0:
+               return image;
+            case 1:
+            case 2:
+               throw std::runtime_error( "internal libjpeg-turbo error" );
+            default:
+               if ( k != F4::AUTO || current == 1 )
+               {
+                  throw std::runtime_error( "failed to embed data" );
+               }
          }
-         case 5:
+      }
+   }
+
+   void checkExtracted( const int rc, const String& fileNameIn )
+   {
+      switch ( rc )
+      {
+         case 0:
+            return;
+         case 1:
+            throw std::runtime_error( "internal libjpeg-turbo error" );
+         case 2:
          {
             StringStream s;
-            s << "failed to open " << fileNameOut;
+            s << "failed to open " << fileNameIn;
             throw std::runtime_error( s.str().c_str() );
          }
          default:
-            throw std::runtime_error( "failed to embed data" );
+            throw std::runtime_error( "failed to extract data" );
       }
    }
+
+   void extractFile( const String& fileNameIn, Vector<char>& data )
+   {
+      // We expect max 20% of the image as data.
+      data.resize( utils::getFileSize( fileNameIn ) / 5 );
+
+      if ( data.size() <= F4_HEADER_SIZE )
+      {
+         throw std::runtime_error( "failed to extract data" );
+      }
+
+      std::size_t extracted( 0 );
+      checkExtracted( f4_extract( fileNameIn.c_str(), data.data(), data.size(), &extracted ), fileNameIn );
+      data.resize( extracted );
+   }
+}
+
+const int F4::AUTO( 0 );
+
+F4::F4( const int k )
+   : m_K( k )
+{
+   if ( k != AUTO && ( k < 1 || k > F4_MAX_K ) )
+   {
+      throw std::runtime_error( "invalid matrix encoding" );
+   }
+}
+
+void F4::embed(
+   const String& fileNameIn,
+   const String& fileNameOut,
+   const Vector<char>& data
+   )
+   const
+{
+   std::lock_guard<std::mutex> lock( coverMutex );
+
+   std::size_t size( 0 );
+   char* image( embedInto( getCover( fileNameIn ), data, m_K, size ) );
+
+   try
+   {
+      utils::writeFile( fileNameOut, image, size );
+   }
+   catch ( ... )
+   {
+      std::free( image );
+      throw;
+   }
+
+   std::free( image );
+}
+
+void F4::embed(
+   const Vector<char>& imageIn,
+   Vector<char>& imageOut,
+   const Vector<char>& data
+   )
+   const
+{
+   f4_cover* cover( openCover( imageIn.data(), imageIn.size() ) );
+
+   std::size_t size( 0 );
+   char* image( nullptr );
+
+   try
+   {
+      image = embedInto( cover, data, m_K, size );
+   }
+   catch ( ... )
+   {
+      f4_cover_close( cover );
+      throw;
+   }
+
+   f4_cover_close( cover );
+   imageOut.assign( image, image + size );
+   std::free( image );
 }
 
 void F4::extract(
@@ -81,33 +347,257 @@ void F4::extract(
    Vector<char>& data
    )
    const
+{
+   extractFile( fileNameIn, data );
+   checkNoPart( data, fileNameIn );
+}
+
+void F4::extract(
+   const Vector<char>& image,
+   Vector<char>& data
+   )
+   const
 {
    // We expect max 20% of the image as data.
-   data.resize( utils::getFileSize( fileNameIn ) / 5 );
+   data.resize( image.size() / 5 );
 
-   if ( data.size() == 0 )
+   if ( data.size() <= F4_HEADER_SIZE )
    {
       throw std::runtime_error( "failed to extract data" );
    }
 
-   int rc( f4_extract( fileNameIn.c_str(), data.data(), data.size() ) );
+   std::size_t extracted( 0 );
+   checkExtracted( f4_extract_mem( image.data(), image.size(), data.data(), data.size(), &extracted ), "image" );
+   data.resize( extracted );
+   checkNoPart( data, "image" );
+}
 
-   if ( rc != 0 )
+std::size_t F4::getCapacity(
+   const String& fileNameIn
+   )
+   const
+{
+   std::lock_guard<std::mutex> lock( coverMutex );
+
+   return estimateCapacity( getCover( fileNameIn ), ( m_K == AUTO ) ? 1 : m_K );
+}
+
+void F4::embed(
+   const Vector<String>& fileNamesIn,
+   const Vector<String>& fileNamesOut,
+   const Vector<char>& data
+   )
+   const
+{
+   if ( fileNamesIn.empty() || fileNamesIn.size() != fileNamesOut.size() )
    {
-      switch ( rc )
+      throw std::runtime_error( "invalid carriers" );
+   }
+
+   if ( fileNamesIn.size() > UINT16_MAX )
+   {
+      throw std::runtime_error( "too many carriers" );
+   }
+
+   if ( data.size() > UINT32_MAX )
+   {
+      throw std::runtime_error( "too much data to embed" );
+   }
+
+   Vector<Carrier> carriers( fileNamesIn.size() );
+   for ( std::size_t i = 0; i < carriers.size(); ++i )
+   {
+      carriers[ i ].m_FileNameIn = fileNamesIn[ i ];
+      carriers[ i ].m_FileNameOut = fileNamesOut[ i ];
+   }
+
+   // One libjpeg pipeline per carrier, covers are not cached.
+   utils::runParallel( carriers, []( Carrier& carrier )
+   {
+      Vector<char> image;
+      readImage( carrier.m_FileNameIn, image );
+      carrier.m_Cover = openCover( image.data(), image.size() );
+      carrier.m_Capacity = estimateCapacity( carrier.m_Cover, 1 );
+      carrier.m_Capacity -= std::min( carrier.m_Capacity, PART_HEADER_SIZE );
+   } );
+
+   std::size_t capacity( 0 );
+   for ( auto& carrier : carriers )
+   {
+      if ( carrier.m_Capacity == 0 )
       {
-         case 1:
-            throw std::runtime_error( "internal libjpeg-turbo error" );
-         case 2:
-         {
-            StringStream s;
-            s << "failed to open " << fileNameIn;
-            throw std::runtime_error( s.str().c_str() );
-         }
-         default:
-            throw std::runtime_error( "failed to extract data" );
+         StringStream s;
+         s << carrier.m_FileNameIn << " is too small to carry data";
+         throw std::runtime_error( s.str().c_str() );
+      }
+      capacity += carrier.m_Capacity;
+   }
+
+   if ( capacity < data.size() )
+   {
+      StringStream s;
+      s << "carriers hold about " << capacity << " bytes, container needs " << data.size() << " bytes";
+      throw std::runtime_error( s.str().c_str() );
+   }
+
+   // Split data in proportion to capacities, so all carriers take about the same time.
+   Vector<std::size_t> lengths( carriers.size() );
+   std::size_t assigned( 0 );
+   for ( std::size_t i = 0; i < carriers.size(); ++i )
+   {
+      lengths[ i ] = ( data.size() * carriers[ i ].m_Capacity ) / capacity;
+      assigned += lengths[ i ];
+   }
+   for ( std::size_t i = 0; assigned < data.size(); ++i )
+   {
+      if ( lengths[ i ] < carriers[ i ].m_Capacity )
+      {
+         ++lengths[ i ];
+         ++assigned;
       }
    }
+
+   std::random_device random;
+   const uint32_t setId( random() );
+   std::size_t offset( 0 );
+   for ( std::size_t i = 0; i < carriers.size(); ++i )
+   {
+      Vector<char>& part( carriers[ i ].m_Data );
+      part.resize( PART_HEADER_SIZE + lengths[ i ] );
+      std::memcpy( part.data(), PART_MAGIC, PART_MAGIC_SIZE );
+      putBigEndian( part.data() + 4, setId, 4 );
+      putBigEndian( part.data() + 8, i, 2 );
+      putBigEndian( part.data() + 10, carriers.size(), 2 );
+      putBigEndian( part.data() + 12, data.size(), 4 );
+      std::copy( data.begin() + offset, data.begin() + offset + lengths[ i ], part.begin() + PART_HEADER_SIZE );
+      offset += lengths[ i ];
+   }
+
+   const int k( m_K );
+   utils::runParallel( carriers, [ k ]( Carrier& carrier )
+   {
+      std::size_t size( 0 );
+      char* image( embedInto( carrier.m_Cover, carrier.m_Data, k, size ) );
+
+      try
+      {
+         utils::writeFile( carrier.m_FileNameOut, image, size );
+      }
+      catch ( ... )
+      {
+         std::free( image );
+         throw;
+      }
+
+      std::free( image );
+   } );
+}
+
+void F4::extract(
+   const Vector<String>& fileNamesIn,
+   Vector<char>& data
+   )
+   const
+{
+   if ( fileNamesIn.empty() )
+   {
+      throw std::runtime_error( "invalid carriers" );
+   }
+
+   Vector<Carrier> carriers( fileNamesIn.size() );
+   for ( std::size_t i = 0; i < carriers.size(); ++i )
+   {
+      carriers[ i ].m_FileNameIn = fileNamesIn[ i ];
+   }
+
+   utils::runParallel( carriers, []( Carrier& carrier )
+   {
+      extractFile( carrier.m_FileNameIn, carrier.m_Data );
+   } );
+
+   // Order parts by index, all of them have to belong to the same set.
+   Vector<const Carrier*> parts( carriers.size(), nullptr );
+   std::size_t setId( 0 );
+   std::size_t length( 0 );
+   std::size_t extracted( 0 );
+   for ( auto& carrier : carriers )
+   {
+      const Vector<char>& part( carrier.m_Data );
+      if ( part.size() < PART_HEADER_SIZE || std::memcmp( part.data(), PART_MAGIC, PART_MAGIC_SIZE ) != 0 )
+      {
+         StringStream s;
+         s << carrier.m_FileNameIn << " holds no part of a container";
+         throw std::runtime_error( s.str().c_str() );
+      }
+
+      const std::size_t index( getBigEndian( part.data() + 8, 2 ) );
+      if ( &carrier == &carriers.front() )
+      {
+         setId = getBigEndian( part.data() + 4, 4 );
+         length = getBigEndian( part.data() + 12, 4 );
+      }
+
+      if ( getBigEndian( part.data() + 4, 4 ) != setId || getBigEndian( part.data() + 12, 4 ) != length ||
+           getBigEndian( part.data() + 10, 2 ) != carriers.size() || index >= parts.size() ||
+           parts[ index ] != nullptr )
+      {
+         StringStream s;
+         s << carrier.m_FileNameIn << " holds a part of another container";
+         throw std::runtime_error( s.str().c_str() );
+      }
+
+      parts[ index ] = &carrier;
+      extracted += part.size() - PART_HEADER_SIZE;
+   }
+
+   if ( extracted != length )
+   {
+      throw std::runtime_error( "failed to extract data" );
+   }
+
+   data.clear();
+   data.reserve( length );
+   for ( auto part : parts )
+   {
+      data.insert( data.end(), part->m_Data.begin() + PART_HEADER_SIZE, part->m_Data.end() );
+   }
+}
+
+std::size_t F4::getCapacity(
+   const Vector<String>& fileNamesIn
+   )
+   const
+{
+   Vector<Carrier> carriers( fileNamesIn.size() );
+   for ( std::size_t i = 0; i < carriers.size(); ++i )
+   {
+      carriers[ i ].m_FileNameIn = fileNamesIn[ i ];
+   }
+
+   const int k( ( m_K == AUTO ) ? 1 : m_K );
+   utils::runParallel( carriers, [ k ]( Carrier& carrier )
+   {
+      // Same return codes as f4_extract().
+      checkExtracted( f4_capacity( carrier.m_FileNameIn.c_str(), k, &carrier.m_Capacity ), carrier.m_FileNameIn );
+   } );
+
+   // Headers are not available for data.
+   std::size_t capacity( 0 );
+   for ( auto& carrier : carriers )
+   {
+      capacity += carrier.m_Capacity - std::min( carrier.m_Capacity, F4_HEADER_SIZE + PART_HEADER_SIZE );
+   }
+
+   return capacity;
+}
+
+void F4::clearCache()
+{
+   std::lock_guard<std::mutex> lock( coverMutex );
+
+   f4_cover_close( cachedCover.m_Cover );
+   cachedCover.m_Cover = nullptr;
+   cachedCover.m_Path.clear();
 }
 
 } }
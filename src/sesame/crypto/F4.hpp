@@ -36,7 +36,11 @@ namespace sesame { namespace crypto {
 class F4
 {
    public:
-      F4() = default;
+      // Selects the largest k data still fits in, down to plain F4.
+      static const int AUTO;
+
+      // k > 1 selects matrix encoding with a (1, 2^k - 1, k) Hamming code.
+      explicit F4( const int k = 1 );
 
       virtual ~F4() = default;
 
@@ -46,11 +50,48 @@ class F4
          const Vector<char>& data
          ) const;
 
+      void embed(
+         const Vector<char>& imageIn,
+         Vector<char>& imageOut,
+         const Vector<char>& data
+         ) const;
+
       void extract(
          const String& fileNameIn,
          Vector<char>& data
          ) const;
 
+      void extract(
+         const Vector<char>& image,
+         Vector<char>& data
+         ) const;
+
+      std::size_t getCapacity(
+         const String& fileNameIn
+         ) const;
+
+      // Splits data across carriers (in order), each carrier is
+      // processed by a thread of its own.
+      void embed(
+         const Vector<String>& fileNamesIn,
+         const Vector<String>& fileNamesOut,
+         const Vector<char>& data
+         ) const;
+
+      // Carriers may be given in any order.
+      void extract(
+         const Vector<String>& fileNamesIn,
+         Vector<char>& data
+         ) const;
+
+      std::size_t getCapacity(
+         const Vector<String>& fileNamesIn
+         ) const;
+
+      static void clearCache();
+
+   private:
+      const int m_K;
 };
 
 } }
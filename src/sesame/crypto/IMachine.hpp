@@ -27,6 +27,7 @@
 #define SESAME_CRYPTO_IMACHINE
 
 #include "types.hpp"
+#include "sesame/crypto/KdfParams.hpp"
 
 namespace sesame { namespace crypto {
 
@@ -167,8 +168,7 @@ class IMachine
       /**
        * Derives <tt>key</tt> from <tt>password</tt>
        * considering passed params. If params not complete,
-       * defaults are used. Params are passed as Map,
-       * keys are strings, values are packed in msgpack format.
+       * defaults are used.
        *
        * @param password the password
        * @param[in,out] params params to consider
@@ -178,7 +178,7 @@ class IMachine
        */
       virtual bool deriveKey(
          const String& password,
-         Map<String,Vector<uint8_t>>& params,
+         KdfParams& params,
          Vector<uint8_t>& key
          ) = 0;
 
@@ -190,7 +190,7 @@ class IMachine
        *
        * @return <tt>true</tt> for success, otherwise <tt>false</tt>
        */
-      virtual bool getKeyDerivationParams( Map<String,Vector<uint8_t>>& params ) = 0;
+      virtual bool getKeyDerivationParams( KdfParams& params ) = 0;
 
       /**
        * Generates a random token of passed <tt>length</tt>.
@@ -0,0 +1,96 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifndef SESAME_CRYPTO_KDFPARAMS_HPP
+#define SESAME_CRYPTO_KDFPARAMS_HPP
+
+#include <cstdint>
+#include "types.hpp"
+
+namespace sesame { namespace crypto {
+
+/**
+ * Params of key derivation (scrypt). Params set to zero (or empty)
+ * are unset, crypto machines replace them with defaults.
+ *
+ * Packed params are a map of names ("ldN", "p", "r", "salt")
+ * to msgpack packed values (see msgpack/adaptor/KdfParams.hpp).
+ */
+struct KdfParams
+{
+   /** Ctor, all params are unset. */
+   KdfParams() : m_LdN( 0 ), m_R( 0 ), m_P( 0 ) {}
+
+   /**
+    * Returns <tt>true</tt> if all params are equal.
+    *
+    * @param other the params to compare with
+    *
+    * @return <tt>true</tt> if all params are equal
+    */
+   bool operator==( const KdfParams& other ) const
+   {
+      return ( m_Salt == other.m_Salt && m_LdN == other.m_LdN &&
+               m_R == other.m_R && m_P == other.m_P );
+   }
+
+   /**
+    * Returns <tt>true</tt> if any param differs.
+    *
+    * @param other the params to compare with
+    *
+    * @return <tt>true</tt> if any param differs
+    */
+   bool operator!=( const KdfParams& other ) const
+   {
+      return ! ( *this == other );
+   }
+
+   /**
+    * Returns the memory needed by scrypt to derive a key
+    * (128 * r * ( N + p + 2 ) bytes).
+    *
+    * @return the memory in bytes
+    */
+   uint64_t getMemory() const
+   {
+      return 128 * static_cast<uint64_t>( m_R ) *
+         ( ( static_cast<uint64_t>( 1 ) << m_LdN ) + m_P + 2 );
+   }
+
+   /** the salt */
+   Vector<uint8_t> m_Salt;
+   /** ld of N (CPU/memory cost) */
+   uint32_t m_LdN;
+   /** block size */
+   uint32_t m_R;
+   /** parallelism */
+   uint32_t m_P;
+};
+
+} }
+
+#endif
@@ -30,8 +30,6 @@
 #include <openssl/evp.h>
 #include <openssl/hmac.h>
 #include "sesame/crypto/ScryptAesCbcShaV1Machine.hpp"
-#include "sesame/packaging.hpp"
-#include "sesame/utils/string.hpp"
 
 extern "C"
 {
@@ -440,97 +438,69 @@ namespace sesame { namespace crypto {
 
    bool ScryptAesCbcShaV1Machine::deriveKey(
       const String& password,
-      Map<String,Vector<uint8_t>>& params,
+      KdfParams& params,
       Vector<uint8_t>& key
       )
    {
-      getKeyDerivationParams( params );
+      if ( ! getKeyDerivationParams( params ) )
+      {
+         return false;
+      }
 
-      // salt
-      Vector<uint8_t> salt;
-      unpackV( params[ utils::fromUtf8( u8"salt" ) ], salt );
-      // Shorter than 32 Byte?
-      if ( salt.size() < 32 )
+      // Salt shorter than 32 Byte?
+      if ( params.m_Salt.size() < 32 )
       {
          return false;
       }
 
-      // ld N
-      uint32_t ldN;
-      unpackV( params[ utils::fromUtf8( u8"ldN" ) ], ldN );
       // More than 2^63 Byte RAM?!
-      if ( ldN > 63 )
+      if ( params.m_LdN > 63 )
       {
          return false;
       }
 
-      // r
-      uint32_t r;
-      unpackV( params[ utils::fromUtf8( u8"r" ) ], r );
-
-      // p
-      uint32_t p;
-      unpackV( params[ utils::fromUtf8( u8"p" ) ], p );
-
       // Derive 32 byte key using scrypt.
       key.resize( AES_KEY_SIZE );
       return ( crypto_scrypt(
                   reinterpret_cast<const uint8_t*>( password.c_str() ),
                   password.size(),
-                  salt.data(),
-                  salt.size(),
-                  static_cast<uint64_t>( std::exp2( ldN ) ),
-                  r,
-                  p,
+                  params.m_Salt.data(),
+                  params.m_Salt.size(),
+                  static_cast<uint64_t>( 1 ) << params.m_LdN,
+                  params.m_R,
+                  params.m_P,
                   key.data(),
                   key.size()
                   ) == 0 );
    }
 
-   bool ScryptAesCbcShaV1Machine::getKeyDerivationParams( Map<String,Vector<uint8_t>>& params )
+   bool ScryptAesCbcShaV1Machine::getKeyDerivationParams( KdfParams& params )
    {
       // salt
-      if ( params.find( utils::fromUtf8( u8"salt" ) ) == params.end() )
+      if ( params.m_Salt.empty() )
       {
-         Vector<uint8_t> salt;
-         if ( ! genToken( 32, salt ) )
+         if ( ! genToken( 32, params.m_Salt ) )
          {
             return false;
          }
-
-         Vector<uint8_t> v;
-         packV( v, salt );
-         params[ utils::fromUtf8( u8"salt" ) ] = v;
       }
 
       // ld N
-      if ( params.find( utils::fromUtf8( u8"ldN" ) ) == params.end() )
+      if ( params.m_LdN == 0 )
       {
-         uint32_t ldN;
-         ldN = 20;
-         Vector<uint8_t> v;
-         packV( v, ldN );
-         params[ utils::fromUtf8( u8"ldN" ) ] = v;
+         params.m_LdN = 20;
       }
 
       // r
-      if ( params.find( utils::fromUtf8( u8"r" ) ) == params.end() )
+      if ( params.m_R == 0 )
       {
-         uint32_t r;
-         r = 8;
-         Vector<uint8_t> v;
-         packV( v, r );
-         params[ utils::fromUtf8( u8"r" ) ] = v;
+         params.m_R = 8;
       }
 
       // p
-      if ( params.find( utils::fromUtf8( u8"p" ) ) == params.end() )
+      if ( params.m_P == 0 )
       {
-         uint32_t p;
-         p = 1;
-         Vector<uint8_t> v;
-         packV( v, p );
-         params[ utils::fromUtf8( u8"p" ) ] = v;
+         params.m_P = 1;
       }
 
       return true;
@@ -549,6 +519,7 @@ namespace sesame { namespace crypto {
          ++times;
       }
 
+      std::lock_guard<std::mutex> lock( m_PRNGMutex );
       uint32_t tmp;
       for ( uint32_t i = 0; i < times; ++i )
       {
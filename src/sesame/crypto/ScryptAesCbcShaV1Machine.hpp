@@ -26,6 +26,7 @@
 #ifndef SESAME_CRYPTO_SCRYPT_AES_CBC_SHA_V1_MACHINE
 #define SESAME_CRYPTO_SCRYPT_AES_CBC_SHA_V1_MACHINE
 
+#include <mutex>
 #include <random>
 #include "sesame/crypto/IMachine.hpp"
 
@@ -304,12 +305,11 @@ class ScryptAesCbcShaV1Machine : public IMachine
       /**
        * Derives <tt>key</tt> from <tt>password</tt>
        * considering passed params. If params not complete,
-       * defaults are used. Params are passed as Map,
-       * keys are strings, values are packed in msgpack format.
+       * defaults are used.
        *
        * Supported params are:
        *    - salt
-       *    - N (ld max mem, default 20)
+       *    - ldN (ld max mem, default 20)
        *    - r (bit blocks, default 8)
        *    - p (parallelism, default 1)
        *
@@ -321,7 +321,7 @@ class ScryptAesCbcShaV1Machine : public IMachine
        */
       virtual bool deriveKey(
          const String& password,
-         Map<String,Vector<uint8_t>>& params,
+         KdfParams& params,
          Vector<uint8_t>& key
          );
 
@@ -338,7 +338,7 @@ class ScryptAesCbcShaV1Machine : public IMachine
        *
        * @return <tt>true</tt> for success, otherwise <tt>false</tt>
        */
-      virtual bool getKeyDerivationParams( Map<String,Vector<uint8_t>>& params );
+      virtual bool getKeyDerivationParams( KdfParams& params );
 
       /**
        * Generates a random token of passed <tt>length</tt>.
@@ -367,6 +367,8 @@ class ScryptAesCbcShaV1Machine : public IMachine
 
       /** PRNG used for token generation. */
       std::mt19937 m_PRNG;
+      /** Guards PRNG (entries are encrypted by several threads). */
+      std::mutex m_PRNGMutex;
 };
 
 } }
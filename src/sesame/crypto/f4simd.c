@@ -0,0 +1,238 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <pthread.h>
+
+#include "f4simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define F4_SIMD_X86
+#include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+/* Last coefficient is not used. */
+#define F4_USED_COEFFS 0x7fffffffffffffffULL
+
+static void
+f4_block_masks_scalar( const JCOEF* block, uint64_t* nonzero, uint64_t* bits, uint64_t* ones )
+{
+  uint64_t n = 0;
+  uint64_t b = 0;
+  uint64_t o = 0;
+  int coeff;
+  JCOEF value;
+
+  for ( coeff = 0; coeff < ( DCTSIZE2 - 1 ); ++coeff )
+  {
+     value = block[ coeff ];
+
+     if ( value != 0 )
+     {
+        n |= ( 1ULL << coeff );
+
+        if ( value < 0 )
+        {
+           if ( value % 2 == 0 )
+           {
+              b |= ( 1ULL << coeff );
+           }
+        }
+        else
+        {
+           if ( value % 2 == 1 )
+           {
+              b |= ( 1ULL << coeff );
+           }
+        }
+
+        if ( value == 1 || value == -1 )
+        {
+           o |= ( 1ULL << coeff );
+        }
+     }
+  }
+
+  *nonzero = n;
+  *bits = b;
+  *ones = o;
+}
+
+#ifdef F4_SIMD_X86
+
+/*
+ * The carried bit is ( value ^ ( value >> 15 ) ) & 1, shifted to the
+ * sign position it survives saturated packing to bytes, so movemask
+ * collects it like the results of comparisons.
+ */
+
+__attribute__((target("sse2")))
+static void
+f4_block_masks_sse2( const JCOEF* block, uint64_t* nonzero, uint64_t* bits, uint64_t* ones )
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi16( 1 );
+  const __m128i minus_one = _mm_set1_epi16( -1 );
+  uint64_t z = 0;
+  uint64_t b = 0;
+  uint64_t o = 0;
+  __m128i lo;
+  __m128i hi;
+  int i;
+
+  // 16 coefficients per round.
+  for ( i = 0; i < 4; ++i )
+  {
+     lo = _mm_loadu_si128( (const __m128i*)( block + ( 16 * i ) ) );
+     hi = _mm_loadu_si128( (const __m128i*)( block + ( 16 * i ) + 8 ) );
+
+     z |= (uint64_t)(uint16_t)_mm_movemask_epi8( _mm_packs_epi16(
+              _mm_cmpeq_epi16( lo, zero ), _mm_cmpeq_epi16( hi, zero ) ) ) << ( 16 * i );
+
+     b |= (uint64_t)(uint16_t)_mm_movemask_epi8( _mm_packs_epi16(
+              _mm_slli_epi16( _mm_xor_si128( lo, _mm_srai_epi16( lo, 15 ) ), 15 ),
+              _mm_slli_epi16( _mm_xor_si128( hi, _mm_srai_epi16( hi, 15 ) ), 15 ) ) ) << ( 16 * i );
+
+     o |= (uint64_t)(uint16_t)_mm_movemask_epi8( _mm_packs_epi16(
+              _mm_or_si128( _mm_cmpeq_epi16( lo, one ), _mm_cmpeq_epi16( lo, minus_one ) ),
+              _mm_or_si128( _mm_cmpeq_epi16( hi, one ), _mm_cmpeq_epi16( hi, minus_one ) ) ) ) << ( 16 * i );
+  }
+
+  *nonzero = ~z & F4_USED_COEFFS;
+  *bits = b & *nonzero;
+  *ones = o & F4_USED_COEFFS;
+}
+
+/*
+ * Packing works per 128 bit lane, a permutation restores
+ * the order of coefficients before movemask.
+ */
+#define F4_PACK_AVX2( lo, hi ) \
+  _mm256_permute4x64_epi64( _mm256_packs_epi16( lo, hi ), _MM_SHUFFLE( 3, 1, 2, 0 ) )
+
+__attribute__((target("avx2")))
+static void
+f4_block_masks_avx2( const JCOEF* block, uint64_t* nonzero, uint64_t* bits, uint64_t* ones )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi16( 1 );
+  const __m256i minus_one = _mm256_set1_epi16( -1 );
+  uint64_t z = 0;
+  uint64_t b = 0;
+  uint64_t o = 0;
+  __m256i lo;
+  __m256i hi;
+  int i;
+
+  // 32 coefficients per round.
+  for ( i = 0; i < 2; ++i )
+  {
+     lo = _mm256_loadu_si256( (const __m256i*)( block + ( 32 * i ) ) );
+     hi = _mm256_loadu_si256( (const __m256i*)( block + ( 32 * i ) + 16 ) );
+
+     z |= (uint64_t)(uint32_t)_mm256_movemask_epi8( F4_PACK_AVX2(
+              _mm256_cmpeq_epi16( lo, zero ), _mm256_cmpeq_epi16( hi, zero ) ) ) << ( 32 * i );
+
+     b |= (uint64_t)(uint32_t)_mm256_movemask_epi8( F4_PACK_AVX2(
+              _mm256_slli_epi16( _mm256_xor_si256( lo, _mm256_srai_epi16( lo, 15 ) ), 15 ),
+              _mm256_slli_epi16( _mm256_xor_si256( hi, _mm256_srai_epi16( hi, 15 ) ), 15 ) ) ) << ( 32 * i );
+
+     o |= (uint64_t)(uint32_t)_mm256_movemask_epi8( F4_PACK_AVX2(
+              _mm256_or_si256( _mm256_cmpeq_epi16( lo, one ), _mm256_cmpeq_epi16( lo, minus_one ) ),
+              _mm256_or_si256( _mm256_cmpeq_epi16( hi, one ), _mm256_cmpeq_epi16( hi, minus_one ) ) ) ) << ( 32 * i );
+  }
+
+  *nonzero = ~z & F4_USED_COEFFS;
+  *bits = b & *nonzero;
+  *ones = o & F4_USED_COEFFS;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+/* Kernel selected, the best one supported by default (selected once). */
+static f4_block_masks_fn f4_selected_block_masks = 0;
+static pthread_once_t f4_default_selected = PTHREAD_ONCE_INIT;
+
+f4_block_masks_fn
+f4_get_block_masks( const enum f4_simd simd )
+{
+  switch ( simd )
+  {
+#ifdef F4_SIMD_X86
+    case F4_SIMD_AVX2:
+      __builtin_cpu_init();
+      return ( __builtin_cpu_supports( "avx2" ) ? f4_block_masks_avx2 : 0 );
+    case F4_SIMD_SSE2:
+      __builtin_cpu_init();
+      return ( __builtin_cpu_supports( "sse2" ) ? f4_block_masks_sse2 : 0 );
+#endif
+    case F4_SIMD_NONE:
+      return f4_block_masks_scalar;
+    default:
+      return 0;
+  }
+}
+
+static enum f4_simd
+f4_install_simd( enum f4_simd simd )
+{
+  f4_block_masks_fn fn;
+
+  while ( ( fn = f4_get_block_masks( simd ) ) == 0 )
+  {
+    simd = (enum f4_simd)( simd - 1 );
+  }
+
+  f4_selected_block_masks = fn;
+
+  return simd;
+}
+
+static void
+f4_select_default_simd( void )
+{
+  f4_install_simd( F4_SIMD_AVX2 );
+}
+
+enum f4_simd
+f4_select_simd( enum f4_simd simd )
+{
+  /* Default must not replace this selection on first use. */
+  pthread_once( &f4_default_selected, f4_select_default_simd );
+
+  return f4_install_simd( simd );
+}
+
+f4_block_masks_fn
+f4_block_masks( void )
+{
+  /* Workers of several carriers may ask at once. */
+  pthread_once( &f4_default_selected, f4_select_default_simd );
+
+  return f4_selected_block_masks;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SESAME_CRYPTO_F4SIMD_H
+#define SESAME_CRYPTO_F4SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "jpeglib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instruction sets available for coefficient kernels.
+ */
+enum f4_simd {
+   F4_SIMD_NONE = 0,  /**< portable scalar code (reference) */
+   F4_SIMD_SSE2 = 1,  /**< x86 SSE2 */
+   F4_SIMD_AVX2 = 2   /**< x86 AVX2 */
+};
+
+/**
+ * Evaluates all coefficients of a block at once. Bit i of each
+ * mask corresponds to coefficient i, the last coefficient (63)
+ * is never used by F4 and always reported as zero.
+ *
+ * @param block the 64 coefficients of a block
+ * @param nonzero coefficients not equal to zero
+ * @param bits bits carried by the coefficients (odd positive and
+ *        even negative values carry a one, zeros carry nothing)
+ * @param ones coefficients equal to +1 or -1
+ */
+typedef void (*f4_block_masks_fn)(
+   const JCOEF* block,
+   uint64_t* nonzero,
+   uint64_t* bits,
+   uint64_t* ones
+   );
+
+/**
+ * Returns the kernel for instruction set <tt>simd</tt>.
+ *
+ * @param simd instruction set
+ *
+ * @return kernel or <tt>NULL</tt> if not supported by CPU (or build)
+ */
+f4_block_masks_fn f4_get_block_masks(
+   const enum f4_simd simd
+   );
+
+/**
+ * Returns the kernel used by embedding and extraction,
+ * by default the best one supported by the CPU.
+ *
+ * @return kernel
+ */
+f4_block_masks_fn f4_block_masks(
+   void
+   );
+
+/**
+ * Selects the kernel used by embedding and extraction.
+ * Falls back to less capable instruction sets if <tt>simd</tt>
+ * is not supported. Must not be called while embedding or
+ * extracting.
+ *
+ * @param simd instruction set to use
+ *
+ * @return instruction set selected
+ */
+enum f4_simd f4_select_simd(
+   enum f4_simd simd
+   );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
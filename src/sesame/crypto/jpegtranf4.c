@@ -43,12 +43,17 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "jpeglib.h"
 #include "jmemsys.h"
 #include "jvirt_arrays.h"
 
 #include "jpegtranf4.h"
+#include "f4simd.h"
 
 #include "cdjpeg.h"             /* Common decls for cjpeg/djpeg applications */
 #include "transupp.h"           /* Support routines for jpegtran */
@@ -85,346 +90,1270 @@ my_error_exit (j_common_ptr cinfo)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-int f4_extract_message(
+/*
+ * State of an extraction, bits are read out of the
+ * coefficients of the first component row by row.
+ */
+struct f4_extraction {
+  jvirt_barray_ptr array;       /* coefficients, 0 until available */
+  char* data;                   /* extracted bits */
+  size_t length;                /* size of data */
+  size_t needed;                /* bits to extract, all of data if unframed */
+  size_t mbits;                 /* bits extracted so far */
+  size_t payload;               /* length of payload announced by header */
+  JDIMENSION next_row;          /* next row to extract bits from */
+  int framed;                   /* -1 => unknown, 0 => no header, 1 => header */
+  int invalid;                  /* header announces more than fits */
+  int k;                        /* > 1 => data holds carried bits, allocated */
+};
+
+/*
+ * A worker of a parallel extraction, it handles a range of rows.
+ */
+struct f4_chunk {
+  struct f4_extraction* extraction;
+  JBLOCKROW* rows;              /* rows of this chunk */
+  JDIMENSION num_rows;
+  size_t count;                 /* number of non zero coefficients */
+  size_t ones;                  /* number of coefficients +1/-1 */
+  size_t offset;                /* index of first bit */
+  unsigned char head;           /* first byte, shared with previous chunk */
+  unsigned char tail;           /* last byte, shared with next chunk */
+};
+
+/*
+ * Progress monitor extracting data while coefficients are decoded.
+ */
+struct f4_progress_mgr {
+  struct jpeg_progress_mgr pub; /* "public" fields */
+  struct f4_extraction* extraction;
+  jmp_buf done_buffer;          /* for return to caller when done */
+};
+typedef struct f4_progress_mgr* f4_progress_ptr;
+
+#define F4_MAX_WORKERS 8
+#define F4_MIN_ROWS_PER_WORKER 32
+
+LOCAL(int)
+f4_is_done( const struct f4_extraction* extraction )
+{
+   return ( extraction->invalid || ( extraction->mbits >= extraction->needed ) );
+}
+
+/*
+ * Returns Hamming code parameter selected by header of data,
+ * 0 if data has no header.
+ */
+LOCAL(int)
+f4_header_k( const char* data, const size_t length )
+{
+   int k;
+
+   if ( ( length < F4_HEADER_SIZE ) || ( memcmp( data, F4_MAGIC, F4_MAGIC_SIZE - 1 ) != 0 ) )
+   {
+      return 0;
+   }
+
+   k = data[ F4_MAGIC_SIZE - 1 ] - '0';
+
+   return ( ( k >= 1 ) && ( k <= F4_MAX_K ) ) ? k : 0;
+}
+
+/*
+ * Evaluates the header once enough bits are extracted.
+ */
+LOCAL(void)
+f4_check_header( struct f4_extraction* extraction )
+{
+   const unsigned char* data = (const unsigned char*)extraction->data;
+   jvirt_barray_ptr array = extraction->array;
+   size_t length;
+   size_t groups;
+   char* raw;
+   int k;
+
+   if ( ( extraction->framed >= 0 ) || ( extraction->mbits < ( F4_HEADER_SIZE * 8 ) ) )
+   {
+      return;
+   }
+
+   // Data embedded by older versions has no header.
+   if ( ( k = f4_header_k( extraction->data, extraction->length ) ) == 0 )
+   {
+      extraction->framed = 0;
+      return;
+   }
+
+   length = ( (size_t)data[ 4 ] << 24 ) | ( (size_t)data[ 5 ] << 16 )
+      | ( (size_t)data[ 6 ] << 8 ) | (size_t)data[ 7 ];
+
+   extraction->framed = 1;
+
+   if ( length > ( extraction->length - F4_HEADER_SIZE ) )
+   {
+      extraction->invalid = 1;
+      return;
+   }
+
+   extraction->payload = length;
+
+   if ( k == 1 )
+   {
+      extraction->needed = ( F4_HEADER_SIZE + length ) * 8;
+      return;
+   }
+
+   // Matrix encoding, collect carried bits of all groups first.
+   groups = ( ( length * 8 ) + k - 1 ) / k;
+   extraction->needed = ( F4_HEADER_SIZE * 8 ) + ( groups * ( ( 1 << k ) - 1 ) );
+
+   // Coefficient 63 is never used, bits beyond length have been dropped.
+   if ( ( extraction->needed > ( (size_t)array->rows_in_array * array->blocksperrow * ( DCTSIZE2 - 1 ) ) ) ||
+        ( extraction->mbits > ( extraction->length * 8 ) ) ||
+        ( ( raw = (char*)calloc( ( extraction->needed + 7 ) / 8, 1 ) ) == NULL ) )
+   {
+      extraction->invalid = 1;
+      return;
+   }
+
+   memcpy( raw, extraction->data, MIN( ( extraction->mbits + 7 ) / 8, ( extraction->needed + 7 ) / 8 ) );
+   extraction->data = raw;
+   extraction->k = k;
+}
+
+/*
+ * Decodes matrix encoded payload out of the carried bits in raw
+ * into data, the header has been extracted already.
+ */
+LOCAL(void)
+f4_decode_matrix( const char* raw, char* data, const size_t length, const int k )
+{
+   const size_t n = ( (size_t)1 << k ) - 1;
+   const size_t end = ( F4_HEADER_SIZE + length ) * 8;
+   size_t in = F4_HEADER_SIZE * 8;
+   size_t out = F4_HEADER_SIZE * 8;
+   size_t i;
+   int hash;
+   int j;
+
+   memset( data + F4_HEADER_SIZE, 0, length );
+
+   while ( out < end )
+   {
+      // Bits of a group are the xor of (1 based) indices of coefficients carrying 1.
+      for ( hash = 0, i = 1; i <= n; ++i, ++in )
+      {
+         if ( ( raw[ in / 8 ] >> ( 7 - ( in % 8 ) ) ) & 1 )
+         {
+            hash ^= (int)i;
+         }
+      }
+
+      for ( j = k - 1; ( j >= 0 ) && ( out < end ); --j, ++out )
+      {
+         data[ out / 8 ] |= (char)( ( ( hash >> j ) & 1 ) << ( 7 - ( out % 8 ) ) );
+      }
+   }
+}
+
+/*
+ * Extracts bits out of a row of blocks, returns index of next bit.
+ */
+LOCAL(size_t)
+f4_extract_row(
+  f4_block_masks_fn block_masks,
+  JBLOCKROW blockrow,
+  JDIMENSION blocks,
+  char* data,
+  const size_t needed,
+  size_t mbits
+)
+{
+  JDIMENSION block;
+  uint64_t nonzero;
+  uint64_t bits;
+  uint64_t ones;
+  int coeff;
+
+  for ( block = 0; block < blocks; ++block )
+  {
+     block_masks( blockrow[ block ], &nonzero, &bits, &ones );
+
+     // Only eval non zeroes.
+     while ( nonzero != 0 )
+     {
+        coeff = __builtin_ctzll( nonzero );
+        nonzero &= ( nonzero - 1 );
+
+        if ( mbits < needed )
+        {
+           data[ mbits / 8 ] |= ( ( ( bits >> coeff ) & 1 ) << ( 7 - ( mbits % 8 ) ) );
+        }
+
+        ++mbits;
+     }
+  }
+
+  return mbits;
+}
+
+/*
+ * Extracts bits out of rows up to end_row, stops when done.
+ */
+LOCAL(void)
+f4_extract_rows(
+  j_common_ptr info,
+  struct f4_extraction* extraction,
+  JDIMENSION end_row
+)
+{
+  jvirt_barray_ptr array = extraction->array;
+  f4_block_masks_fn block_masks = f4_block_masks();
+  JDIMENSION rows;
+  JDIMENSION row;
+  JBLOCKARRAY blockarray;
+
+  while ( ( extraction->next_row < end_row ) && ! f4_is_done( extraction ) )
+  {
+     // Determine number of rows allowed to read at once.
+     rows = MIN( end_row - extraction->next_row, array->maxaccess );
+
+     // Read!
+     blockarray = info->mem->access_virt_barray(
+           info,
+           array,
+           extraction->next_row,  // start
+           rows,                  // rows
+           FALSE                  // writable
+        );
+
+     for ( row = 0; ( row < rows ) && ! f4_is_done( extraction ); ++row )
+     {
+        extraction->mbits = f4_extract_row(
+           block_masks,
+           blockarray[ row ],
+           array->blocksperrow,
+           extraction->data,
+           extraction->needed,
+           extraction->mbits
+           );
+        ++extraction->next_row;
+
+        f4_check_header( extraction );
+     }
+  }
+}
+
+/*
+ * Counts non zero coefficients of a chunk.
+ */
+LOCAL(void*)
+f4_count_chunk( void* arg )
+{
+  struct f4_chunk* chunk = (struct f4_chunk*)arg;
+  f4_block_masks_fn block_masks = f4_block_masks();
+  JDIMENSION blocks = chunk->extraction->array->blocksperrow;
+  JDIMENSION row;
+  JDIMENSION block;
+  uint64_t nonzero;
+  uint64_t bits;
+  uint64_t ones;
+
+  chunk->count = 0;
+  chunk->ones = 0;
+
+  for ( row = 0; row < chunk->num_rows; ++row )
+  {
+     for ( block = 0; block < blocks; ++block )
+     {
+        block_masks( chunk->rows[ row ][ block ], &nonzero, &bits, &ones );
+        chunk->count += __builtin_popcountll( nonzero );
+        chunk->ones += __builtin_popcountll( ones );
+     }
+  }
+
+  return NULL;
+}
+
+/*
+ * Extracts bits of a chunk, starting at bit chunk->offset.
+ * First and last byte may be shared with neighbouring chunks,
+ * their bits are collected in head and tail.
+ */
+LOCAL(void*)
+f4_extract_chunk( void* arg )
+{
+  struct f4_chunk* chunk = (struct f4_chunk*)arg;
+  struct f4_extraction* extraction = chunk->extraction;
+  f4_block_masks_fn block_masks = f4_block_masks();
+  JDIMENSION blocks = extraction->array->blocksperrow;
+  size_t head = chunk->offset / 8;
+  size_t tail = ( chunk->offset + chunk->count - 1 ) / 8;
+  size_t end = extraction->needed;
+  size_t mbits = chunk->offset;
+  JDIMENSION row;
+  JDIMENSION block;
+  uint64_t nonzero;
+  uint64_t bits;
+  uint64_t ones;
+  unsigned char mbit;
+  int coeff;
+
+  chunk->head = 0;
+  chunk->tail = 0;
+
+  for ( row = 0; row < chunk->num_rows; ++row )
+  {
+     for ( block = 0; block < blocks; ++block )
+     {
+        block_masks( chunk->rows[ row ][ block ], &nonzero, &bits, &ones );
+
+        while ( nonzero != 0 )
+        {
+           if ( mbits >= end )
+           {
+              return NULL;
+           }
+
+           coeff = __builtin_ctzll( nonzero );
+           nonzero &= ( nonzero - 1 );
+
+           mbit = ( ( ( bits >> coeff ) & 1 ) << ( 7 - ( mbits % 8 ) ) );
+
+           if ( ( mbits / 8 ) == head )
+           {
+              chunk->head |= mbit;
+           }
+           else if ( ( mbits / 8 ) == tail )
+           {
+              chunk->tail |= mbit;
+           }
+           else
+           {
+              extraction->data[ mbits / 8 ] |= mbit;
+           }
+
+           ++mbits;
+        }
+     }
+  }
+
+  return NULL;
+}
+
+/*
+ * Runs fn for all chunks, chunks[ 0 ] is handled by the calling thread.
+ */
+LOCAL(void)
+f4_run_chunks( struct f4_chunk* chunks, int num_chunks, void* (*fn)( void* ) )
+{
+  pthread_t threads[ F4_MAX_WORKERS ];
+  int started[ F4_MAX_WORKERS ];
+  int i;
+
+  for ( i = 1; i < num_chunks; ++i )
+  {
+     started[ i ] = ( pthread_create( &threads[ i ], NULL, fn, &chunks[ i ] ) == 0 );
+
+     // Do it ourself if there are no threads left.
+     if ( ! started[ i ] )
+     {
+        fn( &chunks[ i ] );
+     }
+  }
+
+  fn( &chunks[ 0 ] );
+
+  for ( i = 1; i < num_chunks; ++i )
+  {
+     if ( started[ i ] )
+     {
+        pthread_join( threads[ i ], NULL );
+     }
+  }
+}
+
+/*
+ * Returns number of workers to use for num_rows rows.
+ */
+LOCAL(int)
+f4_num_workers( JDIMENSION num_rows )
+{
+  long num_cpus = sysconf( _SC_NPROCESSORS_ONLN );
+  long num = MIN( num_rows / F4_MIN_ROWS_PER_WORKER, F4_MAX_WORKERS );
+
+  num = MIN( num, num_cpus );
+
+  return (int)MAX( num, 1 );
+}
+
+/*
+ * Splits rows of array from first_row on into num_chunks chunks.
+ * Returns the row pointers (to be freed by caller) or NULL
+ * if rows are not accessible at once.
+ */
+LOCAL(JBLOCKROW*)
+f4_make_chunks(
+  j_common_ptr info,
+  struct f4_extraction* extraction,
+  JDIMENSION first_row,
+  struct f4_chunk* chunks,
+  int num_chunks
+)
+{
+  jvirt_barray_ptr array = extraction->array;
+  JDIMENSION num_rows = array->rows_in_array - first_row;
+  JBLOCKARRAY blockarray;
+  JBLOCKROW* rows;
+  JDIMENSION row;
+  JDIMENSION count;
+  int i;
+
+  // Row pointers stay valid only if the whole array is in memory.
+  if ( array->rows_in_mem < array->rows_in_array )
+  {
+     return NULL;
+  }
+
+  rows = (JBLOCKROW*)malloc( MAX( num_rows, 1 ) * sizeof( JBLOCKROW ) );
+  if ( rows == NULL )
+  {
+     return NULL;
+  }
+
+  for ( row = 0; row < num_rows; row += count )
+  {
+     count = MIN( num_rows - row, array->maxaccess );
+     blockarray = info->mem->access_virt_barray(
+           info, array, first_row + row, count, FALSE );
+     memcpy( &rows[ row ], blockarray, count * sizeof( JBLOCKROW ) );
+  }
+
+  for ( i = 0; i < num_chunks; ++i )
+  {
+     memset( &chunks[ i ], 0, sizeof( struct f4_chunk ) );
+     chunks[ i ].extraction = extraction;
+     chunks[ i ].rows = rows + ( (size_t)num_rows * i / num_chunks );
+     chunks[ i ].num_rows = (JDIMENSION)( (size_t)num_rows * ( i + 1 ) / num_chunks
+        - (size_t)num_rows * i / num_chunks );
+  }
+
+  return rows;
+}
+
+/*
+ * Extracts bits out of all remaining rows once all coefficients
+ * are decoded. Rows are split into chunks processed by several
+ * threads: non zero coefficients of each chunk are counted first,
+ * a prefix sum of the counts yields the first bit of each chunk.
+ */
+LOCAL(void)
+f4_extract_parallel( j_common_ptr info, struct f4_extraction* extraction )
+{
+  jvirt_barray_ptr array = extraction->array;
+  struct f4_chunk chunks[ F4_MAX_WORKERS ];
+  JBLOCKROW* rows = NULL;
+  size_t offset;
+  int num_chunks;
+  int i;
+
+  // The header determines how many bits are needed.
+  while ( ( extraction->framed < 0 ) && ( extraction->next_row < array->rows_in_array ) )
+  {
+     f4_extract_rows( info, extraction, extraction->next_row + 1 );
+  }
+
+  num_chunks = f4_num_workers( array->rows_in_array - extraction->next_row );
+
+  if ( ( num_chunks > 1 ) && ! f4_is_done( extraction ) )
+  {
+     rows = f4_make_chunks( info, extraction, extraction->next_row, chunks, num_chunks );
+  }
+
+  // A single worker does not need to count first.
+  if ( rows == NULL )
+  {
+     f4_extract_rows( info, extraction, array->rows_in_array );
+     return;
+  }
+
+  f4_run_chunks( chunks, num_chunks, f4_count_chunk );
+
+  // Prefix sum, skip chunks beyond the needed bits.
+  offset = extraction->mbits;
+  for ( i = 0; i < num_chunks; ++i )
+  {
+     chunks[ i ].offset = offset;
+     offset += chunks[ i ].count;
+
+     if ( ( chunks[ i ].count == 0 ) || ( chunks[ i ].offset >= extraction->needed ) )
+     {
+        chunks[ i ].num_rows = 0;
+        chunks[ i ].count = 0;
+     }
+  }
+
+  f4_run_chunks( chunks, num_chunks, f4_extract_chunk );
+
+  // Merge bytes shared by neighbouring chunks.
+  for ( i = 0; i < num_chunks; ++i )
+  {
+     if ( chunks[ i ].count == 0 )
+     {
+        continue;
+     }
+
+     extraction->data[ chunks[ i ].offset / 8 ] |= chunks[ i ].head;
+
+     if ( ( ( chunks[ i ].offset + chunks[ i ].count - 1 ) / 8 ) < ( ( extraction->needed + 7 ) / 8 ) )
+     {
+        extraction->data[ ( chunks[ i ].offset + chunks[ i ].count - 1 ) / 8 ] |= chunks[ i ].tail;
+     }
+  }
+
+  free( rows );
+
+  extraction->mbits = offset;
+  extraction->next_row = array->rows_in_array;
+}
+
+/*
+ * Called by libjpeg before each step of decoding coefficients.
+ * Extracts bits out of completed rows and aborts decoding
+ * as soon as all data is extracted.
+ */
+METHODDEF(void)
+f4_progress_monitor( j_common_ptr info )
+{
+  f4_progress_ptr progress = (f4_progress_ptr) info->progress;
+  j_decompress_ptr dinfo = (j_decompress_ptr) info;
+  struct f4_extraction* extraction = progress->extraction;
+
+  // Rows are complete before end of input only if there is a single scan.
+  if ( ( dinfo->coef == NULL ) || ( dinfo->coef->coef_arrays == NULL ) ||
+       dinfo->inputctl->has_multiple_scans )
+  {
+     return;
+  }
+
+  extraction->array = dinfo->coef->coef_arrays[ 0 ];
+
+  // Rows before first undefined row are decoded completely.
+  f4_extract_rows( info, extraction, extraction->array->first_undef_row );
+
+  if ( f4_is_done( extraction ) )
+  {
+     longjmp( progress->done_buffer, 1 );
+  }
+}
+
+/*
+ * Walks through the non zero coefficients of an array.
+ */
+struct f4_cursor {
+  j_common_ptr info;
+  jvirt_barray_ptr array;
+  f4_block_masks_fn block_masks;
+  JBLOCKARRAY blockarray;       /* rows accessible at once */
+  JDIMENSION start;             /* first row of blockarray */
+  JDIMENSION rows;              /* number of rows of blockarray */
+  JDIMENSION row;
+  JDIMENSION block;
+  uint64_t nonzero;             /* non zeroes of current block not visited yet */
+  size_t shrunk;                /* number of coefficients shrunk to zero */
+};
+
+LOCAL(void)
+f4_cursor_init( struct f4_cursor* cursor, j_common_ptr info, jvirt_barray_ptr array )
+{
+  memset( cursor, 0, sizeof( struct f4_cursor ) );
+  cursor->info = info;
+  cursor->array = array;
+  cursor->block_masks = f4_block_masks();
+  cursor->block = array->blocksperrow;
+}
+
+/*
+ * Returns next non zero coefficient (but the last of a block)
+ * or NULL if there is none.
+ */
+LOCAL(JCOEF*)
+f4_cursor_next( struct f4_cursor* cursor )
+{
+  jvirt_barray_ptr array = cursor->array;
+  uint64_t carried;
+  uint64_t ones;
+  int coeff;
+
+  while ( cursor->nonzero == 0 )
+  {
+     if ( ++cursor->block >= array->blocksperrow )
+     {
+        cursor->block = 0;
+
+        if ( ++cursor->row >= cursor->rows )
+        {
+           if ( ( cursor->start + cursor->rows ) >= array->rows_in_array )
+           {
+              cursor->block = array->blocksperrow;
+              return NULL;
+           }
+
+           // Determine number of rows allowed to read at once.
+           cursor->start += cursor->rows;
+           cursor->rows = MIN( array->rows_in_array - cursor->start, array->maxaccess );
+           cursor->row = 0;
+
+           // Read!
+           cursor->blockarray = cursor->info->mem->access_virt_barray(
+                 cursor->info,
+                 array,
+                 cursor->start,     // start
+                 cursor->rows,      // rows
+                 TRUE               // writable
+              );
+        }
+     }
+
+     cursor->block_masks( cursor->blockarray[ cursor->row ][ cursor->block ], &cursor->nonzero, &carried, &ones );
+  }
+
+  coeff = __builtin_ctzll( cursor->nonzero );
+  cursor->nonzero &= ( cursor->nonzero - 1 );
+
+  return &cursor->blockarray[ cursor->row ][ cursor->block ][ coeff ];
+}
+
+/*
+ * Embeds message bits mbit ... mbits - 1 using a (1, 2^k - 1, k)
+ * Hamming code, k == 1 is plain F4. Each group of n = 2^k - 1 non
+ * zero coefficients carries k bits as xor of the (1 based) indices
+ * of coefficients carrying 1, so at most one of them has to change.
+ * Returns index of first bit not embedded, mbits on success.
+ */
+LOCAL(size_t)
+f4_embed_bits(
+  struct f4_cursor* cursor,
+  const char* data,
+  size_t mbit,
+  const size_t mbits,
+  const int k
+)
+{
+  JCOEF* group[ ( 1 << F4_MAX_K ) - 1 ];
+  const int n = ( 1 << k ) - 1;
+  int x;
+  int hash;
+  int i;
+
+  while ( mbit < mbits )
+  {
+     // Next k bits, last group is padded with zeroes.
+     for ( x = 0, i = 0; i < k; ++i )
+     {
+        x <<= 1;
+        if ( ( mbit + i ) < mbits )
+        {
+           x |= ( data[ ( mbit + i ) / 8 ] >> ( 7 - ( ( mbit + i ) % 8 ) ) ) & 1;
+        }
+     }
+
+     for ( i = 0; i < n; ++i )
+     {
+        if ( ( group[ i ] = f4_cursor_next( cursor ) ) == NULL )
+        {
+           return mbit;
+        }
+     }
+
+     for ( ;; )
+     {
+        for ( hash = 0, i = 0; i < n; ++i )
+        {
+           hash ^= ( ( *group[ i ] ^ ( *group[ i ] >> 15 ) ) & 1 ) * ( i + 1 );
+        }
+
+        if ( ( i = ( hash ^ x ) - 1 ) < 0 )
+        {
+           break;
+        }
+
+        // Move value towards zero, flips the carried bit.
+        *group[ i ] += ( ( *group[ i ] > 0 ) ? -1 : 1 );
+
+        if ( *group[ i ] != 0 )
+        {
+           break;
+        }
+
+        // Shrinkage, coefficient carries nothing any longer, take the next one.
+        ++cursor->shrunk;
+        memmove( &group[ i ], &group[ i + 1 ], ( n - i - 1 ) * sizeof( JCOEF* ) );
+        if ( ( group[ n - 1 ] = f4_cursor_next( cursor ) ) == NULL )
+        {
+           return mbit;
+        }
+     }
+
+     mbit += k;
+  }
+
+  return mbits;
+}
+
+int f4_embed_message(
   j_common_ptr info,
   jvirt_barray_ptr* coef_arrays,
-  char* data,
+  const char* data,
   const size_t length
 )
 {
-  unsigned int mbits = 0;
-  unsigned char mbit;
+  jvirt_barray_ptr array = coef_arrays[ 0 ];
+  struct f4_cursor cursor;
+  int k = f4_header_k( data, length );
+
+  f4_cursor_init( &cursor, info, array );
+
+  // No header, embed everything with plain F4 like older versions did.
+  if ( k <= 1 )
+  {
+     return ( f4_embed_bits( &cursor, data, 0, length * 8, 1 ) == ( length * 8 ) );
+  }
+
+  // Groups may span rows, they have to stay in memory.
+  if ( array->rows_in_mem < array->rows_in_array )
+  {
+     return 0;
+  }
+
+  // Header is always embedded with plain F4.
+  return ( ( f4_embed_bits( &cursor, data, 0, F4_HEADER_SIZE * 8, 1 ) == ( F4_HEADER_SIZE * 8 ) ) &&
+           ( f4_embed_bits( &cursor, data, F4_HEADER_SIZE * 8, length * 8, k ) == ( length * 8 ) ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Decoded cover image, coefficients are kept for repeated embedding.
+ */
+struct f4_cover {
+  struct jpeg_decompress_struct srcinfo;
+  struct my_error_mgr jsrcerr;
+  jvirt_barray_ptr * coef_arrays;
+  JBLOCK* original;             /* unmodified coefficients of first component */
+};
+
+/*
+ * Saves (restore == 0) or restores (restore != 0) the
+ * coefficients of the first component.
+ */
+LOCAL(void)
+f4_cover_copy( f4_cover* cover, int restore )
+{
+  jvirt_barray_ptr array = cover->coef_arrays[ 0 ];
+  size_t blocks = array->blocksperrow;
+  JBLOCKARRAY blockarray;
+  JBLOCK* original;
+  JDIMENSION start;
+  JDIMENSION rows;
+  JDIMENSION row;
+
+  for ( start = 0; start < array->rows_in_array; start += rows )
+  {
+     rows = MIN( array->rows_in_array - start, array->maxaccess );
+     blockarray = cover->srcinfo.mem->access_virt_barray(
+           (j_common_ptr)&cover->srcinfo, array, start, rows, ( restore ? TRUE : FALSE ) );
+
+     for ( row = 0; row < rows; ++row )
+     {
+        original = cover->original + ( (size_t)( start + row ) * blocks );
+
+        if ( restore )
+        {
+           memcpy( blockarray[ row ], original, blocks * sizeof( JBLOCK ) );
+        }
+        else
+        {
+           memcpy( original, blockarray[ row ], blocks * sizeof( JBLOCK ) );
+        }
+     }
+  }
+}
+
+/*
+ * Returns square root of value, rounded down.
+ */
+LOCAL(size_t)
+f4_isqrt( size_t value )
+{
+  size_t root;
+
+  for ( root = 0; ( root + 1 ) * ( root + 1 ) <= value; ++root );
+
+  return root;
+}
+
+/*
+ * Estimates capacity for matrix encoding by embedding random data,
+ * coefficients of array are modified. Shrinkage depends on where
+ * the +1/-1 are located, a dry run is more accurate than a model.
+ * Returns 0 if rows are not accessible at once or out of memory.
+ */
+LOCAL(int)
+f4_simulate_capacity(
+  j_common_ptr info,
+  jvirt_barray_ptr array,
+  const int k,
+  const size_t count,
+  size_t* capacity
+)
+{
+  const size_t n = ( (size_t)1 << k ) - 1;
+  const size_t length = F4_HEADER_SIZE + ( ( count / n ) * k ) / 8 + 1;
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  struct f4_cursor cursor;
+  size_t deviation;
+  size_t mbits;
+  size_t i;
+  char* random;
+
+  if ( ( array->rows_in_mem < array->rows_in_array ) ||
+       ( ( random = (char*)malloc( length ) ) == NULL ) )
+  {
+     return 0;
+  }
+
+  // Reproducible pseudo random data (xorshift64).
+  for ( i = 0; i < length; ++i )
+  {
+     state ^= state << 13;
+     state ^= state >> 7;
+     state ^= state << 17;
+     random[ i ] = (char)( state >> 56 );
+  }
+
+  f4_cursor_init( &cursor, info, array );
+  mbits = f4_embed_bits( &cursor, random, 0, F4_HEADER_SIZE * 8, 1 );
+  if ( mbits == ( F4_HEADER_SIZE * 8 ) )
+  {
+     mbits = f4_embed_bits( &cursor, random, mbits, length * 8, k );
+  }
+
+  free( random );
 
-  // Variables used while evaluating coefficients.
-  JDIMENSION rows_to_read;
-  JDIMENSION rows_read;
-  JDIMENSION rows;
-  JDIMENSION row;
-  JDIMENSION blocks;
-  JDIMENSION block;
-  JDIMENSION coeffs = sizeof( JBLOCK ) / sizeof( JCOEF );
-  JDIMENSION coeff;
-  JBLOCKARRAY blockarray;
-  JBLOCKROW blockrow;
-  JCOEF value;
+  /* Other data shrinks other coefficients. Keep a margin of three
+   * standard deviations (sqrt( shrunk )) of that number, a coefficient
+   * carries less than k / n bits.
+   */
+  deviation = ( 3 * f4_isqrt( cursor.shrunk ) * k + n - 1 ) / n;
+
+  *capacity = ( mbits > ( ( F4_HEADER_SIZE * 8 ) + deviation ) ) ?
+    F4_HEADER_SIZE + ( mbits - ( F4_HEADER_SIZE * 8 ) - deviation ) / 8 : 0;
 
-  //int count = 0;
-  jvirt_barray_ptr current = *coef_arrays;
+  return 1;
+}
 
-  // Evaluate coefficients.
-  while ( current != 0 )
+/*
+ * Counts usable coefficients of array and estimates capacity
+ * for Hamming code parameter k.
+ * Returns 0 if rows are not accessible at once.
+ */
+LOCAL(int)
+f4_count_capacity( j_common_ptr info, jvirt_barray_ptr array, const int k, size_t* capacity )
+{
+  struct f4_extraction extraction;
+  struct f4_chunk chunks[ F4_MAX_WORKERS ];
+  JBLOCKROW* rows;
+  size_t count = 0;
+  size_t ones = 0;
+  size_t deviation;
+  int num_chunks;
+  int i;
+
+  memset( &extraction, 0, sizeof( extraction ) );
+  extraction.array = array;
+
+  num_chunks = f4_num_workers( array->rows_in_array );
+  rows = f4_make_chunks( info, &extraction, 0, chunks, num_chunks );
+
+  if ( rows == NULL )
   {
-     //printf( "loop %d\n", ++count );
+     return 0;
+  }
 
-     rows_to_read = current->rows_in_array;
-     rows_read = 0;
+  f4_run_chunks( chunks, num_chunks, f4_count_chunk );
 
-     while ( rows_to_read > 0 )
-     {
-        // Determine number of rows allowed to read at once.
-        rows = MIN( rows_to_read, current->maxaccess );
-
-        // Read!
-        blockarray = info->mem->access_virt_barray(
-              info,
-              *coef_arrays,
-              current->cur_start_row + rows_read,  // start
-              rows,                                         // rows
-              0                                             // writable
-           );
+  for ( i = 0; i < num_chunks; ++i )
+  {
+     count += chunks[ i ].count;
+     ones += chunks[ i ].ones;
+  }
 
-        rows_to_read -= rows;
-        rows_read += rows;
+  free( rows );
 
-        // Iterate.
-        for ( row = 0; row < rows; ++row )
-        {
-            blockrow = blockarray[ row ];
-            blocks = current->blocksperrow;
-
-            for ( block = 0; block < blocks; ++block )
-            {
-               // Ignore last coefficient.
-               for ( coeff = 0; coeff < ( coeffs - 1 ); ++coeff )
-               {
-                  value = blockrow[ block ][ coeff ];
-
-                  // Only eval non zeroes.
-                  if ( value != 0 )
-                  {
-                     mbit = 0;
-
-                     if ( value < 0 )
-                     {
-                        if ( value % 2 == 0 )
-                        {
-                           mbit = 1;
-                        }
-                     }
-                     else
-                     {
-                        if ( value % 2 == 1 )
-                        {
-                           mbit = 1;
-                        }
-                     }
-
-                     if ( ( mbits / 8 ) < length )
-                     {
-                        mbit = ( mbit << ( 7 - ( mbits % 8 ) ) );
-                        data[ mbits / 8 ] |= mbit;
-                     }
-
-                     ++mbits;
-                  }
-               }
-            }
-        }
-     }
+  if ( k <= 1 )
+  {
+    /* Embedding random data shrinks every second +1/-1 to 0,
+     * these coefficients carry no bit. Keep a margin of three
+     * standard deviations (sqrt( ones ) / 2) of that number.
+     */
+    deviation = ( 3 * f4_isqrt( ones ) + 1 ) / 2;
 
-     //printf( "next %p\n", (void*)( current->next ) );
-     current = current->next;
+    *capacity = ( count > ( ones / 2 ) + deviation ) ?
+      ( count - ( ones / 2 ) - deviation ) / 8 : 0;
+
+    return 1;
   }
 
-  // Always return success.
-  return 1;
+  return f4_simulate_capacity( info, array, k, count, capacity );
 }
 
-int f4_embed_message(
-  j_common_ptr info,
-  jvirt_barray_ptr* coef_arrays,
-  const char* data,
-  const size_t length
-)
+/*
+ * Reads file at once, returns NULL on failure.
+ */
+LOCAL(char*)
+f4_read_file( const char* filename, size_t* size )
 {
-  unsigned int mbits = ( length ) * 8;
-  unsigned int mbit = 0;
+  FILE * fp;
+  char* buffer = NULL;
+  long end;
 
-  // Variables used while evaluating coefficients.
-  JDIMENSION rows_to_read;
-  JDIMENSION rows_read;
-  JDIMENSION rows;
-  JDIMENSION row;
-  JDIMENSION blocks;
-  JDIMENSION block;
-  JDIMENSION coeffs = sizeof( JBLOCK ) / sizeof( JCOEF );
-  JDIMENSION coeff;
-  JBLOCKARRAY blockarray;
-  JBLOCKROW blockrow;
-  JCOEF value;
-  JCOEF bit;
+  if ((fp = fopen(filename, READ_BINARY)) == NULL) {
+    return NULL;
+  }
+
+  if ( ( fseek( fp, 0, SEEK_END ) == 0 ) && ( ( end = ftell( fp ) ) > 0 ) &&
+       ( fseek( fp, 0, SEEK_SET ) == 0 ) )
+  {
+     buffer = (char*)malloc( (size_t)end );
+     if ( ( buffer != NULL ) && ( fread( buffer, 1, (size_t)end, fp ) != (size_t)end ) )
+     {
+        free( buffer );
+        buffer = NULL;
+     }
+     *size = (size_t)end;
+  }
+
+  fclose(fp);
+
+  return buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-  //int count = 0;
-  jvirt_barray_ptr current = *coef_arrays;
+int
+f4_cover_open( const char* image, const size_t size, f4_cover** cover )
+{
+  f4_cover* c;
+  jvirt_barray_ptr array;
 
-  // Evaluate coefficients.
-  while ( current != 0 )
+  if ( ( c = (f4_cover*)calloc( 1, sizeof( f4_cover ) ) ) == NULL )
   {
-     //printf( "loop %d\n", ++count );
+    return 2;
+  }
 
-     rows_to_read = current->rows_in_array;
-     rows_read = 0;
+  /* Initialize the JPEG decompression object with default error handling. */
+  c->srcinfo.err = jpeg_std_error(&c->jsrcerr.pub);
+  c->jsrcerr.pub.error_exit = my_error_exit;
+  if (setjmp(c->jsrcerr.setjmp_buffer))
+  {
+    jpeg_destroy_decompress(&c->srcinfo);
+    free(c->original);
+    free(c);
+    return 1;
+  }
+  jpeg_create_decompress(&c->srcinfo);
 
-     while ( rows_to_read > 0 )
-     {
-        // Determine number of rows allowed to read at once.
-        rows = MIN( rows_to_read, current->maxaccess );
-
-        // Read!
-        blockarray = info->mem->access_virt_barray(
-              info,
-              current,
-              current->cur_start_row + rows_read,  // start
-              rows,                                         // rows
-              1                                             // writable
-           );
+  /* Specify data source for decompression */
+  jpeg_mem_src(&c->srcinfo, (unsigned char*)image, size);
 
-        rows_to_read -= rows;
-        rows_read += rows;
+  /* Enable saving of extra markers that we want to copy */
+#ifdef __gnu_linux__
+  jcopy_markers_setup(&c->srcinfo, JCOPYOPT_DEFAULT);
+#endif
 
-        // Iterate.
-        for ( row = 0; row < rows; ++row )
-        {
-            blockrow = blockarray[ row ];
-            blocks = current->blocksperrow;
-
-            for ( block = 0; block < blocks; ++block )
-            {
-               // Ignore last coefficient.
-               for ( coeff = 0; coeff < ( coeffs - 1 ); ++coeff )
-               {
-                  // Go on if there is nothing left to embed.
-                  if ( mbit == mbits )
-                  {
-                     continue;
-                  }
-
-                  bit = data[ mbit / 8 ] >> ( 7 - ( mbit % 8 ) );
-                  bit &= 1;
-
-                  value = blockrow[ block ][ coeff ];
-
-                  // Ignore zero values.
-                  if ( value == 0 )
-                  {
-                     continue;
-                  }
-                  else if ( value > 0 )
-                  {
-                     if ( ( value & 1 ) != bit )
-                     {
-                        --value;
-                     }
-                  }
-                  else
-                  {
-                     if ( ( value & 1 ) == bit )
-                     {
-                        ++value;
-                     }
-                  }
-
-                  blockrow[ block ][ coeff ] = value;
-                  if ( value != 0 )
-                  {
-                     ++mbit;
-                  }
-               }
-            }
-        }
-     }
+  /* Read file header */
+  (void) jpeg_read_header(&c->srcinfo, TRUE);
+
+  /* Read source file as DCT coefficients, these consume all input
+   * until JPEG_REACHED_EOI, image is not needed any longer.
+   * We cannot call jpeg_finish_decompress since we still need the
+   * virtual arrays allocated from the source object.
+   */
+  c->coef_arrays = jpeg_read_coefficients(&c->srcinfo);
 
-     //printf( "next %p\n", (void*)( current->next ) );
-     current = current->next;
+  array = c->coef_arrays[ 0 ];
+  c->original = (JBLOCK*)malloc(
+     (size_t)array->rows_in_array * array->blocksperrow * sizeof( JBLOCK ) );
+  if ( c->original == NULL )
+  {
+    jpeg_destroy_decompress(&c->srcinfo);
+    free(c);
+    return 2;
   }
 
-  // All data embedded?
-  return ( mbit == mbits );
-}
+  f4_cover_copy( c, 0 );
 
-////////////////////////////////////////////////////////////////////////////////
+  *cover = c;
+
+  return 0;
+}
 
-/*
- * Embeds data into image read from filename_in and
- * writes result to filename_out.
- */
 int
-f4_embed( const char *filename_in, const char* filename_out, const char* data, const size_t length )
+f4_cover_embed( f4_cover* cover, const char* data, const size_t length, char** image, size_t* size )
 {
-  JCOPY_OPTION copyoption = JCOPYOPT_DEFAULT;
-  struct jpeg_decompress_struct srcinfo;
   struct jpeg_compress_struct dstinfo;
-  struct my_error_mgr jsrcerr, jdsterr;
-  jvirt_barray_ptr * src_coef_arrays = 0;
-  jvirt_barray_ptr * dst_coef_arrays = 0;
-
-  /* We assume all-in-memory processing and can therefore use only a
-   * single file pointer for sequential input and output operation.
-   */
-  FILE * fp;
+  struct my_error_mgr jdsterr;
+  unsigned char* buffer = NULL;
+  unsigned long buffer_size = 0;
 
-  /* Initialize the JPEG decompression object with default error handling. */
-  srcinfo.err = jpeg_std_error(&jsrcerr.pub);
-  jsrcerr.pub.error_exit = my_error_exit;
-  if (setjmp(jsrcerr.setjmp_buffer))
+  if (setjmp(cover->jsrcerr.setjmp_buffer))
   {
-    jpeg_destroy_decompress(&srcinfo);
     return 1;
   }
-  jpeg_create_decompress(&srcinfo);
+
+  /* Embed into the original coefficients every time. */
+  f4_cover_copy( cover, 1 );
+
+////////////////////////////////////////////////////////////////////////////////
+
+  if ( ! f4_embed_message( (j_common_ptr)&cover->srcinfo, cover->coef_arrays, data, length ) )
+  {
+    return 4;
+  }
+
+////////////////////////////////////////////////////////////////////////////////
 
   /* Initialize the JPEG compression object with default error handling. */
   dstinfo.err = jpeg_std_error(&jdsterr.pub);
   jdsterr.pub.error_exit = my_error_exit;
-  if (setjmp(jsrcerr.setjmp_buffer))
+  if (setjmp(jdsterr.setjmp_buffer))
   {
-    jpeg_destroy_decompress(&srcinfo);
+    /* Buffer may have been replaced by the destination manager already,
+     * it is not ours to free.
+     */
     jpeg_destroy_compress(&dstinfo);
     return 2;
   }
   jpeg_create_compress(&dstinfo);
 
-  /* Set memory limit to 10M. */
-  dstinfo.mem->max_memory_to_use = 10000000;
-  srcinfo.mem->max_memory_to_use = dstinfo.mem->max_memory_to_use;
+  /* Initialize destination compression parameters from source values */
+  jpeg_copy_critical_parameters(&cover->srcinfo, &dstinfo);
 
-  /* Open the input file. */
-  if ((fp = fopen(filename_in, READ_BINARY)) == NULL) {
-    jpeg_destroy_decompress(&srcinfo);
-    jpeg_destroy_compress(&dstinfo);
-    return 3;
-  }
+  /* Optimize Huffman table (smaller file, but slow compression) */
+  dstinfo.optimize_coding = TRUE;
 
-  /* Specify data source for decompression */
-  jpeg_stdio_src(&srcinfo, fp);
+  /* Specify data destination for compression */
+  jpeg_mem_dest(&dstinfo, &buffer, &buffer_size);
 
-  /* Enable saving of extra markers that we want to copy */
+  /* Start compressor (note no image data is actually written here) */
+  jpeg_write_coefficients(&dstinfo, cover->coef_arrays);
+
+  /* Copy to the output any extra markers that we want to preserve */
 #ifdef __gnu_linux__
-  jcopy_markers_setup(&srcinfo, copyoption);
+  jcopy_markers_execute(&cover->srcinfo, &dstinfo, JCOPYOPT_DEFAULT);
 #endif
 
-  /* Read file header */
-  (void) jpeg_read_header(&srcinfo, TRUE);
+  /* Finish compression and release memory (but buffer) */
+  jpeg_finish_compress(&dstinfo);
+  jpeg_destroy_compress(&dstinfo);
 
-  /* Read source file as DCT coefficients */
-  src_coef_arrays = jpeg_read_coefficients(&srcinfo);
+  *image = (char*)buffer;
+  *size = buffer_size;
 
-////////////////////////////////////////////////////////////////////////////////
+  /* All done. */
+  return 0;
+}
+
+int
+f4_cover_capacity( f4_cover* cover, const int k, size_t* capacity )
+{
+  if (setjmp(cover->jsrcerr.setjmp_buffer))
+  {
+    return 1;
+  }
+
+  /* Count the original coefficients. */
+  f4_cover_copy( cover, 1 );
+
+  return ( f4_count_capacity( (j_common_ptr)&cover->srcinfo, cover->coef_arrays[ 0 ], k, capacity ) ? 0 : 1 );
+}
 
-  if ( ! f4_embed_message( (j_common_ptr)&srcinfo, src_coef_arrays, data, length ) )
+void
+f4_cover_close( f4_cover* cover )
+{
+  if ( cover == NULL )
   {
-    jpeg_destroy_decompress(&srcinfo);
-    jpeg_destroy_compress(&dstinfo);
-    return 4;
+    return;
   }
 
+  jpeg_destroy_decompress(&cover->srcinfo);
+  free(cover->original);
+  free(cover);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-  /* Initialize destination compression parameters from source values */
-  jpeg_copy_critical_parameters(&srcinfo, &dstinfo);
+/*
+ * Embeds data into image read from filename_in and
+ * writes result to filename_out.
+ */
+int
+f4_embed( const char *filename_in, const char* filename_out, const char* data, const size_t length )
+{
+  f4_cover* cover;
+  char* image;
+  size_t size = 0;
+  FILE * fp;
+  int rc;
 
-  /* Optimize Huffman table (smaller file, but slow compression) */
-  dstinfo.optimize_coding = TRUE;
+  /* Read the input file. */
+  if ((image = f4_read_file(filename_in, &size)) == NULL) {
+    return 3;
+  }
 
-  /* Copy arrays */
-  dst_coef_arrays = src_coef_arrays;
+  rc = f4_cover_open( image, size, &cover );
+  free( image );
 
-  /* Close input file, if we opened it.
-   * Note: we assume that jpeg_read_coefficients consumed all input
-   * until JPEG_REACHED_EOI, and that jpeg_finish_decompress will
-   * only consume more while (! cinfo->inputctl->eoi_reached).
-   * We cannot call jpeg_finish_decompress here since we still need the
-   * virtual arrays allocated from the source object for processing.
-   */
-  fclose(fp);
+  if ( rc != 0 )
+  {
+    return 1;
+  }
+
+  rc = f4_cover_embed( cover, data, length, &image, &size );
+  f4_cover_close( cover );
+
+  if ( rc != 0 )
+  {
+    return rc;
+  }
 
   /* Open the output file. */
-  if ((fp = fopen(filename_out, WRITE_BINARY)) == NULL)
+  if ((fp = fopen(filename_out, WRITE_BINARY)) == NULL) {
+    free( image );
+    return 5;
+  }
+
+  rc = ( fwrite( image, 1, size, fp ) == size ) ? 0 : 5;
+
+  /* Close output file */
+  fclose(fp);
+  free( image );
+
+  return rc;
+}
+
+/*
+ * Extracts data out of image read from fp (or image if fp is NULL)
+ * and writes result to data.
+ */
+LOCAL(int)
+f4_extract_source(
+  FILE * fp,
+  const char* image,
+  const size_t size,
+  char* data,
+  const size_t length,
+  size_t* extracted
+)
+{
+  struct jpeg_decompress_struct srcinfo;
+  struct my_error_mgr jsrcerr;
+  struct f4_progress_mgr progress;
+  struct f4_extraction extraction;
+  jvirt_barray_ptr * src_coef_arrays;
+
+  memset( data, 0, length );
+  memset( &extraction, 0, sizeof( extraction ) );
+  extraction.data = data;
+  extraction.length = length;
+  extraction.needed = length * 8;
+  extraction.framed = -1;
+
+  /* Initialize the JPEG decompression object with default error handling. */
+  srcinfo.err = jpeg_std_error(&jsrcerr.pub);
+  jsrcerr.pub.error_exit = my_error_exit;
+  if (setjmp(jsrcerr.setjmp_buffer))
   {
     jpeg_destroy_decompress(&srcinfo);
-    jpeg_destroy_compress(&dstinfo);
-    return 5;
+    if ( extraction.k > 1 )
+    {
+      free( extraction.data );
+    }
+    return 1;
   }
+  jpeg_create_decompress(&srcinfo);
 
-  /* Specify data destination for compression */
-  jpeg_stdio_dest(&dstinfo, fp);
+  /* Set memory limit to 10M. */
+  srcinfo.mem->max_memory_to_use = 10000000;
 
-  /* Start compressor (note no image data is actually written here) */
-  jpeg_write_coefficients(&dstinfo, dst_coef_arrays);
+  /* Specify data source for decompression */
+  if ( fp != NULL )
+  {
+    jpeg_stdio_src(&srcinfo, fp);
+  }
+  else
+  {
+    jpeg_mem_src(&srcinfo, (unsigned char*)image, size);
+  }
 
-  /* Copy to the output file any extra markers that we want to preserve */
-#ifdef __gnu_linux__
-  jcopy_markers_execute(&srcinfo, &dstinfo, copyoption);
-#endif
+  /* Read file header */
+  (void) jpeg_read_header(&srcinfo, TRUE);
+
+////////////////////////////////////////////////////////////////////////////////
+
+  /* Extract data while decoding, stop as soon as it is complete. */
+  memset( &progress, 0, sizeof( progress ) );
+  progress.pub.progress_monitor = f4_progress_monitor;
+  progress.extraction = &extraction;
+  srcinfo.progress = &progress.pub;
+
+  if (setjmp(progress.done_buffer))
+  {
+    jpeg_abort_decompress(&srcinfo);
+  }
+  else
+  {
+    /* Read source file as DCT coefficients */
+    src_coef_arrays = jpeg_read_coefficients(&srcinfo);
+    extraction.array = src_coef_arrays[ 0 ];
+
+    /* Multiple scans or data not complete yet. */
+    f4_extract_parallel( (j_common_ptr)&srcinfo, &extraction );
+
+    (void) jpeg_finish_decompress(&srcinfo);
+  }
+
+////////////////////////////////////////////////////////////////////////////////
 
-  /* Finish compression and release memory */
-  jpeg_finish_compress(&dstinfo);
-  jpeg_destroy_compress(&dstinfo);
-  (void) jpeg_finish_decompress(&srcinfo);
   jpeg_destroy_decompress(&srcinfo);
 
-  /* Close output file, if we opened it */
-  fclose(fp);
+  if ( extraction.framed != 1 )
+  {
+    /* No header, return everything like older versions did. */
+    *extracted = length;
+    return 0;
+  }
+
+  if ( extraction.k > 1 )
+  {
+    /* Header has been copied into data already. */
+    if ( ! extraction.invalid && ( extraction.mbits >= extraction.needed ) )
+    {
+      f4_decode_matrix( extraction.data, data, extraction.payload, extraction.k );
+    }
+    free( extraction.data );
+    extraction.data = data;
+  }
+
+  if ( extraction.invalid || ( extraction.mbits < extraction.needed ) )
+  {
+    return 3;
+  }
+
+  /* Strip header. */
+  *extracted = extraction.payload;
+  memmove( data, data + F4_HEADER_SIZE, *extracted );
 
   /* All done. */
   return 0;
@@ -435,15 +1364,45 @@ f4_embed( const char *filename_in, const char* filename_out, const char* data, c
  * writes result to data.
  */
 int
-f4_extract( const char *filename, char* data, const size_t length )
+f4_extract( const char *filename, char* data, const size_t length, size_t* extracted )
+{
+  FILE * fp;
+  int rc;
+
+  /* Open the input file. */
+  if ((fp = fopen(filename, READ_BINARY)) == NULL) {
+    return 2;
+  }
+
+  rc = f4_extract_source( fp, NULL, 0, data, length, extracted );
+
+  /* Close input file */
+  fclose(fp);
+
+  return rc;
+}
+
+/*
+ * Extracts data out of image and writes result to data.
+ */
+int
+f4_extract_mem( const char* image, const size_t size, char* data, const size_t length, size_t* extracted )
+{
+  return f4_extract_source( NULL, image, size, data, length, extracted );
+}
+
+/*
+ * Estimates how many bytes can be embedded into image read
+ * from filename, coefficients are only entropy decoded.
+ */
+int
+f4_capacity( const char *filename, const int k, size_t* capacity )
 {
   struct jpeg_decompress_struct srcinfo;
   struct my_error_mgr jsrcerr;
   jvirt_barray_ptr * src_coef_arrays;
+  int success;
 
-  /* We assume all-in-memory processing and can therefore use only a
-   * single file pointer for sequential input and output operation.
-   */
   FILE * fp;
 
   /* Initialize the JPEG decompression object with default error handling. */
@@ -474,18 +1433,14 @@ f4_extract( const char *filename, char* data, const size_t length )
   /* Read source file as DCT coefficients */
   src_coef_arrays = jpeg_read_coefficients(&srcinfo);
 
-////////////////////////////////////////////////////////////////////////////////
-
-  int success = f4_extract_message( (j_common_ptr)&srcinfo, src_coef_arrays, data, length );
-
-////////////////////////////////////////////////////////////////////////////////
+  success = f4_count_capacity( (j_common_ptr)&srcinfo, src_coef_arrays[ 0 ], k, capacity );
 
   (void) jpeg_finish_decompress(&srcinfo);
   jpeg_destroy_decompress(&srcinfo);
 
-  /* Close output file, if we opened it */
+  /* Close input file. */
   fclose(fp);
 
   /* All done. */
-  return ( success ? 0 : 3 );
+  return ( success ? 0 : 1 );
 }
@@ -30,9 +30,27 @@
 extern "C" {
 #endif
 
+/**
+ * Data embedded by F4::embed() starts with a header consisting
+ * of F4_MAGIC and the length of the payload (32 bit, big endian).
+ * It allows f4_extract() to stop as soon as the payload is complete.
+ *
+ * The last character of the magic ('1' ... '0' + F4_MAX_K) selects
+ * how the payload is embedded. '1' is plain F4, one bit per non zero
+ * coefficient. k > 1 selects matrix encoding (like F5): a group of
+ * 2^k - 1 non zero coefficients carries k bits using a (1, 2^k - 1, k)
+ * Hamming code, at most one coefficient per group is changed. The
+ * header itself is always embedded with plain F4.
+ */
+#define F4_MAGIC "SF41"
+#define F4_MAGIC_SIZE 4
+#define F4_HEADER_SIZE 8
+#define F4_MAX_K 7
+
 /**
  * Takes image in <tt>filename_in</tt>, embeds <tt>data</tt> and
- * writes result to <tt>filename_out</tt>.
+ * writes result to <tt>filename_out</tt>. If <tt>data</tt> starts
+ * with a header, the payload is embedded as selected by its magic.
  *
  * @param filename_in source image
  * @param filename_out target image
@@ -57,10 +75,15 @@ int f4_embed(
  * Extracts data out of <tt>filename_in</tt> and writes
  * it to <tt>data</tt>.
  *
+ * If the embedded data starts with a header, extraction stops
+ * as soon as the payload is complete and the payload (without
+ * header) is moved to the front of <tt>data</tt>. Otherwise
+ * <tt>data</tt> is filled completely.
+ *
  * @param filename_in source image
- * @param filename_out target image
- * @param data data to embed
- * @param length length of data to embed
+ * @param data buffer for extracted data
+ * @param length size of buffer
+ * @param extracted number of bytes extracted
  *
  * @return 0 => success,
  *         1 => internal error,
@@ -70,7 +93,126 @@ int f4_embed(
 int f4_extract(
    const char *filename,
    char* data,
-   const size_t length
+   const size_t length,
+   size_t* extracted
+   );
+
+/**
+ * Extracts data out of JPEG <tt>image</tt> held in memory,
+ * see f4_extract().
+ *
+ * @param image source image
+ * @param size size of image
+ * @param data buffer for extracted data
+ * @param length size of buffer
+ * @param extracted number of bytes extracted
+ *
+ * @return 0 => success,
+ *         1 => internal error,
+ *         3 => extracting failed
+ */
+int f4_extract_mem(
+   const char* image,
+   const size_t size,
+   char* data,
+   const size_t length,
+   size_t* extracted
+   );
+
+/**
+ * Decoded cover image. Its coefficients are kept, so data can
+ * be embedded repeatedly without decoding the image again.
+ */
+typedef struct f4_cover f4_cover;
+
+/**
+ * Decodes JPEG <tt>image</tt> held in memory into a cover.
+ * The image is not referenced after return.
+ *
+ * @param image source image
+ * @param size size of image
+ * @param cover decoded cover, to be released by f4_cover_close()
+ *
+ * @return 0 => success,
+ *         1 => internal error (no valid image),
+ *         2 => out of memory
+ */
+int f4_cover_open(
+   const char* image,
+   const size_t size,
+   f4_cover** cover
+   );
+
+/**
+ * Embeds <tt>data</tt> into the (original) coefficients of
+ * <tt>cover</tt> and encodes the result into <tt>image</tt>.
+ * If <tt>data</tt> starts with a header, the payload is embedded
+ * as selected by its magic.
+ *
+ * @param cover cover to embed data into
+ * @param data data to embed
+ * @param length length of data to embed
+ * @param image resulting image, to be released by free()
+ * @param size size of resulting image
+ *
+ * @return 0 => success,
+ *         1 => internal error,
+ *         2 => internal error,
+ *         4 => embedding failed
+ */
+int f4_cover_embed(
+   f4_cover* cover,
+   const char* data,
+   const size_t length,
+   char** image,
+   size_t* size
+   );
+
+/**
+ * Like f4_capacity(), but for a decoded cover.
+ *
+ * @param cover cover to check
+ * @param k Hamming code parameter of payload (1 => plain F4)
+ * @param capacity estimated capacity in bytes
+ *
+ * @return 0 => success,
+ *         1 => internal error
+ */
+int f4_cover_capacity(
+   f4_cover* cover,
+   const int k,
+   size_t* capacity
+   );
+
+/**
+ * Releases <tt>cover</tt>.
+ *
+ * @param cover cover to release (can be <tt>NULL</tt>)
+ */
+void f4_cover_close(
+   f4_cover* cover
+   );
+
+/**
+ * Estimates how many bytes can be embedded into <tt>filename</tt>
+ * (header included). Coefficients are entropy decoded only, no
+ * image is written. The estimate assumes random data (like
+ * encrypted containers), embedding may fail slightly below it.
+ * Matrix encoding (k > 1) holds less data, but changes fewer
+ * coefficients.
+ *
+ * @param filename image to check
+ * @param k Hamming code parameter of payload (1 => plain F4)
+ * @param capacity estimated capacity in bytes
+ *
+ * @return 0 => success,
+ *         1 => internal error,
+ *         2 => couldn't open filename
+ */
+int f4_capacity(
+   const char* filename,
+   const int k,
+   size_t* capacity
    );
 
 #ifdef __cplusplus
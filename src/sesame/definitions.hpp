@@ -44,6 +44,43 @@ namespace sesame
       PROTOCOL_SCRYPT_AES_CBC_SHA_V1
    };
 
+   /**
+    * The supported container formats, a container stores
+    * its format as major version.
+    */
+   enum Format
+   {
+      /** all entries are encrypted as a whole */
+      FORMAT_V0,
+      /** encrypted index plus separately encrypted entries (chunks) */
+      FORMAT_V1
+   };
+
+   /**
+    * The supported compression methods, applied to the
+    * serialized index and entries before encryption (format v1).
+    */
+   enum Compression
+   {
+      COMPRESSION_NONE,
+      /** raw deflate (zlib) */
+      COMPRESSION_DEFLATE
+   };
+
+   /**
+    * The output formats of entry listings (list, tree, tags,
+    * search and show).
+    */
+   enum OutputFormat
+   {
+      /** human readable trees */
+      OUTPUT_TEXT,
+      /** JSON Lines, one object per record */
+      OUTPUT_JSON,
+      /** msgpack, one map per record */
+      OUTPUT_MSGPACK
+   };
+
    /** The possible plaintext data types. */
    enum DataType
    {
@@ -26,16 +26,68 @@
 #ifndef SESAME_PACKAGING_HPP
 #define SESAME_PACKAGING_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
 
 #include "types.hpp"
 #include "msgpack.hpp"
+#include "msgpack/adaptor/KdfParams.hpp"
 #include "msgpack/adaptor/String.hpp"
+#include "msgpack/adaptor/Vector_String.hpp"
 #include "msgpack/adaptor/Vector_uint8.hpp"
 
 namespace sesame {
 
+namespace detail {
+
+/**
+ * Lets unpacked BIN, STR and EXT objects reference the buffer unpacked
+ * instead of copying them into the zone. The buffer is wiped on release
+ * (unlike the zone), so payloads are materialised exactly once, by the
+ * adaptors converting them.
+ *
+ * @return always <tt>true</tt>
+ */
+inline bool referencePayload( msgpack::type::object_type, std::size_t, void* )
+{
+   return true;
+}
+
+}
+
+/**
+ * Stream appending packed data to a vector, so packed data
+ * doesn't have to be copied out of a StringStream.
+ */
+class VectorStream
+{
+   public:
+      /**
+       * Ctor.
+       *
+       * @param v the vector to append to
+       */
+      explicit VectorStream( Vector<uint8_t>& v ) : m_Vector( v ) {}
+
+      /**
+       * Appends data (called by msgpack).
+       *
+       * @param data the data to append
+       * @param size the size of the data
+       */
+      void write( const char* data, const std::size_t size )
+      {
+         const uint8_t* begin( reinterpret_cast<const uint8_t*>( data ) );
+         m_Vector.insert( m_Vector.end(), begin, begin + size );
+      }
+
+   private:
+      /** the vector to append to */
+      Vector<uint8_t>& m_Vector;
+};
+
 /**
  * For easy serialization.
  *
@@ -79,7 +131,7 @@ std::istream& unpack( std::istream& i, T& e )
 
       try
       {
-         msgpack::unpack( &result, data.data(), data.size(), &offset );
+         msgpack::unpack( &result, data.data(), data.size(), &offset, nullptr, detail::referencePayload );
          msgpack::object o( result.get() );
          e = o.as<T>();
 
@@ -96,6 +148,11 @@ std::istream& unpack( std::istream& i, T& e )
          success = true;
          break;
       }
+      catch ( msgpack::parse_error& )
+      {
+         // Malformed data, reading more won't help.
+         break;
+      }
       catch ( msgpack::unpack_error& )
       {
          // Mmmhh, go on and read more data from stream ...
@@ -147,19 +204,33 @@ inline void readIntoVector( std::istream& i, Vector<uint8_t>& v )
    i.read( reinterpret_cast<char*>( v.data() ), size );
 }
 
+/**
+ * For easy serialization, appends the packed element to vector.
+ *
+ * @param v the vector to append to
+ * @param e the element to read from
+ */
+template <typename T>
+inline void appendV( Vector<uint8_t>& v, const T& e )
+{
+   VectorStream stream( v );
+   msgpack::pack( stream, e );
+}
+
 /**
  * For easy serialization.
  *
  * @param v the vector to write to
  * @param e the element to read from
+ * @param sizeHint the expected size (e.g. of the last run), avoids
+ *     reallocations (each wiping the old buffer) while packing
  */
 template <typename T>
-inline void packV( Vector<uint8_t>& v, const T& e )
+inline void packV( Vector<uint8_t>& v, const T& e, const std::size_t sizeHint = 0 )
 {
-   StringStream stream;
-   pack( stream, e );
-
-   readIntoVector( stream, v );
+   v.clear();
+   v.reserve( sizeHint );
+   appendV( v, e );
 }
 
 /**
@@ -0,0 +1,645 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+#include "sesame/Data.hpp"
+#include "sesame/Entry.hpp"
+#include "sesame/Instance.hpp"
+#include "sesame/transfer.hpp"
+#include "sesame/utils/csv.hpp"
+#include "sesame/utils/filesystem.hpp"
+#include "sesame/utils/json.hpp"
+#include "sesame/utils/parallel.hpp"
+#include "sesame/utils/string.hpp"
+#include "sesame/utils/RecordWriter.hpp"
+
+using sesame::Data;
+using sesame::Entry;
+using sesame::Instance;
+using sesame::utils::JsonValue;
+
+
+namespace
+{
+   const std::size_t BATCH_SIZE( 512 );
+   const String PASSWORD_PREFIX( "password:" );
+   const String KEY_PREFIX( "key:" );
+
+   enum ColumnType
+   {
+      COLUMN_NAME,
+      COLUMN_TAGS,
+      COLUMN_GROUP,
+      COLUMN_PASSWORD,
+      COLUMN_KEY,
+      COLUMN_ATTRIBUTE
+   };
+
+   struct Column
+   {
+      ColumnType m_Type;
+      String m_Label;
+   };
+
+   String toLower( const String& s )
+   {
+      String result( s );
+      std::transform( result.begin(), result.end(), result.begin(), ::tolower );
+      return result;
+   }
+
+   bool startsWith( const String& s, const String& prefix )
+   {
+      return s.size() > prefix.size() && s.compare( 0, prefix.size(), prefix ) == 0;
+   }
+
+   String toHex( const Vector<uint8_t>& data )
+   {
+      StringStream s;
+      s << std::hex << std::setfill( '0' );
+      for ( const auto byte : data )
+      {
+         s << std::setw( 2 ) << static_cast<uint32_t>( byte );
+      }
+      return s.str();
+   }
+
+   Vector<uint8_t> fromHex( const String& hex )
+   {
+      if ( hex.size() % 2 != 0 || hex.find_first_not_of( "0123456789abcdefABCDEF" ) != String::npos )
+      {
+         throw std::runtime_error( "invalid key" );
+      }
+
+      auto nibble = []( const char c ) -> uint8_t
+      {
+         return static_cast<uint8_t>( c <= '9' ? c - '0' : ( ::tolower( c ) - 'a' + 10 ) );
+      };
+
+      Vector<uint8_t> result;
+      result.reserve( hex.size() / 2 );
+      for ( std::size_t i = 0; i < hex.size(); i += 2 )
+      {
+         result.push_back( static_cast<uint8_t>( ( nibble( hex[ i ] ) << 4 ) | nibble( hex[ i + 1 ] ) ) );
+      }
+      return result;
+   }
+
+   const Vector<Column> toColumns( const Vector<String>& header )
+   {
+      Vector<Column> columns;
+      std::size_t names( 0 );
+
+      for ( const auto& field : header )
+      {
+         const String label( sesame::utils::strip( field ) );
+         const String lower( toLower( label ) );
+         Column column;
+
+         if ( lower == "name" || lower == "title" || lower == "account" )
+         {
+            column.m_Type = COLUMN_NAME;
+            ++names;
+         }
+         else if ( lower == "tags" )
+         {
+            column.m_Type = COLUMN_TAGS;
+         }
+         else if ( lower == "group" )
+         {
+            column.m_Type = COLUMN_GROUP;
+         }
+         else if ( lower == "password" )
+         {
+            column.m_Type = COLUMN_PASSWORD;
+            column.m_Label = sesame::utils::fromUtf8( label );
+         }
+         else if ( startsWith( lower, PASSWORD_PREFIX ) )
+         {
+            column.m_Type = COLUMN_PASSWORD;
+            column.m_Label = sesame::utils::fromUtf8( label.substr( PASSWORD_PREFIX.size() ) );
+         }
+         else if ( startsWith( lower, KEY_PREFIX ) )
+         {
+            column.m_Type = COLUMN_KEY;
+            column.m_Label = sesame::utils::fromUtf8( label.substr( KEY_PREFIX.size() ) );
+         }
+         else
+         {
+            column.m_Type = COLUMN_ATTRIBUTE;
+            column.m_Label = sesame::utils::fromUtf8( label );
+         }
+
+         if ( column.m_Type != COLUMN_NAME && column.m_Type != COLUMN_TAGS &&
+              column.m_Type != COLUMN_GROUP && column.m_Label.empty() )
+         {
+            throw std::runtime_error( "empty column name" );
+         }
+
+         columns.push_back( column );
+      }
+
+      if ( names != 1 )
+      {
+         throw std::runtime_error( "exactly one name column required" );
+      }
+
+      return columns;
+   }
+
+   void addData( Entry& entry, const String& label, const Data& data )
+   {
+      if ( ! entry.addLabeledData( label, data ) )
+      {
+         throw std::runtime_error( "duplicate label" );
+      }
+   }
+
+   Entry csvToEntry( const Vector<String>& row, const Vector<Column>& columns )
+   {
+      if ( row.size() > columns.size() )
+      {
+         throw std::runtime_error( "too many fields" );
+      }
+
+      String name;
+      for ( std::size_t i = 0; i < row.size(); ++i )
+      {
+         if ( columns[ i ].m_Type == COLUMN_NAME )
+         {
+            name = sesame::utils::fromUtf8( sesame::utils::strip( row[ i ] ) );
+         }
+      }
+      if ( name.empty() )
+      {
+         throw std::runtime_error( "empty name" );
+      }
+
+      // Values (passwords, attributes) are taken as they are.
+      Entry entry( name );
+      for ( std::size_t i = 0; i < row.size(); ++i )
+      {
+         const String& field( row[ i ] );
+         const Column& column( columns[ i ] );
+         if ( sesame::utils::strip( field ).empty() )
+         {
+            continue;
+         }
+
+         switch ( column.m_Type )
+         {
+            case COLUMN_NAME:
+               break;
+            case COLUMN_TAGS:
+            {
+               StringStream tags( field );
+               String tag;
+               while ( std::getline( tags, tag, ';' ) )
+               {
+                  tag = sesame::utils::strip( tag );
+                  if ( ! tag.empty() )
+                  {
+                     entry.addTag( sesame::utils::fromUtf8( tag ) );
+                  }
+               }
+               break;
+            }
+            case COLUMN_GROUP:
+               entry.addTag( sesame::utils::fromUtf8( sesame::utils::strip( field ) ) );
+               break;
+            case COLUMN_PASSWORD:
+               addData( entry, column.m_Label, Data( sesame::utils::fromUtf8( field ) ) );
+               break;
+            case COLUMN_KEY:
+               addData( entry, column.m_Label, Data( fromHex( sesame::utils::strip( field ) ) ) );
+               break;
+            case COLUMN_ATTRIBUTE:
+               if ( ! entry.addAttribute( column.m_Label, sesame::utils::fromUtf8( field ) ) )
+               {
+                  throw std::runtime_error( "duplicate attribute" );
+               }
+               break;
+         }
+      }
+
+      return entry;
+   }
+
+   String getString( const JsonValue* value )
+   {
+      if ( ! value || value->m_Type != JsonValue::JSON_STRING )
+      {
+         throw std::runtime_error( "invalid record" );
+      }
+      return sesame::utils::fromUtf8( value->m_String );
+   }
+
+   Entry jsonToEntry( const String& line )
+   {
+      const JsonValue record( sesame::utils::parseJson( line ) );
+      if ( record.m_Type != JsonValue::JSON_OBJECT )
+      {
+         throw std::runtime_error( "invalid record" );
+      }
+
+      const String name( sesame::utils::strip( getString( record.find( "name" ) ) ) );
+      if ( name.empty() )
+      {
+         throw std::runtime_error( "empty name" );
+      }
+      Entry entry( name );
+
+      const JsonValue* tags( record.find( "tags" ) );
+      if ( tags )
+      {
+         for ( const auto& tag : tags->m_Array )
+         {
+            entry.addTag( getString( &tag ) );
+         }
+      }
+
+      const JsonValue* attributes( record.find( "attributes" ) );
+      if ( attributes )
+      {
+         for ( const auto& attribute : attributes->m_Object )
+         {
+            if ( ! entry.addAttribute(
+                    sesame::utils::fromUtf8( attribute.first ), getString( &( attribute.second ) ) ) )
+            {
+               throw std::runtime_error( "duplicate attribute" );
+            }
+         }
+      }
+
+      const JsonValue* data( record.find( "data" ) );
+      if ( data )
+      {
+         for ( const auto& date : data->m_Array )
+         {
+            const String label( getString( date.find( "label" ) ) );
+            const String type( getString( date.find( "type" ) ) );
+            if ( type == "password" )
+            {
+               addData( entry, label, Data( getString( date.find( "value" ) ) ) );
+            }
+            else if ( type == "key" )
+            {
+               addData( entry, label, Data( fromHex( getString( date.find( "value" ) ) ) ) );
+            }
+            else
+            {
+               throw std::runtime_error( "invalid data type" );
+            }
+         }
+      }
+
+      return entry;
+   }
+
+   template<typename T, typename F>
+   void convertBatch( const Vector<T>& records, const std::size_t begin, F toEntry, Vector<Entry>& entries )
+   {
+      Vector<std::size_t> indexes;
+      for ( std::size_t i = begin; i < records.size(); ++i )
+      {
+         indexes.push_back( i );
+      }
+      entries.resize( records.size() );
+
+      // Conversion (incl. transcoding) on all cores.
+      sesame::utils::runParallel(
+         indexes,
+         [ & ]( const std::size_t i ) { entries[ i ] = toEntry( records[ i ] ); },
+         64 );
+   }
+
+   template<typename T, typename F>
+   std::size_t addAll( Instance& instance, const Vector<T>& records, Vector<Entry>& entries, F toEntry )
+   {
+      std::size_t added( 0 );
+      try
+      {
+         for ( ; added < entries.size(); ++added )
+         {
+            // Random ids may collide, retry with new ones.
+            std::size_t attempts( 0 );
+            while ( ! instance.addEntry( entries[ added ] ) )
+            {
+               if ( ++attempts > 8 )
+               {
+                  throw std::runtime_error( "failed to add entry" );
+               }
+               entries[ added ] = toEntry( records[ added ] );
+            }
+         }
+      }
+      catch ( std::runtime_error& )
+      {
+         // All or nothing.
+         for ( std::size_t i = 0; i < added; ++i )
+         {
+            instance.deleteEntry( entries[ i ] );
+         }
+         throw;
+      }
+
+      return added;
+   }
+
+   void skipBom( std::istream& stream )
+   {
+      if ( stream.peek() == 0xef )
+      {
+         char bom[ 3 ];
+         stream.read( bom, 3 );
+         if ( ! stream || bom[ 1 ] != '\xbb' || bom[ 2 ] != '\xbf' )
+         {
+            throw std::runtime_error( "invalid byte order mark" );
+         }
+      }
+   }
+
+   const Vector<Entry> toSortedVector( const Set<Entry>& entries )
+   {
+      Vector<Entry> result( entries.begin(), entries.end() );
+      std::sort(
+         result.begin(),
+         result.end(),
+         []( const Entry& a, const Entry& b )
+         {
+            return a.getName() < b.getName() || ( a.getName() == b.getName() && a < b );
+         }
+         );
+      return result;
+   }
+
+   void writeCsv( std::ostream& stream, const Vector<Entry>& entries )
+   {
+      Set<String> attributeNames;
+      Set<String> passwordLabels;
+      Set<String> keyLabels;
+      for ( const auto& entry : entries )
+      {
+         for ( const auto& attribute : entry.getAttributes() )
+         {
+            attributeNames.insert( attribute.first );
+         }
+         for ( const auto& date : entry.getLabeledData() )
+         {
+            ( date.second.getType() == sesame::DATA_TEXT ? passwordLabels : keyLabels ).insert( date.first );
+         }
+      }
+
+      Vector<String> fields = { "name", "tags" };
+      for ( const auto& name : attributeNames )
+      {
+         fields.push_back( sesame::utils::toUtf8( name ) );
+      }
+      for ( const auto& label : passwordLabels )
+      {
+         fields.push_back( PASSWORD_PREFIX + sesame::utils::toUtf8( label ) );
+      }
+      for ( const auto& label : keyLabels )
+      {
+         fields.push_back( KEY_PREFIX + sesame::utils::toUtf8( label ) );
+      }
+      sesame::utils::writeCsvRecord( stream, fields );
+
+      for ( const auto& entry : entries )
+      {
+         const Map<String,String> attributes( entry.getAttributes() );
+         const Map<String,Data> data( entry.getLabeledData() );
+
+         fields.clear();
+         fields.push_back( sesame::utils::toUtf8( entry.getName() ) );
+
+         String tags;
+         for ( const auto& tag : entry.getTags() )
+         {
+            tags.append( tags.empty() ? "" : ";" ).append( sesame::utils::toUtf8( tag ) );
+         }
+         fields.push_back( tags );
+
+         for ( const auto& name : attributeNames )
+         {
+            auto it( attributes.find( name ) );
+            fields.push_back( it == attributes.end() ? "" : sesame::utils::toUtf8( it->second ) );
+         }
+         for ( const auto& label : passwordLabels )
+         {
+            auto it( data.find( label ) );
+            fields.push_back(
+               ( it == data.end() || it->second.getType() != sesame::DATA_TEXT ) ?
+               "" : sesame::utils::toUtf8( it->second.getPlaintext<String>() ) );
+         }
+         for ( const auto& label : keyLabels )
+         {
+            auto it( data.find( label ) );
+            fields.push_back(
+               ( it == data.end() || it->second.getType() == sesame::DATA_TEXT ) ?
+               "" : toHex( it->second.getPlaintext<Vector<uint8_t>>() ) );
+         }
+         sesame::utils::writeCsvRecord( stream, fields );
+      }
+   }
+
+   void writeJson( std::ostream& stream, const Vector<Entry>& entries )
+   {
+      sesame::utils::RecordWriter writer( stream, sesame::OUTPUT_JSON );
+
+      for ( const auto& entry : entries )
+      {
+         const Set<String> tags( entry.getTags() );
+         const Map<String,String> attributes( entry.getAttributes() );
+         const Map<String,Data> data( entry.getLabeledData() );
+
+         writer.beginMap( 5 );
+         writer.value( "id" ).value( entry.getIdAsHexString() );
+         writer.value( "name" ).value( entry.getName() );
+
+         writer.value( "tags" ).beginArray( tags.size() );
+         for ( const auto& tag : tags )
+         {
+            writer.value( tag );
+         }
+         writer.end();
+
+         writer.value( "attributes" ).beginMap( attributes.size() );
+         for ( const auto& attribute : attributes )
+         {
+            writer.value( attribute.first ).value( attribute.second );
+         }
+         writer.end();
+
+         writer.value( "data" ).beginArray( data.size() );
+         for ( const auto& date : data )
+         {
+            const bool isPassword( date.second.getType() == sesame::DATA_TEXT );
+
+            writer.beginMap( 3 );
+            writer.value( "label" ).value( date.first );
+            writer.value( "type" ).value( isPassword ? "password" : "key" );
+            writer.value( "value" ).value(
+               isPassword ? date.second.getPlaintext<String>() :
+               toHex( date.second.getPlaintext<Vector<uint8_t>>() ) );
+            writer.end();
+         }
+         writer.end();
+
+         writer.end();
+      }
+   }
+}
+
+namespace sesame {
+
+TransferFormat getTransferFormat( const String& path )
+{
+   const String extension( toLower( utils::getExtension( path ) ) );
+
+   if ( extension == "csv" )
+   {
+      return TRANSFER_CSV;
+   }
+   else if ( extension == "json" || extension == "jsonl" )
+   {
+      return TRANSFER_JSON;
+   }
+   else
+   {
+      throw std::runtime_error( "unknown file format (use .csv or .json)" );
+   }
+}
+
+std::size_t importEntries(
+   Instance& instance,
+   std::istream& stream,
+   const TransferFormat format,
+   const std::function<void( std::size_t )>& progress
+   )
+{
+   skipBom( stream );
+
+   // Convert all records before adding any, a bad record must not leave a partial import.
+   Vector<Entry> entries;
+
+   if ( format == TRANSFER_CSV )
+   {
+      Vector<String> fields;
+      if ( ! utils::readCsvRecord( stream, fields ) )
+      {
+         return 0;
+      }
+
+      const Vector<Column> columns( toColumns( fields ) );
+      auto toEntry = [ & ]( const Vector<String>& row ) { return csvToEntry( row, columns ); };
+
+      Vector<Vector<String>> rows;
+      bool more( true );
+      while ( more )
+      {
+         more = utils::readCsvRecord( stream, fields );
+         if ( more && ! ( fields.size() == 1 && fields[ 0 ].empty() ) )
+         {
+            rows.push_back( fields );
+         }
+
+         const std::size_t converted( entries.size() );
+         if ( rows.size() - converted == BATCH_SIZE || ( ! more && rows.size() > converted ) )
+         {
+            convertBatch( rows, converted, toEntry, entries );
+            if ( progress )
+            {
+               progress( entries.size() );
+            }
+         }
+      }
+
+      return addAll( instance, rows, entries, toEntry );
+   }
+   else
+   {
+      Vector<String> lines;
+      String line;
+      bool more( true );
+      while ( more )
+      {
+         more = static_cast<bool>( std::getline( stream, line ) );
+         line = utils::strip( line );
+         if ( more && ! line.empty() )
+         {
+            lines.push_back( line );
+         }
+
+         const std::size_t converted( entries.size() );
+         if ( lines.size() - converted == BATCH_SIZE || ( ! more && lines.size() > converted ) )
+         {
+            convertBatch( lines, converted, jsonToEntry, entries );
+            if ( progress )
+            {
+               progress( entries.size() );
+            }
+         }
+      }
+
+      return addAll( instance, lines, entries, jsonToEntry );
+   }
+}
+
+std::size_t exportEntries(
+   const Instance& instance,
+   std::ostream& stream,
+   const TransferFormat format
+   )
+{
+   const Vector<Entry> entries( toSortedVector( instance.getEntries() ) );
+
+   for ( const auto& entry : entries )
+   {
+      for ( const auto& date : entry.getLabeledData() )
+      {
+         if ( ! date.second.isPlaintextAvailable() )
+         {
+            throw std::runtime_error( "entries not decrypted" );
+         }
+      }
+   }
+
+   if ( format == TRANSFER_CSV )
+   {
+      writeCsv( stream, entries );
+   }
+   else
+   {
+      writeJson( stream, entries );
+   }
+
+   return entries.size();
+}
+
+}
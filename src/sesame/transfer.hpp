@@ -0,0 +1,109 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SESAME_TRANSFER_HPP
+#define SESAME_TRANSFER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+
+#include "types.hpp"
+
+namespace sesame {
+
+class Instance;
+
+/** The file formats supported by import and export. */
+enum TransferFormat
+{
+   /** CSV with header line (RFC 4180) */
+   TRANSFER_CSV,
+   /** JSON Lines, one object per entry */
+   TRANSFER_JSON
+};
+
+/**
+ * Determines the transfer format by file extension
+ * (<tt>csv</tt>, <tt>json</tt> or <tt>jsonl</tt>).
+ *
+ * @param path the path of the file
+ *
+ * @return the transfer format
+ *
+ * @throw std::runtime_error if extension is unknown
+ */
+TransferFormat getTransferFormat( const String& path );
+
+/**
+ * Imports entries, records are converted in batches by all cores.
+ * Entries are added to the instance after all records were converted,
+ * all or none.
+ *
+ * CSV columns are mapped by header: <tt>name</tt> (or <tt>title</tt>,
+ * <tt>account</tt>) is the name, <tt>tags</tt> holds tags separated
+ * by <tt>;</tt>, <tt>group</tt> a single tag, <tt>password</tt> and
+ * <tt>password:LABEL</tt> hold passwords, <tt>key:LABEL</tt> hex
+ * encoded keys, any other column an attribute. Empty fields are
+ * skipped.
+ *
+ * @param instance the instance to add entries to
+ * @param stream the stream to read (UTF-8)
+ * @param format the transfer format
+ * @param progress called with the number of records converted so far
+ *     after every batch
+ *
+ * @return the number of entries imported
+ *
+ * @throw std::runtime_error on failure (no entry is imported)
+ */
+std::size_t importEntries(
+   Instance& instance,
+   std::istream& stream,
+   const TransferFormat format,
+   const std::function<void( std::size_t )>& progress = std::function<void( std::size_t )>()
+   );
+
+/**
+ * Exports all entries (sorted by name) in a format
+ * read by importEntries().
+ *
+ * @param instance the instance to export (decrypted)
+ * @param stream the stream to write to (UTF-8)
+ * @param format the transfer format
+ *
+ * @return the number of entries exported
+ *
+ * @throw std::runtime_error on failure
+ */
+std::size_t exportEntries(
+   const Instance& instance,
+   std::ostream& stream,
+   const TransferFormat format
+   );
+
+}
+
+#endif
@@ -0,0 +1,333 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sesame/utils/filesystem.hpp"
+#include "sesame/utils/BloomFilter.hpp"
+
+
+namespace
+{
+   // Layout: magic(4), hash count(1), reserved(3), bit count(8),
+   // word count(8), reserved(8), bits; numbers big endian.
+   const char MAGIC[] = { 'S', 'B', 'F', '1' };
+   const std::size_t HEADER_SIZE( 32 );
+   const std::size_t MAX_HASH_COUNT( 32 );
+
+   void putBigEndian( uint8_t* out, uint64_t value )
+   {
+      for ( std::size_t i = 8; i > 0; --i )
+      {
+         out[ i - 1 ] = static_cast<uint8_t>( value & 0xff );
+         value >>= 8;
+      }
+   }
+
+   uint64_t getBigEndian( const uint8_t* in )
+   {
+      uint64_t value( 0 );
+      for ( std::size_t i = 0; i < 8; ++i )
+      {
+         value = ( value << 8 ) | in[ i ];
+      }
+      return value;
+   }
+
+   uint64_t mix( uint64_t h )
+   {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+   }
+
+   // FNV-1a, split into the two hashes used for double hashing.
+   void hash( const char* word, const std::size_t length, uint64_t& h1, uint64_t& h2 )
+   {
+      uint64_t h( 0xcbf29ce484222325ULL );
+      for ( std::size_t i = 0; i < length; ++i )
+      {
+         h ^= static_cast<uint8_t>( word[ i ] );
+         h *= 0x100000001b3ULL;
+      }
+      h1 = mix( h );
+      h2 = mix( h ^ 0x9e3779b97f4a7c15ULL ) | 1;
+   }
+
+   bool readWord( std::istream& in, String& word )
+   {
+      while ( std::getline( in, word ) )
+      {
+         if ( ! word.empty() && word[ word.size() - 1 ] == '\r' )
+         {
+            word.erase( word.size() - 1 );
+         }
+         if ( ! word.empty() )
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   class Mapping
+   {
+      public:
+         Mapping( const String& path, const bool writable, const std::size_t size = 0 ) :
+            m_Data( nullptr ),
+            m_Size( size )
+         {
+            const int fd( writable ?
+                  open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 ) :
+                  open( path.c_str(), O_RDONLY ) );
+            if ( fd < 0 )
+            {
+               throw std::runtime_error( ( "failed to open " + path ).c_str() );
+            }
+
+            struct stat st;
+            if ( writable ? ftruncate( fd, size ) != 0 : fstat( fd, &st ) != 0 )
+            {
+               close( fd );
+               throw std::runtime_error( ( "failed to size " + path ).c_str() );
+            }
+            if ( ! writable )
+            {
+               m_Size = st.st_size;
+            }
+
+            void* data( m_Size == 0 ? MAP_FAILED : mmap( nullptr, m_Size,
+                     writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0 ) );
+            close( fd );
+            if ( data == MAP_FAILED )
+            {
+               throw std::runtime_error( ( "failed to map " + path ).c_str() );
+            }
+            m_Data = static_cast<uint8_t*>( data );
+         }
+
+         ~Mapping()
+         {
+            if ( m_Data )
+            {
+               munmap( m_Data, m_Size );
+            }
+         }
+
+         uint8_t* release()
+         {
+            uint8_t* data( m_Data );
+            m_Data = nullptr;
+            return data;
+         }
+
+         uint8_t* m_Data;
+         std::size_t m_Size;
+   };
+}
+
+namespace sesame { namespace utils {
+
+BloomFilter::BloomFilter( const String& path ) :
+   m_Data( nullptr ),
+   m_Size( 0 ),
+   m_HashCount( 0 ),
+   m_BitCount( 0 ),
+   m_WordCount( 0 )
+{
+   Mapping mapping( path, false );
+
+   const uint8_t* header( mapping.m_Data );
+   if ( mapping.m_Size < HEADER_SIZE || std::memcmp( header, MAGIC, sizeof( MAGIC ) ) != 0 )
+   {
+      throw std::runtime_error( ( path + " is no bloom filter" ).c_str() );
+   }
+
+   const std::size_t hashCount( header[ 4 ] );
+   const uint64_t bitCount( getBigEndian( header + 8 ) );
+   if ( hashCount == 0 || hashCount > MAX_HASH_COUNT || bitCount == 0 ||
+        ( mapping.m_Size - HEADER_SIZE ) < ( bitCount + 7 ) / 8 )
+   {
+      throw std::runtime_error( ( path + " is a corrupt bloom filter" ).c_str() );
+   }
+
+   // The filter holds no secrets, do not keep probed pages locked if sesame
+   // runs with mlockall(), and do not read ahead for random probes.
+   munlock( mapping.m_Data, mapping.m_Size );
+   madvise( mapping.m_Data, mapping.m_Size, MADV_RANDOM );
+
+   m_Size = mapping.m_Size;
+   m_HashCount = hashCount;
+   m_BitCount = bitCount;
+   m_WordCount = getBigEndian( header + 16 );
+   m_Data = mapping.release();
+}
+
+BloomFilter::~BloomFilter()
+{
+   munmap( const_cast<uint8_t*>( m_Data ), m_Size );
+}
+
+bool BloomFilter::contains( const String& word ) const
+{
+   uint64_t h1, h2;
+   hash( word.data(), word.size(), h1, h2 );
+
+   const uint8_t* bits( m_Data + HEADER_SIZE );
+   for ( std::size_t i = 0; i < m_HashCount; ++i )
+   {
+      const uint64_t bit( ( h1 + i * h2 ) % m_BitCount );
+      if ( ( bits[ bit >> 3 ] & ( 1 << ( bit & 7 ) ) ) == 0 )
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+std::size_t BloomFilter::getHashCount() const
+{
+   return m_HashCount;
+}
+
+uint64_t BloomFilter::getBitCount() const
+{
+   return m_BitCount;
+}
+
+uint64_t BloomFilter::getWordCount() const
+{
+   return m_WordCount;
+}
+
+uint64_t BloomFilter::build( const String& wordList, const String& path, const double falsePositiveRate )
+{
+   if ( falsePositiveRate <= 0.0 || falsePositiveRate >= 1.0 )
+   {
+      throw std::runtime_error( "invalid false positive rate" );
+   }
+
+   std::ifstream in( wordList.c_str() );
+   if ( ! in )
+   {
+      throw std::runtime_error( ( "failed to open " + wordList ).c_str() );
+   }
+
+   String word;
+   uint64_t wordCount( 0 );
+   while ( readWord( in, word ) )
+   {
+      ++wordCount;
+   }
+
+   // Optimal size and number of hashes for the requested rate.
+   const double ln2( std::log( 2.0 ) );
+   const double words( wordCount > 0 ? wordCount : 1 );
+   const uint64_t bitCount( std::max<uint64_t>( 64,
+            std::ceil( -words * std::log( falsePositiveRate ) / ( ln2 * ln2 ) ) ) );
+   const std::size_t hashCount( std::min<std::size_t>( MAX_HASH_COUNT,
+            std::max<std::size_t>( 1, std::lround( bitCount / words * ln2 ) ) ) );
+
+   Mapping mapping( path, true, HEADER_SIZE + ( bitCount + 7 ) / 8 );
+
+   uint8_t* header( mapping.m_Data );
+   std::memcpy( header, MAGIC, sizeof( MAGIC ) );
+   header[ 4 ] = static_cast<uint8_t>( hashCount );
+   putBigEndian( header + 8, bitCount );
+   putBigEndian( header + 16, wordCount );
+
+   in.clear();
+   in.seekg( 0 );
+
+   uint8_t* bits( mapping.m_Data + HEADER_SIZE );
+   while ( readWord( in, word ) )
+   {
+      uint64_t h1, h2;
+      hash( word.data(), word.size(), h1, h2 );
+      for ( std::size_t i = 0; i < hashCount; ++i )
+      {
+         const uint64_t bit( ( h1 + i * h2 ) % bitCount );
+         bits[ bit >> 3 ] |= static_cast<uint8_t>( 1 << ( bit & 7 ) );
+      }
+   }
+
+   if ( msync( mapping.m_Data, mapping.m_Size, MS_SYNC ) != 0 )
+   {
+      throw std::runtime_error( ( "failed to write " + path ).c_str() );
+   }
+
+   return wordCount;
+}
+
+namespace
+{
+   std::unique_ptr<BloomFilter> loadDefault()
+   {
+      String path;
+      const char* env( std::getenv( "SESAME_BLOOM_FILTER" ) );
+      if ( env && *env )
+      {
+         path = env;
+      }
+#ifdef SESAME_BLOOM_FILTER_PATH
+      else
+      {
+         path = SESAME_BLOOM_FILTER_PATH;
+      }
+#endif
+
+      std::unique_ptr<BloomFilter> filter;
+      if ( ! path.empty() && exists( path ) )
+      {
+         filter.reset( new BloomFilter( path ) );
+      }
+      return filter;
+   }
+}
+
+const BloomFilter* BloomFilter::getDefault()
+{
+   // Initialized once, even if called concurrently.
+   static const std::unique_ptr<BloomFilter> filter( loadDefault() );
+
+   return filter.get();
+}
+
+} }
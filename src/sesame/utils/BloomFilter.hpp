@@ -0,0 +1,76 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifndef SESAME_UTILS_BLOOM_FILTER_HPP
+#define SESAME_UTILS_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "types.hpp"
+
+
+namespace sesame { namespace utils {
+
+// Read only, memory-mapped Bloom filter of breached passwords.
+// A lookup hashes the word once and probes k bits (double hashing),
+// so checking is O(k) and loading only maps the file.
+class BloomFilter
+{
+   public:
+      // Maps filter file at path, throws std::runtime_error
+      // if file is no valid filter.
+      explicit BloomFilter( const String& path );
+
+      virtual ~BloomFilter();
+
+      bool contains( const String& word ) const;
+
+      std::size_t getHashCount() const;
+      uint64_t getBitCount() const;
+      uint64_t getWordCount() const;
+
+      // Builds filter file at path from word list (one word per line),
+      // sized for the passed false positive rate. Returns number of words.
+      static uint64_t build( const String& wordList, const String& path, const double falsePositiveRate = 0.0001 );
+
+      // Returns filter at $SESAME_BLOOM_FILTER (or installed one),
+      // nullptr if there is none. The filter is mapped on first use.
+      static const BloomFilter* getDefault();
+
+   private:
+      BloomFilter( const BloomFilter& ) = delete;
+      BloomFilter& operator=( const BloomFilter& ) = delete;
+
+      const uint8_t* m_Data;
+      std::size_t m_Size;
+      std::size_t m_HashCount;
+      uint64_t m_BitCount;
+      uint64_t m_WordCount;
+};
+
+} }
+
+#endif
@@ -42,6 +42,7 @@ ParseResult::ParseResult() :
    m_CompleteTag( false ),
    m_CompleteAttribute( false ),
    m_CompletePasswordOrKey( false ),
+   m_CompleteContainer( false ),
    m_EntryId( "" )
 {
 }
@@ -103,6 +104,7 @@ void ParseResult::clear()
    m_CompleteTag = false;
    m_CompleteAttribute = false;
    m_CompletePasswordOrKey = false;
+   m_CompleteContainer = false;
    m_EntryId = "";
 }
 
@@ -207,6 +209,16 @@ bool ParseResult::completePasswordOrKey()
    return m_CompletePasswordOrKey;
 }
 
+void ParseResult::setCompleteContainer()
+{
+   m_CompleteContainer = true;
+}
+
+bool ParseResult::completeContainer()
+{
+   return m_CompleteContainer;
+}
+
 void ParseResult::setEntryId( const String& entryId )
 {
    m_EntryId = entryId;
@@ -104,6 +104,11 @@ class ParseResult
       /** User requests completion of password or key? */
       bool completePasswordOrKey();
 
+      void setCompleteContainer();
+
+      /** User requests completion of container id? */
+      bool completeContainer();
+
       /**
        * Sets the entry id.
        *
@@ -132,6 +137,7 @@ class ParseResult
       bool m_CompleteTag;
       bool m_CompleteAttribute;
       bool m_CompletePasswordOrKey;
+      bool m_CompleteContainer;
       String m_EntryId;
 };
 
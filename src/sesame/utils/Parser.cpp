@@ -23,7 +23,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
-#include <iostream>
+#include <cstdlib>
+#include <stdexcept>
 #include "types.hpp"
 #include "sesame/utils/grammar.h"
 #include "sesame/utils/Parser.hpp"
@@ -31,54 +32,109 @@
 extern void* ParseAlloc( void* ( *allocProc )( size_t ) );
 extern void Parse( void*, int, char*, struct sesame::utils::ParseResult* );
 extern void* ParseFree( void*, void( *freeProc )( void* ) );
+extern int ParseCopy( void*, const void* );
+
+extern "C"
+{
+int yyget_condition( yyscan_t yyscanner );
+void yyresume( int condition, int atBol, yyscan_t yyscanner );
+}
 
 
 namespace sesame { namespace utils {
 
+const std::size_t Parser::MAX_TOKENS( 32 );
+
 Parser::Parser() :
    m_Lexer(),
-   m_Parser( ParseAlloc( &std::malloc ) )
+   m_Parser( ParseAlloc( &std::malloc ) ),
+   m_Line(),
+   m_Tokens(),
+   m_States(),
+   m_Buffer()
 {
    yylex_init( &m_Lexer );
+
+   // Tokens must not be moved, the parser states point to them.
+   m_Tokens.reserve( MAX_TOKENS );
+
+   // Initial state (start condition INITIAL).
+   State initial;
+   initial.m_End = 0;
+   initial.m_Condition = 0;
+   initial.m_Parser = ParseAlloc( &std::malloc );
+   m_States.push_back( initial );
 }
 
 Parser::~Parser()
 {
    yylex_destroy( m_Lexer );
    ParseFree( m_Parser, &std::free );
+   for ( auto& state : m_States )
+   {
+      ParseFree( state.m_Parser, &std::free );
+   }
 }
 
-const ParseResult Parser::parse( const String& line ) const
+const ParseResult Parser::parse( const String& line )
 {
-   // Init lexer.
-   YY_BUFFER_STATE buffer( yy_scan_string( line.c_str(), m_Lexer ) );
-   yy_switch_to_buffer( buffer, m_Lexer );
+   // Find last state of previous line to resume from. A token can only be
+   // reused if the character terminating it is the same in both lines.
+   std::size_t common( 0 );
+   while ( common < line.size() && common < m_Line.size() && line[ common ] == m_Line[ common ] )
+   {
+      ++common;
+   }
+   std::size_t resume( 0 );
+   while ( ( resume + 1 ) < m_States.size() && m_States[ resume + 1 ].m_End < common )
+   {
+      ++resume;
+   }
 
-   // Reset parser.
-   ParseResult dummyParseResult;
-   Parse( m_Parser, 0, nullptr, &dummyParseResult );
+   // Drop states and tokens behind.
+   for ( std::size_t i = resume + 1; i < m_States.size(); ++i )
+   {
+      ParseFree( m_States[ i ].m_Parser, &std::free );
+   }
+   m_States.resize( resume + 1 );
+   m_Tokens.resize( resume );
+   m_Line = line;
 
-   // Start parsing.
-   int token;
-   Vector<String> tokens;
-   tokens.reserve( 32 );
-   ParseResult parseResult;
+   // Restore parser.
+   if ( ParseCopy( m_Parser, m_States.back().m_Parser ) != 0 )
+   {
+      throw std::runtime_error( "failed to restore parser" );
+   }
+   ParseResult parseResult( m_States.back().m_ParseResult );
+   const std::size_t offset( m_States.back().m_End );
+
+   // Init lexer with rest of line (flex expects two trailing NULs).
+   m_Buffer.assign( line.begin() + offset, line.end() );
+   m_Buffer.push_back( '\0' );
+   m_Buffer.push_back( '\0' );
+   YY_BUFFER_STATE buffer( yy_scan_buffer( m_Buffer.data(), m_Buffer.size(), m_Lexer ) );
+   yyresume( m_States.back().m_Condition, resume == 0, m_Lexer );
 
-   do
+   // Continue parsing.
+   int token;
+   while ( m_Tokens.size() < MAX_TOKENS && ( token = yylex( m_Lexer ) ) > 0 )
    {
-      token = yylex( m_Lexer );
+      const char* text( yyget_text( m_Lexer ) );
+      m_Tokens.push_back( text );
+      Parse( m_Parser, token, const_cast<char*>( m_Tokens.back().c_str() ), &parseResult );
 
-      if ( token > 0 )
-      {
-         tokens.push_back( yyget_text( m_Lexer ) );
-         Parse( m_Parser, token, const_cast<char*>( tokens.back().c_str() ), &parseResult );
-      }
-      else
+      // Save state, unless token ends the line.
+      State state;
+      state.m_End = offset + ( text - m_Buffer.data() ) + yyget_leng( m_Lexer );
+      if ( state.m_End < line.size() )
       {
-         break;
+         state.m_Condition = yyget_condition( m_Lexer );
+         state.m_Parser = ParseAlloc( &std::malloc );
+         ParseCopy( state.m_Parser, m_Parser );
+         state.m_ParseResult = parseResult;
+         m_States.push_back( state );
       }
    }
-   while ( tokens.capacity() > tokens.size() );
 
    // Finish parsing.
    yy_delete_buffer( buffer, m_Lexer );
@@ -40,6 +40,11 @@ namespace sesame { namespace utils {
 /**
  * Instances of this class are used to
  * parse commands by the user.
+ *
+ * The parser works incrementally: the lexer and parser state after each
+ * token of the previous line is kept, so a line sharing a prefix with the
+ * previous one (as on every key press during auto completion) is only
+ * parsed from the first token that differs.
  */
 class Parser
 {
@@ -55,15 +60,39 @@ class Parser
        *
        * @return the parse result
        */
-      const ParseResult parse( const String& line ) const;
+      const ParseResult parse( const String& line );
 
    private:
       Parser( const Parser& other );
       Parser& operator=( const Parser& other );
 
+      /** State of lexer and parser after a token. */
+      struct State
+      {
+         /** offset behind the token */
+         std::size_t m_End;
+         /** start condition of the lexer */
+         int m_Condition;
+         /** copy of the parser */
+         void* m_Parser;
+         /** parse result so far */
+         ParseResult m_ParseResult;
+      };
+
+      /** max number of tokens per line */
+      static const std::size_t MAX_TOKENS;
+
       yyscan_t m_Lexer;
       void* m_Parser;
 
+      /** previous line */
+      String m_Line;
+      /** tokens of previous line (referenced by parser states) */
+      Vector<String> m_Tokens;
+      /** states after each token of previous line (first is initial state) */
+      Vector<State> m_States;
+      /** scan buffer */
+      Vector<char> m_Buffer;
 };
 
 
@@ -24,6 +24,7 @@
 
 
 #include <iostream>
+#include <stdexcept>
 #include <unistd.h>
 #include <termios.h>
 
@@ -31,6 +32,14 @@
 #include "sesame/utils/Reader.hpp"
 
 
+namespace
+{
+   std::istream* batchInput( nullptr );
+   String batchPassword;
+   bool batchPasswordSet( false );
+   std::size_t batchLineNumber( 0 );
+}
+
 namespace sesame { namespace utils {
 
 Reader::Reader( std::size_t lineSize ) :
@@ -40,6 +49,23 @@ Reader::Reader( std::size_t lineSize ) :
 
 String Reader::readLine( const String& prompt, bool echoOff )
 {
+   if ( batchInput )
+   {
+      if ( echoOff && batchPasswordSet )
+      {
+         return batchPassword;
+      }
+
+      String line;
+      if ( ! std::getline( *batchInput, line ) )
+      {
+         throw std::runtime_error( "unexpected end of input" );
+      }
+      ++batchLineNumber;
+
+      return line;
+   }
+
    if ( ! prompt.empty() )
    {
       std::cout << prompt;
@@ -60,6 +86,50 @@ String Reader::readLine( const String& prompt, bool echoOff )
    return String( m_Buffer.data(), m_Buffer.data() + std::cin.gcount() - 1 );
 }
 
+void Reader::setBatchMode( std::istream& input, const int passwordFd )
+{
+   batchInput = &input;
+   batchLineNumber = 0;
+
+   if ( passwordFd >= 0 )
+   {
+      // Read first line only, byte by byte (fd may be a pipe).
+      batchPassword.clear();
+      char c;
+      ssize_t count;
+      while ( ( count = ::read( passwordFd, &c, 1 ) ) == 1 && c != '\n' )
+      {
+         batchPassword += c;
+      }
+      c = '\0';
+
+      batchPassword = strip( batchPassword );
+      if ( count == -1 || batchPassword.empty() )
+      {
+         throw std::runtime_error( "failed to read password" );
+      }
+      batchPasswordSet = true;
+   }
+}
+
+bool Reader::isBatchMode()
+{
+   return ( batchInput != nullptr );
+}
+
+std::size_t Reader::getLineNumber()
+{
+   return batchLineNumber;
+}
+
+void Reader::resetBatchMode()
+{
+   batchInput = nullptr;
+   String().swap( batchPassword );
+   batchPasswordSet = false;
+   batchLineNumber = 0;
+}
+
 Reader::EchoOffGuard::EchoOffGuard()
 {
    termios t;
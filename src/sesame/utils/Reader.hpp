@@ -26,6 +26,7 @@
 #ifndef SESAME_UTILS_READER_HPP
 #define SESAME_UTILS_READER_HPP
 
+#include <iostream>
 #include "types.hpp"
 
 
@@ -40,6 +41,19 @@ class Reader
 
       String readLine( const String& prompt = "", bool echoOff = false );
 
+      // Batch mode: lines are read from input (without prompts),
+      // hidden lines are answered by the password read from passwordFd
+      // (if passed).
+      static void setBatchMode( std::istream& input, const int passwordFd = -1 );
+
+      static bool isBatchMode();
+
+      // Number of lines read from input in batch mode so far.
+      static std::size_t getLineNumber();
+
+      // Leaves batch mode, wipes the password.
+      static void resetBatchMode();
+
    private:
       class EchoOffGuard
       {
@@ -0,0 +1,217 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iomanip>
+#include <stdexcept>
+
+#include "sesame/utils/RecordWriter.hpp"
+#include "sesame/utils/string.hpp"
+#include "msgpack/adaptor/String.hpp"
+
+namespace
+{
+   sesame::OutputFormat defaultFormat( sesame::OUTPUT_TEXT );
+}
+
+namespace sesame { namespace utils {
+
+void RecordWriter::setFormat( const OutputFormat format )
+{
+   defaultFormat = format;
+}
+
+OutputFormat RecordWriter::getFormat()
+{
+   return defaultFormat;
+}
+
+RecordWriter::RecordWriter( std::ostream& stream, const OutputFormat format ) :
+   m_Stream( stream ),
+   m_Format( format ),
+   m_Packer( stream )
+{
+   if ( m_Format != OUTPUT_JSON && m_Format != OUTPUT_MSGPACK )
+   {
+      throw std::runtime_error( "output format not supported" );
+   }
+}
+
+RecordWriter& RecordWriter::beginMap( const std::size_t size )
+{
+   separate();
+   if ( m_Format == OUTPUT_JSON )
+   {
+      m_Stream << '{';
+   }
+   else
+   {
+      m_Packer.pack_map( size );
+   }
+   m_Levels.push_back( { true, 0 } );
+
+   return *this;
+}
+
+RecordWriter& RecordWriter::beginArray( const std::size_t size )
+{
+   separate();
+   if ( m_Format == OUTPUT_JSON )
+   {
+      m_Stream << '[';
+   }
+   else
+   {
+      m_Packer.pack_array( size );
+   }
+   m_Levels.push_back( { false, 0 } );
+
+   return *this;
+}
+
+RecordWriter& RecordWriter::end()
+{
+   if ( m_Levels.empty() )
+   {
+      throw std::runtime_error( "nothing to end" );
+   }
+
+   if ( m_Format == OUTPUT_JSON )
+   {
+      m_Stream << ( m_Levels.back().m_Map ? '}' : ']' );
+   }
+   m_Levels.pop_back();
+
+   // Record complete.
+   if ( m_Levels.empty() )
+   {
+      if ( m_Format == OUTPUT_JSON )
+      {
+         m_Stream << '\n';
+      }
+      m_Stream.flush();
+   }
+
+   return *this;
+}
+
+RecordWriter& RecordWriter::value( const String& s )
+{
+   separate();
+   if ( m_Format == OUTPUT_JSON )
+   {
+      const String utf8( toUtf8( s ) );
+
+      m_Stream << '"';
+      for ( const char c : utf8 )
+      {
+         switch ( c )
+         {
+            case '"':
+               m_Stream << "\\\"";
+               break;
+            case '\\':
+               m_Stream << "\\\\";
+               break;
+            case '\n':
+               m_Stream << "\\n";
+               break;
+            case '\r':
+               m_Stream << "\\r";
+               break;
+            case '\t':
+               m_Stream << "\\t";
+               break;
+            default:
+               if ( static_cast<unsigned char>( c ) < 0x20 || c == 0x7f )
+               {
+                  // Format locally, m_Stream (e.g. std::cout) keeps its fill and flags.
+                  StringStream escape;
+                  escape << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' )
+                         << static_cast<uint32_t>( c );
+                  m_Stream << escape.str();
+               }
+               else
+               {
+                  m_Stream << c;
+               }
+         }
+      }
+      m_Stream << '"';
+   }
+   else
+   {
+      m_Packer.pack( s );
+   }
+
+   return *this;
+}
+
+RecordWriter& RecordWriter::value( const uint64_t n )
+{
+   separate();
+   if ( m_Format == OUTPUT_JSON )
+   {
+      m_Stream << std::dec << n;
+   }
+   else
+   {
+      m_Packer.pack_uint64( n );
+   }
+
+   return *this;
+}
+
+RecordWriter& RecordWriter::nil()
+{
+   separate();
+   if ( m_Format == OUTPUT_JSON )
+   {
+      m_Stream << "null";
+   }
+   else
+   {
+      m_Packer.pack_nil();
+   }
+
+   return *this;
+}
+
+void RecordWriter::separate()
+{
+   if ( m_Levels.empty() )
+   {
+      return;
+   }
+
+   Level& level( m_Levels.back() );
+   if ( m_Format == OUTPUT_JSON && level.m_Count > 0 )
+   {
+      // Map: key, value, key, ...
+      m_Stream << ( ( level.m_Map && ( level.m_Count % 2 ) == 1 ) ? ':' : ',' );
+   }
+   ++level.m_Count;
+}
+
+} }
@@ -0,0 +1,154 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SESAME_UTILS_RECORD_WRITER_HPP
+#define SESAME_UTILS_RECORD_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+#include "types.hpp"
+#include "msgpack.hpp"
+#include "sesame/definitions.hpp"
+
+
+namespace sesame { namespace utils {
+
+/**
+ * Streams records (nested maps and arrays of strings and numbers)
+ * as JSON Lines or msgpack, without buffering: every record is
+ * flushed as soon as it is complete.
+ *
+ * Keys and values of maps are written alternately by value().
+ */
+class RecordWriter
+{
+   public:
+      /**
+       * Sets the output format used by default.
+       *
+       * @param format the output format
+       */
+      static void setFormat( const OutputFormat format );
+
+      /**
+       * Returns the output format used by default.
+       *
+       * @return the output format
+       */
+      static OutputFormat getFormat();
+
+      /**
+       * Ctor.
+       *
+       * @param stream the stream to write to
+       * @param format the output format (json or msgpack)
+       *
+       * @throw std::runtime_error if format is not supported
+       */
+      explicit RecordWriter( std::ostream& stream, const OutputFormat format = getFormat() );
+
+      /**
+       * Dtor.
+       */
+      virtual ~RecordWriter() = default;
+
+      /**
+       * Begins a map, closed by end().
+       *
+       * @param size the number of key value pairs
+       *
+       * @return this writer
+       */
+      RecordWriter& beginMap( const std::size_t size );
+
+      /**
+       * Begins an array, closed by end().
+       *
+       * @param size the number of values
+       *
+       * @return this writer
+       */
+      RecordWriter& beginArray( const std::size_t size );
+
+      /**
+       * Ends the map or array begun last.
+       *
+       * @return this writer
+       */
+      RecordWriter& end();
+
+      /**
+       * Writes a string (converted to UTF-8).
+       *
+       * @param s the string
+       *
+       * @return this writer
+       */
+      RecordWriter& value( const String& s );
+
+      /**
+       * Writes a number.
+       *
+       * @param n the number
+       *
+       * @return this writer
+       */
+      RecordWriter& value( const uint64_t n );
+
+      /**
+       * Writes null (nil).
+       *
+       * @return this writer
+       */
+      RecordWriter& nil();
+
+   private:
+      /**
+       * Writes the separator (JSON) required before the next element.
+       */
+      void separate();
+
+      /** an open map or array */
+      struct Level
+      {
+         bool m_Map;
+         std::size_t m_Count;
+      };
+
+      /** the stream to write to */
+      std::ostream& m_Stream;
+      /** the output format */
+      const OutputFormat m_Format;
+      /** the open maps and arrays */
+      Vector<Level> m_Levels;
+      /** packer (msgpack) */
+      msgpack::packer<std::ostream> m_Packer;
+};
+
+} }
+
+#endif
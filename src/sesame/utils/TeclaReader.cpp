@@ -26,6 +26,7 @@
 #include <iostream>
 #include <stdexcept>
 #include "sesame/utils/string.hpp"
+#include "sesame/utils/Reader.hpp"
 #include "sesame/utils/TeclaReader.hpp"
 
 extern "C"
@@ -67,6 +68,13 @@ bool TeclaReader::setEditMode( const String& mode )
 
 String TeclaReader::readLine( const String& prompt, bool hideText )
 {
+   // No terminal in batch mode.
+   if ( Reader::isBatchMode() )
+   {
+      Reader reader( 1024 );
+      return ( strip( reader.readLine( prompt, hideText ) ) + "\n" );
+   }
+
    // Set.
    gl_echo_mode( m_Gl, hideText ? 0 : 1 );
    // Set again. Should return echo_off=>0 and echo_on=>1.
@@ -37,6 +37,10 @@ class Transcoder
    public:
       Transcoder( const String& from, const String& to );
 
+      Transcoder( const Transcoder& ) = delete;
+
+      Transcoder& operator=( const Transcoder& ) = delete;
+
       virtual ~Transcoder();
 
       String transcode( const char* string, const std::size_t length );
@@ -25,11 +25,13 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include "types.hpp"
 #include "sesame/Data.hpp"
 #include "sesame/Entry.hpp"
 #include "sesame/Instance.hpp"
+#include "sesame/Session.hpp"
 #include "sesame/utils/completion.hpp"
 #include "sesame/utils/string.hpp"
 #include "sesame/utils/Parser.hpp"
@@ -38,6 +40,7 @@
 using sesame::Data;
 using sesame::Entry;
 using sesame::Instance;
+using sesame::Session;
 using sesame::utils::lstrip;
 using sesame::utils::split;
 using sesame::utils::Parser;
@@ -50,9 +53,8 @@ namespace
    char* emptyCString( 0 );
 
    const Vector<String> editModes = { "emacs", "vi" };
-   const Vector<String> baseCommands = { "help", "clear", "quit", "edit-mode " };
-   const Vector<String> noInstanceCommands = { "new", "open " };
-   const Vector<String> instanceCommands = { "apg", "close", "write ", "recrypt", "list", "tree", "tags", "show ", "decrypt ",
+   const Vector<String> baseCommands = { "help", "clear", "quit", "edit-mode ", "output ", "capacity ", "new", "open " };
+   const Vector<String> instanceCommands = { "apg", "close", "switch ", "containers", "write ", "journal ", "compact ", "convert ", "compress ", "import ", "export ", "recrypt", "list", "tree", "tags", "rotate ", "show ", "decrypt ",
                                              "add ", "delete ", "update ", "select ", "search " };
    const Vector<String> updateCommands = { "add_attribute", "update_attribute ", "delete_attribute ",
                                            "add_password", "add_key", "update_password_or_key ", "delete_password_or_key ",
@@ -66,33 +68,126 @@ namespace
       return v;
    }
 
+   /**
+    * Completion choices depending on the instance only. They are rebuilt
+    * only if the revision of the instance changes (or another instance is
+    * opened), to keep completion fast for large containers.
+    */
+   struct Choices
+   {
+      /** revision of instance (0 if no instance) */
+      uint64_t m_Revision;
+      /** available commands */
+      Vector<String> m_Commands;
+      /** entry ids (sorted) */
+      Vector<String> m_Entries;
+      /** tag ids */
+      Vector<String> m_Tags;
+      /** tags (sorted) */
+      Vector<String> m_AllTags;
+   };
+   Choices choices = { std::numeric_limits<uint64_t>::max(), Vector<String>(), Vector<String>(), Vector<String>(), Vector<String>() };
+
+   const Choices& getChoices( const Instance* instance )
+   {
+      const uint64_t revision( instance ? instance->getRevision() : 0 );
+      if ( revision == choices.m_Revision )
+      {
+         return choices;
+      }
+
+      choices.m_Revision = revision;
+      choices.m_Commands = baseCommands;
+      choices.m_Entries.clear();
+      choices.m_Tags.clear();
+      choices.m_AllTags.clear();
+
+      if ( ! instance )
+      {
+         return choices;
+      }
+
+      choices.m_Commands.insert( choices.m_Commands.end(), instanceCommands.begin(), instanceCommands.end() );
+
+      Set<Entry> entries( instance->getIndex() );
+      choices.m_Entries.reserve( entries.size() );
+      for ( auto& entry : entries )
+      {
+         choices.m_Entries.push_back( String( "#" ) + entry.getIdAsHexString() + " " );
+      }
+      std::sort( choices.m_Entries.begin(), choices.m_Entries.end() );
+
+      choices.m_AllTags = setToSortedVector( instance->getTags() );
+      std::size_t limit( choices.m_AllTags.size() );
+      if ( limit > 0 && instance->getNumOfUntaggedEntries() > 0 )
+      {
+         choices.m_Tags.push_back( "#0" );
+      }
+      for ( std::size_t i = 1; i <= limit; ++i )
+      {
+         StringStream s;
+         s << "#" << i;
+         choices.m_Tags.push_back( s.str() );
+      }
+
+      return choices;
+   }
+
+   int cpl_add_choice(
+      WordCompletion* cpl,
+      const char* line,
+      int word_end,
+      const String& choice,
+      const String& part
+      )
+   {
+      return cpl_add_completion(
+            cpl,
+            line,
+            ( word_end - part.size() ),
+            word_end,
+            ( choice.substr( part.size() ) ).c_str(),
+            emptyCString,
+            emptyCString
+            );
+   }
+
    int cpl_add_completions(
       WordCompletion* cpl,
       const char* line,
       int word_end,
-      Vector<String> choices,
-      String part
+      const Vector<String>& choices,
+      const String& part
       )
    {
       int success( 0 );
-      String::size_type hit;
       for ( auto& choice : choices )
       {
-         hit = String::npos;
-         hit = choice.find( part );
-         if ( hit != 0 )
+         if ( choice.compare( 0, part.size(), part ) != 0 )
          {
             continue;
          }
-         success += cpl_add_completion(
-               cpl,
-               line,
-               ( word_end - part.size() ),
-               word_end,
-               ( choice.substr( part.size() ) ).c_str(),
-               emptyCString,
-               emptyCString
-               );
+         success += cpl_add_choice( cpl, line, word_end, choice, part );
+      }
+
+      return ( success == 0 );
+   }
+
+   int cpl_add_sorted_completions(
+      WordCompletion* cpl,
+      const char* line,
+      int word_end,
+      const Vector<String>& choices,
+      const String& part
+      )
+   {
+      // Choices starting with part are adjacent.
+      int success( 0 );
+      for ( auto it = std::lower_bound( choices.begin(), choices.end(), part );
+            it != choices.end() && it->compare( 0, part.size(), part ) == 0;
+            ++it )
+      {
+         success += cpl_add_choice( cpl, line, word_end, *it, part );
       }
 
       return ( success == 0 );
@@ -115,8 +210,6 @@ CPL_MATCH_FN(cpl_complete_sesame)
 
    // Look for completion.
    parseResult = parser.parse( left );
-   // Reset lexer for next completion.
-   parser.parse( "\n" );
 
    // Invalid input, abort.
    if ( ! left.empty() && ! parseResult.isValid() )
@@ -127,17 +220,7 @@ CPL_MATCH_FN(cpl_complete_sesame)
    // Evaluate parse result.
    if ( left.empty() || parseResult.completeCommand() )
    {
-      Vector<String> commands( baseCommands );
-      if ( instance )
-      {
-         commands.insert( commands.end(), instanceCommands.begin(), instanceCommands.end() );
-      }
-      else
-      {
-         commands.insert( commands.end(), noInstanceCommands.begin(), noInstanceCommands.end() );
-      }
-
-      cpl_add_completions( cpl, line, word_end, commands, left );
+      cpl_add_completions( cpl, line, word_end, getChoices( instance ).m_Commands, left );
    }
    else if ( parseResult.completeEditMode() )
    {
@@ -149,14 +232,7 @@ CPL_MATCH_FN(cpl_complete_sesame)
    }
    else if ( parseResult.completeEntry() && instance )
    {
-      Set<Entry> entries( instance->findEntries( right ) );
-      Vector<String> choices;
-      for ( auto& entry : entries )
-      {
-         choices.push_back( String( "#" ) + entry.getIdAsHexString() + " " );
-      }
-
-      cpl_add_completions( cpl, line, word_end, choices, right );
+      cpl_add_sorted_completions( cpl, line, word_end, getChoices( instance ).m_Entries, right );
    }
    else if ( parseResult.completeUpdateCommand() && instance )
    {
@@ -170,19 +246,7 @@ CPL_MATCH_FN(cpl_complete_sesame)
    {
       if ( parseResult.getEntryId().empty() )
       {
-         Vector<String> choices;
-         std::size_t limit( instance->getTags().size() );
-         if ( limit > 0 && instance->getNumOfUntaggedEntries() > 0 )
-         {
-            choices.push_back( "#0" );
-         }
-         for ( std::size_t i = 1; i <= limit; ++i )
-         {
-            StringStream s;
-            s << "#" << i;
-            choices.push_back( s.str() );
-         }
-         cpl_add_completions( cpl, line, word_end, choices, right );
+         cpl_add_completions( cpl, line, word_end, getChoices( instance ).m_Tags, right );
       }
       else
       {
@@ -190,7 +254,7 @@ CPL_MATCH_FN(cpl_complete_sesame)
          {
             Entry entry( instance->findEntry( parseResult.getEntryId() ) );
             Set<String> tags( entry.getTags() );
-            Vector<String> allTags( setToSortedVector( instance->getTags() ) );
+            const Vector<String>& allTags( getChoices( instance ).m_AllTags );
 
             Vector<String> choices;
             for ( std::size_t i = 1; i <= allTags.size(); ++i )
@@ -249,6 +313,15 @@ CPL_MATCH_FN(cpl_complete_sesame)
          // entry not found
       }
    }
+   else if ( parseResult.completeContainer() && instance )
+   {
+      Vector<String> choices;
+      for ( auto& other : Session::getInstances() )
+      {
+         choices.push_back( String( "#" ) + other->getIdAsHexString() + " " );
+      }
+      cpl_add_completions( cpl, line, word_end, choices, right );
+   }
    else if ( parseResult.completeFile() )
    {
       cpl_file_completions( cpl, nullptr, right.c_str(), right.size() );
@@ -0,0 +1,145 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+
+#include "Allocator.hpp"
+#include "sesame/utils/compression.hpp"
+
+namespace
+{
+   // Raw deflate, no zlib header and checksum (data is authenticated anyway).
+   const int MIN_WINDOW_BITS( 9 );
+   const int MAX_WINDOW_BITS( 15 );
+   const std::size_t CHUNK_SIZE( 4096 );
+
+   /**
+    * Returns the smallest window covering the passed size, a small
+    * window keeps initialization cheap for small entries.
+    */
+   int getWindowBits( const std::size_t size )
+   {
+      int bits( MIN_WINDOW_BITS );
+      while ( bits < MAX_WINDOW_BITS && ( static_cast<std::size_t>( 1 ) << bits ) < size )
+      {
+         ++bits;
+      }
+
+      return bits;
+   }
+
+   void* allocate( void*, uInt items, uInt size )
+   {
+      // Remember size in front of the block, required to wipe it.
+      const std::size_t bytes( static_cast<std::size_t>( items ) * size );
+      Allocator<uint8_t> allocator;
+      uint8_t* p( allocator.allocate( sizeof( std::size_t ) + bytes ) );
+      *reinterpret_cast<std::size_t*>( p ) = bytes;
+
+      return p + sizeof( std::size_t );
+   }
+
+   void release( void*, void* address )
+   {
+      uint8_t* p( static_cast<uint8_t*>( address ) - sizeof( std::size_t ) );
+      const std::size_t bytes( *reinterpret_cast<std::size_t*>( p ) );
+      Allocator<uint8_t> allocator;
+      allocator.deallocate( p, sizeof( std::size_t ) + bytes );
+   }
+
+   void prepare( z_stream& stream )
+   {
+      stream.zalloc = allocate;
+      stream.zfree = release;
+      stream.opaque = Z_NULL;
+   }
+}
+
+namespace sesame { namespace utils {
+
+void compress( const Vector<uint8_t>& data, Vector<uint8_t>& compressed )
+{
+   z_stream stream = z_stream();
+   prepare( stream );
+   const int windowBits( getWindowBits( data.size() ) );
+   if ( deflateInit2( &stream, Z_BEST_COMPRESSION, Z_DEFLATED, -windowBits, windowBits - 7, Z_DEFAULT_STRATEGY ) != Z_OK )
+   {
+      throw std::runtime_error( "compression failed" );
+   }
+
+   Vector<uint8_t> out( deflateBound( &stream, data.size() ) );
+   stream.next_in = const_cast<Bytef*>( data.data() );
+   stream.avail_in = data.size();
+   stream.next_out = out.data();
+   stream.avail_out = out.size();
+
+   const int result( deflate( &stream, Z_FINISH ) );
+   out.resize( stream.total_out );
+   deflateEnd( &stream );
+   if ( result != Z_STREAM_END )
+   {
+      throw std::runtime_error( "compression failed" );
+   }
+
+   compressed.swap( out );
+}
+
+void decompress( const uint8_t* data, const std::size_t size, Vector<uint8_t>& decompressed )
+{
+   z_stream stream = z_stream();
+   prepare( stream );
+   if ( inflateInit2( &stream, -MAX_WINDOW_BITS ) != Z_OK )
+   {
+      throw std::runtime_error( "decompression failed" );
+   }
+
+   Vector<uint8_t> out;
+   stream.next_in = const_cast<Bytef*>( data );
+   stream.avail_in = size;
+
+   int result( Z_OK );
+   while ( result == Z_OK )
+   {
+      // Grow output, Allocator wipes the buffer released.
+      out.resize( out.size() + std::max( CHUNK_SIZE, 2 * size ) );
+      stream.next_out = out.data() + stream.total_out;
+      stream.avail_out = out.size() - stream.total_out;
+
+      result = inflate( &stream, Z_NO_FLUSH );
+   }
+   out.resize( stream.total_out );
+   inflateEnd( &stream );
+   if ( result != Z_STREAM_END || stream.avail_in != 0 )
+   {
+      throw std::runtime_error( "decompression failed" );
+   }
+
+   decompressed.swap( out );
+}
+
+} }
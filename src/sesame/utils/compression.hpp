@@ -0,0 +1,60 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifndef SESAME_UTILS_COMPRESSION_HPP
+#define SESAME_UTILS_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "types.hpp"
+
+namespace sesame { namespace utils {
+
+/**
+ * Compresses data (raw deflate stream). Memory used by zlib
+ * is wiped on release.
+ *
+ * @param data the data to compress
+ * @param[out] compressed the compressed data
+ *
+ * @throw std::runtime_error on failure
+ */
+void compress( const Vector<uint8_t>& data, Vector<uint8_t>& compressed );
+
+/**
+ * Decompresses data compressed by compress().
+ *
+ * @param data the compressed data
+ * @param size the size of the compressed data
+ * @param[out] decompressed the decompressed data
+ *
+ * @throw std::runtime_error on failure
+ */
+void decompress( const uint8_t* data, const std::size_t size, Vector<uint8_t>& decompressed );
+
+} }
+
+#endif
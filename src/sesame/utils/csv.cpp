@@ -0,0 +1,129 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdexcept>
+
+#include "sesame/utils/csv.hpp"
+
+namespace sesame { namespace utils {
+
+// Fields as specified by RFC 4180, line breaks may be LF or CRLF.
+bool readCsvRecord( std::istream& stream, Vector<String>& fields )
+{
+   fields.clear();
+
+   if ( stream.peek() == std::char_traits<char>::eof() )
+   {
+      return false;
+   }
+
+   String field;
+   bool quoted( false );
+   bool wasQuoted( false );
+   int c;
+   while ( ( c = stream.get() ) != std::char_traits<char>::eof() )
+   {
+      if ( quoted )
+      {
+         if ( c != '"' )
+         {
+            field.push_back( static_cast<char>( c ) );
+         }
+         else if ( stream.peek() == '"' )
+         {
+            field.push_back( static_cast<char>( stream.get() ) );
+         }
+         else
+         {
+            quoted = false;
+         }
+      }
+      else if ( c == '"' && field.empty() && ! wasQuoted )
+      {
+         quoted = true;
+         wasQuoted = true;
+      }
+      else if ( c == ',' )
+      {
+         fields.push_back( field );
+         field.clear();
+         wasQuoted = false;
+      }
+      else if ( c == '\n' )
+      {
+         break;
+      }
+      else if ( c == '\r' && stream.peek() == '\n' )
+      {
+         continue;
+      }
+      else
+      {
+         field.push_back( static_cast<char>( c ) );
+      }
+   }
+
+   if ( quoted )
+   {
+      throw std::runtime_error( "unterminated quoted field" );
+   }
+   fields.push_back( field );
+
+   return true;
+}
+
+void writeCsvRecord( std::ostream& stream, const Vector<String>& fields )
+{
+   for ( std::size_t i = 0; i < fields.size(); ++i )
+   {
+      const String& field( fields[ i ] );
+
+      if ( i > 0 )
+      {
+         stream << ',';
+      }
+
+      if ( field.find_first_of( ",\"\r\n" ) == String::npos )
+      {
+         stream << field;
+      }
+      else
+      {
+         stream << '"';
+         for ( const char c : field )
+         {
+            if ( c == '"' )
+            {
+               stream << '"';
+            }
+            stream << c;
+         }
+         stream << '"';
+      }
+   }
+   stream << "\r\n";
+}
+
+} }
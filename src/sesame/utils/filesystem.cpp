@@ -24,13 +24,44 @@
 
 
 #include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
 
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "sesame/utils/filesystem.hpp"
 
+namespace {
+
+void writeAll( int fd, const char* data, const std::size_t size )
+{
+   std::size_t written( 0 );
+   while ( written < size )
+   {
+      ssize_t count( ::write( fd, data + written, size - written ) );
+      if ( count == -1 )
+      {
+         if ( errno == EINTR )
+         {
+            continue;
+         }
+         throw std::runtime_error( "failed to write file" );
+      }
+      written += count;
+   }
+
+   if ( fsync( fd ) == -1 )
+   {
+      throw std::runtime_error( "failed to sync file" );
+   }
+}
+
+}
+
 namespace sesame { namespace utils {
 
 bool exists( const String& path )
@@ -81,6 +112,25 @@ std::size_t getFileSize( const String& path )
    }
 }
 
+uint64_t getModificationTime( const String& path )
+{
+   if ( isFile( path ) )
+   {
+      struct stat buf;
+      if ( lstat( path.c_str(), &buf ) == -1 )
+      {
+         throw std::runtime_error( "failed to stat file" );
+      }
+      return ( static_cast<uint64_t>( buf.st_mtim.tv_sec ) * 1000000000 ) + buf.st_mtim.tv_nsec;
+   }
+   else
+   {
+      StringStream s;
+      s << path << " is no file";
+      throw std::runtime_error( s.str().c_str() );
+   }
+}
+
 bool removeFile( const String& path )
 {
    if ( isFile( path ) )
@@ -152,4 +202,162 @@ const String incrementFileName( const String& fileNameIn, const String& delimite
    return fileNameOut;
 }
 
+const String getDirectory( const String& path, const String& delimiter )
+{
+   auto index( path.find_last_of( delimiter ) );
+
+   if ( index == String::npos )
+   {
+      return ".";
+   }
+   else if ( index == 0 )
+   {
+      return path.substr( 0, 1 );
+   }
+   else
+   {
+      return path.substr( 0, index );
+   }
+}
+
+const String getBackupFileName( const String& path, const std::size_t index )
+{
+   StringStream s;
+   s << path << "." << index;
+   return s.str();
+}
+
+void rotateBackups( const String& path, const std::size_t backups )
+{
+   if ( backups == 0 || ! isFile( path ) )
+   {
+      return;
+   }
+
+   // Shift FILE.(N-1) -> FILE.N, ..., FILE.1 -> FILE.2.
+   for ( std::size_t index( backups - 1 ); index > 0; --index )
+   {
+      const String older( getBackupFileName( path, index ) );
+      if ( exists( older ) )
+      {
+         if ( std::rename( older.c_str(), getBackupFileName( path, index + 1 ).c_str() ) == -1 )
+         {
+            throw std::runtime_error( "failed to rotate backups" );
+         }
+      }
+   }
+
+   // Hard link the current file as FILE.1, so FILE itself never vanishes.
+   const String newest( getBackupFileName( path, 1 ) );
+   if ( exists( newest ) && unlink( newest.c_str() ) == -1 )
+   {
+      throw std::runtime_error( "failed to rotate backups" );
+   }
+   if ( link( path.c_str(), newest.c_str() ) == -1 )
+   {
+      throw std::runtime_error( "failed to create backup" );
+   }
+}
+
+void writeFile( const String& path, const char* data, const std::size_t size, const std::size_t backups )
+{
+   if ( exists( path ) && ! isFile( path ) )
+   {
+      StringStream s;
+      s << path << " is no file";
+      throw std::runtime_error( s.str().c_str() );
+   }
+
+   // Temporary file has to be in the same directory to make rename atomic.
+   const String directory( getDirectory( path ) );
+   String tmpPath( path );
+   tmpPath.append( ".XXXXXX" );
+   Vector<char> tmpName( tmpPath.begin(), tmpPath.end() );
+   tmpName.push_back( '\0' );
+
+   int fd( mkstemp( tmpName.data() ) );
+   if ( fd == -1 )
+   {
+      throw std::runtime_error( "failed to create temporary file" );
+   }
+   tmpPath = tmpName.data();
+
+   try
+   {
+      writeAll( fd, data, size );
+   }
+   catch ( std::runtime_error& )
+   {
+      close( fd );
+      unlink( tmpPath.c_str() );
+      throw;
+   }
+
+   if ( close( fd ) == -1 )
+   {
+      unlink( tmpPath.c_str() );
+      throw std::runtime_error( "failed to close file" );
+   }
+
+   try
+   {
+      rotateBackups( path, backups );
+   }
+   catch ( std::runtime_error& )
+   {
+      unlink( tmpPath.c_str() );
+      throw;
+   }
+
+   if ( std::rename( tmpPath.c_str(), path.c_str() ) == -1 )
+   {
+      unlink( tmpPath.c_str() );
+      throw std::runtime_error( "failed to replace file" );
+   }
+
+   // Persist the directory entry as well.
+   int dirFd( open( directory.c_str(), O_RDONLY ) );
+   if ( dirFd == -1 )
+   {
+      throw std::runtime_error( "failed to open directory" );
+   }
+   int result( fsync( dirFd ) );
+   close( dirFd );
+   if ( result == -1 )
+   {
+      throw std::runtime_error( "failed to sync directory" );
+   }
+}
+
+void appendFile( const String& path, const char* data, const std::size_t size )
+{
+   if ( ! isFile( path ) )
+   {
+      StringStream s;
+      s << path << " is no file";
+      throw std::runtime_error( s.str().c_str() );
+   }
+
+   int fd( open( path.c_str(), O_WRONLY | O_APPEND ) );
+   if ( fd == -1 )
+   {
+      throw std::runtime_error( "failed to open file" );
+   }
+
+   try
+   {
+      writeAll( fd, data, size );
+   }
+   catch ( std::runtime_error& )
+   {
+      close( fd );
+      throw;
+   }
+
+   if ( close( fd ) == -1 )
+   {
+      throw std::runtime_error( "failed to close file" );
+   }
+}
+
 } }
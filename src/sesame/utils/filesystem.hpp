@@ -27,6 +27,7 @@
 #define SESAME_UTILS_FILESYSTEM_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include "types.hpp"
 
 namespace sesame { namespace utils {
@@ -34,9 +35,15 @@ namespace sesame { namespace utils {
 bool exists( const String& path );
 bool isFile( const String& path );
 std::size_t getFileSize( const String& path );
+uint64_t getModificationTime( const String& path );
 bool removeFile( const String& path );
 const String getExtension( const String& path, const String& delimiter = "/" );
 const String incrementFileName( const String& fileNameIn, const String& delimiter = "/" );
+const String getDirectory( const String& path, const String& delimiter = "/" );
+const String getBackupFileName( const String& path, const std::size_t index );
+void rotateBackups( const String& path, const std::size_t backups );
+void writeFile( const String& path, const char* data, const std::size_t size, const std::size_t backups = 0 );
+void appendFile( const String& path, const char* data, const std::size_t size );
 
 } }
 
@@ -80,13 +80,13 @@ cmd_line ::= NEW(C) NEWLINE.
 }
 cmd_line ::= OPEN.             { parseResult->setCompleteSpace(); }
 cmd_line ::= OPEN WHITESPACE.  { parseResult->setCompleteFile(); }
-cmd_line ::= OPEN(C) WHITESPACE ARGUMENT(A) NEWLINE.
+cmd_line ::= OPEN WHITESPACE paths.
+cmd_line ::= OPEN(C) WHITESPACE paths NEWLINE.
 {
-    parseResult->addToken( A );
     parseResult->addToken( C );
 
     parseResult->setCommand(
-        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::OPEN, A ) ) );
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::OPEN, parseResult->getArgumentTokens() ) ) );
 }
 cmd_line ::= CLOSE(C) NEWLINE.
 {
@@ -95,6 +95,23 @@ cmd_line ::= CLOSE(C) NEWLINE.
     parseResult->setCommand(
         std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::CLOSE ) ) );
 }
+cmd_line ::= SWITCH.             { parseResult->setCompleteSpace(); }
+cmd_line ::= SWITCH WHITESPACE.  { parseResult->setCompleteContainer(); }
+cmd_line ::= SWITCH(C) WHITESPACE OTHER_ID(ID) NEWLINE.
+{
+    parseResult->addToken( ID );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::SWITCH, ID ) ) );
+}
+cmd_line ::= CONTAINERS(C) NEWLINE.
+{
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::CONTAINERS ) ) );
+}
 cmd_line ::= LIST.             { parseResult->setCompleteSpace(); }
 cmd_line ::= LIST(C) NEWLINE.
 {
@@ -126,6 +143,16 @@ cmd_line ::= TAGS(C) NEWLINE.
     parseResult->setCommand(
         std::shared_ptr<ICommand>( new EntryTask( EntryTask::TAGS ) ) );
 }
+cmd_line ::= ROTATE.             { parseResult->setCompleteSpace(); }
+cmd_line ::= ROTATE WHITESPACE.  { parseResult->setCompleteTag(); }
+cmd_line ::= ROTATE(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new EntryTask( EntryTask::ROTATE, A ) ) );
+}
 cmd_line ::= SEARCH.             { parseResult->setCompleteSpace(); }
 cmd_line ::= SEARCH WHITESPACE.
 cmd_line ::= SEARCH(C) WHITESPACE ARGUMENT(A) NEWLINE.
@@ -354,6 +381,89 @@ cmd_line ::= WRITE(C) WHITESPACE ARGUMENT(A) NEWLINE.
     parseResult->setCommand(
         std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::WRITE, A ) ) );
 }
+cmd_line ::= WRITE(C) WHITESPACE ARGUMENT(A) WHITESPACE ARGUMENT(B) NEWLINE.
+{
+    parseResult->addToken( B );
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::WRITE, A, B ) ) );
+}
+cmd_line ::= JOURNAL.                  { parseResult->setCompleteSpace(); }
+cmd_line ::= JOURNAL(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::JOURNAL, A ) ) );
+}
+cmd_line ::= COMPACT.                  { parseResult->setCompleteSpace(); }
+cmd_line ::= COMPACT WHITESPACE.       { parseResult->setCompleteFile(); }
+cmd_line ::= COMPACT(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::COMPACT, A ) ) );
+}
+cmd_line ::= CONVERT.                  { parseResult->setCompleteSpace(); }
+cmd_line ::= CONVERT(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::CONVERT, A ) ) );
+}
+cmd_line ::= COMPRESS.                 { parseResult->setCompleteSpace(); }
+cmd_line ::= COMPRESS(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::COMPRESS, A ) ) );
+}
+cmd_line ::= IMPORT.                   { parseResult->setCompleteSpace(); }
+cmd_line ::= IMPORT(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::IMPORT, A ) ) );
+}
+cmd_line ::= EXPORT.                   { parseResult->setCompleteSpace(); }
+cmd_line ::= EXPORT(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::EXPORT, A ) ) );
+}
+cmd_line ::= OUTPUT.                   { parseResult->setCompleteSpace(); }
+cmd_line ::= OUTPUT(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::OUTPUT, A ) ) );
+}
+cmd_line ::= CAPACITY.             { parseResult->setCompleteSpace(); }
+cmd_line ::= CAPACITY WHITESPACE.  { parseResult->setCompleteFile(); }
+cmd_line ::= CAPACITY(C) WHITESPACE ARGUMENT(A) NEWLINE.
+{
+    parseResult->addToken( A );
+    parseResult->addToken( C );
+
+    parseResult->setCommand(
+        std::shared_ptr<ICommand>( new InstanceTask( InstanceTask::CAPACITY, A ) ) );
+}
 cmd_line ::= RECRYPT(C) NEWLINE.
 {
     parseResult->addToken( C );
@@ -369,3 +479,16 @@ arguments ::= ARGUMENT(A) WHITESPACE arguments.
 {
     parseResult->addToken( A );
 }
+paths ::= ARGUMENT(A).
+{
+    parseResult->addToken( A );
+}
+paths ::= ARGUMENT(A) WHITESPACE.
+{
+    parseResult->addToken( A );
+    parseResult->setCompleteFile();
+}
+paths ::= ARGUMENT(A) WHITESPACE paths.
+{
+    parseResult->addToken( A );
+}
@@ -0,0 +1,346 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "sesame/utils/json.hpp"
+
+namespace
+{
+   using sesame::utils::JsonValue;
+
+   const std::size_t MAX_DEPTH( 64 );
+
+   class JsonParser
+   {
+      public:
+         explicit JsonParser( const String& text ) :
+            m_Text( text ),
+            m_Pos( 0 )
+         {
+         }
+
+         JsonValue parse()
+         {
+            JsonValue value( parseValue( 0 ) );
+            skipWhitespace();
+            if ( m_Pos != m_Text.size() )
+            {
+               throw std::runtime_error( "invalid json" );
+            }
+            return value;
+         }
+
+      private:
+         void skipWhitespace()
+         {
+            while ( m_Pos < m_Text.size() &&
+                    ( m_Text[ m_Pos ] == ' ' || m_Text[ m_Pos ] == '\t' ||
+                      m_Text[ m_Pos ] == '\n' || m_Text[ m_Pos ] == '\r' ) )
+            {
+               ++m_Pos;
+            }
+         }
+
+         char peek()
+         {
+            skipWhitespace();
+            if ( m_Pos >= m_Text.size() )
+            {
+               throw std::runtime_error( "invalid json" );
+            }
+            return m_Text[ m_Pos ];
+         }
+
+         void expect( const char c )
+         {
+            if ( peek() != c )
+            {
+               throw std::runtime_error( "invalid json" );
+            }
+            ++m_Pos;
+         }
+
+         bool consume( const char* literal )
+         {
+            const String s( literal );
+            if ( m_Text.compare( m_Pos, s.size(), s ) == 0 )
+            {
+               m_Pos += s.size();
+               return true;
+            }
+            return false;
+         }
+
+         JsonValue parseValue( const std::size_t depth )
+         {
+            if ( depth > MAX_DEPTH )
+            {
+               throw std::runtime_error( "json nested too deeply" );
+            }
+
+            JsonValue value;
+            const char c( peek() );
+            if ( c == '{' )
+            {
+               value.m_Type = JsonValue::JSON_OBJECT;
+               ++m_Pos;
+               if ( peek() == '}' )
+               {
+                  ++m_Pos;
+                  return value;
+               }
+               do
+               {
+                  if ( peek() != '"' )
+                  {
+                     throw std::runtime_error( "invalid json" );
+                  }
+                  String key( parseString() );
+                  expect( ':' );
+                  value.m_Object.push_back( std::make_pair( key, parseValue( depth + 1 ) ) );
+               }
+               while ( next( '}' ) );
+            }
+            else if ( c == '[' )
+            {
+               value.m_Type = JsonValue::JSON_ARRAY;
+               ++m_Pos;
+               if ( peek() == ']' )
+               {
+                  ++m_Pos;
+                  return value;
+               }
+               do
+               {
+                  value.m_Array.push_back( parseValue( depth + 1 ) );
+               }
+               while ( next( ']' ) );
+            }
+            else if ( c == '"' )
+            {
+               value.m_Type = JsonValue::JSON_STRING;
+               value.m_String = parseString();
+            }
+            else if ( consume( "null" ) )
+            {
+               value.m_Type = JsonValue::JSON_NULL;
+            }
+            else if ( consume( "true" ) )
+            {
+               value.m_Type = JsonValue::JSON_BOOL;
+               value.m_Bool = true;
+            }
+            else if ( consume( "false" ) )
+            {
+               value.m_Type = JsonValue::JSON_BOOL;
+            }
+            else
+            {
+               value.m_Type = JsonValue::JSON_NUMBER;
+               const std::size_t start( m_Pos );
+               while ( m_Pos < m_Text.size() &&
+                       String( "+-.0123456789eE" ).find( m_Text[ m_Pos ] ) != String::npos )
+               {
+                  ++m_Pos;
+               }
+               if ( start == m_Pos )
+               {
+                  throw std::runtime_error( "invalid json" );
+               }
+               value.m_String = m_Text.substr( start, m_Pos - start );
+            }
+
+            return value;
+         }
+
+         // Consumes ',' (true) or the closing bracket (false).
+         bool next( const char closing )
+         {
+            const char c( peek() );
+            ++m_Pos;
+            if ( c == ',' )
+            {
+               return true;
+            }
+            if ( c != closing )
+            {
+               throw std::runtime_error( "invalid json" );
+            }
+            return false;
+         }
+
+         uint32_t parseHex4()
+         {
+            if ( m_Pos + 4 > m_Text.size() )
+            {
+               throw std::runtime_error( "invalid json" );
+            }
+
+            uint32_t result( 0 );
+            for ( std::size_t i = 0; i < 4; ++i )
+            {
+               const char c( m_Text[ m_Pos++ ] );
+               result <<= 4;
+               if ( c >= '0' && c <= '9' ) { result |= c - '0'; }
+               else if ( c >= 'a' && c <= 'f' ) { result |= c - 'a' + 10; }
+               else if ( c >= 'A' && c <= 'F' ) { result |= c - 'A' + 10; }
+               else { throw std::runtime_error( "invalid json" ); }
+            }
+            return result;
+         }
+
+         void appendUtf8( String& s, const uint32_t cp )
+         {
+            if ( cp < 0x80 )
+            {
+               s.push_back( static_cast<char>( cp ) );
+            }
+            else if ( cp < 0x800 )
+            {
+               s.push_back( static_cast<char>( 0xc0 | ( cp >> 6 ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( cp & 0x3f ) ) );
+            }
+            else if ( cp < 0x10000 )
+            {
+               s.push_back( static_cast<char>( 0xe0 | ( cp >> 12 ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3f ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( cp & 0x3f ) ) );
+            }
+            else
+            {
+               s.push_back( static_cast<char>( 0xf0 | ( cp >> 18 ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( ( cp >> 12 ) & 0x3f ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( ( cp >> 6 ) & 0x3f ) ) );
+               s.push_back( static_cast<char>( 0x80 | ( cp & 0x3f ) ) );
+            }
+         }
+
+         String parseString()
+         {
+            expect( '"' );
+
+            String result;
+            while ( true )
+            {
+               if ( m_Pos >= m_Text.size() )
+               {
+                  throw std::runtime_error( "invalid json" );
+               }
+
+               const char c( m_Text[ m_Pos++ ] );
+               if ( c == '"' )
+               {
+                  break;
+               }
+               else if ( static_cast<unsigned char>( c ) < 0x20 )
+               {
+                  throw std::runtime_error( "invalid json" );
+               }
+               else if ( c != '\\' )
+               {
+                  result.push_back( c );
+                  continue;
+               }
+
+               if ( m_Pos >= m_Text.size() )
+               {
+                  throw std::runtime_error( "invalid json" );
+               }
+               switch ( m_Text[ m_Pos++ ] )
+               {
+                  case '"': result.push_back( '"' ); break;
+                  case '\\': result.push_back( '\\' ); break;
+                  case '/': result.push_back( '/' ); break;
+                  case 'b': result.push_back( '\b' ); break;
+                  case 'f': result.push_back( '\f' ); break;
+                  case 'n': result.push_back( '\n' ); break;
+                  case 'r': result.push_back( '\r' ); break;
+                  case 't': result.push_back( '\t' ); break;
+                  case 'u':
+                  {
+                     uint32_t cp( parseHex4() );
+                     // Surrogate pair?
+                     if ( cp >= 0xd800 && cp < 0xdc00 )
+                     {
+                        if ( ! consume( "\\u" ) )
+                        {
+                           throw std::runtime_error( "invalid json" );
+                        }
+                        const uint32_t low( parseHex4() );
+                        if ( low < 0xdc00 || low >= 0xe000 )
+                        {
+                           throw std::runtime_error( "invalid json" );
+                        }
+                        cp = 0x10000 + ( ( cp - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+                     }
+                     else if ( cp >= 0xdc00 && cp < 0xe000 )
+                     {
+                        throw std::runtime_error( "invalid json" );
+                     }
+                     appendUtf8( result, cp );
+                     break;
+                  }
+                  default:
+                     throw std::runtime_error( "invalid json" );
+               }
+            }
+
+            return result;
+         }
+
+         const String& m_Text;
+         std::size_t m_Pos;
+   };
+}
+
+namespace sesame { namespace utils {
+
+JsonValue::JsonValue() :
+   m_Type( JSON_NULL ),
+   m_Bool( false )
+{
+}
+
+const JsonValue* JsonValue::find( const String& key ) const
+{
+   for ( const auto& member : m_Object )
+   {
+      if ( member.first == key )
+      {
+         return &( member.second );
+      }
+   }
+
+   return nullptr;
+}
+
+JsonValue parseJson( const String& text )
+{
+   return JsonParser( text ).parse();
+}
+
+} }
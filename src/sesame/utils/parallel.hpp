@@ -0,0 +1,201 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SESAME_UTILS_PARALLEL_HPP
+#define SESAME_UTILS_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "types.hpp"
+
+namespace sesame { namespace utils {
+
+/**
+ * Returns the number of workers to use for processing items
+ * (at least one, at most one per core).
+ *
+ * @param numOfItems the number of items to process
+ * @param minItemsPerWorker the minimal number of items a worker
+ *     should process to be worth a thread
+ *
+ * @return the number of workers
+ */
+inline std::size_t getNumOfWorkers( const std::size_t numOfItems, const std::size_t minItemsPerWorker )
+{
+   const std::size_t cores( std::max( 1U, std::thread::hardware_concurrency() ) );
+   const std::size_t wanted( numOfItems / std::max( std::size_t( 1 ), minItemsPerWorker ) );
+
+   return std::max( std::size_t( 1 ), std::min( cores, wanted ) );
+}
+
+/**
+ * Applies work to every item using a pool of workers, the calling
+ * thread is one of them. Items are handed out one by one, so work
+ * must not depend on the order. The first exception thrown by work
+ * stops all workers and is rethrown.
+ *
+ * @param items the items to process
+ * @param work the function to apply to every item
+ * @param minItemsPerWorker the minimal number of items a worker
+ *     should process to be worth a thread
+ */
+template<typename T, typename F>
+void runParallel( Vector<T>& items, F work, const std::size_t minItemsPerWorker = 1 )
+{
+   const std::size_t numOfWorkers( getNumOfWorkers( items.size(), minItemsPerWorker ) );
+   std::atomic<std::size_t> next( 0 );
+   std::exception_ptr error;
+   std::mutex mutex;
+
+   auto worker = [ & ]()
+   {
+      try
+      {
+         for ( std::size_t i( next++ ); i < items.size(); i = next++ )
+         {
+            work( items[ i ] );
+         }
+      }
+      catch ( ... )
+      {
+         std::lock_guard<std::mutex> lock( mutex );
+         if ( ! error )
+         {
+            error = std::current_exception();
+         }
+         next = items.size();
+      }
+   };
+
+   std::vector<std::thread> threads;
+   for ( std::size_t i = 1; i < numOfWorkers; ++i )
+   {
+      threads.push_back( std::thread( worker ) );
+   }
+   worker();
+   for ( auto& thread : threads )
+   {
+      thread.join();
+   }
+
+   if ( error )
+   {
+      std::rethrow_exception( error );
+   }
+}
+
+/**
+ * Applies work to every item using a pool of workers like runParallel(),
+ * but items are only started as long as the sum of their costs does not
+ * exceed the budget. An item costing more than the budget runs alone.
+ * Items are started in order, a cheaper item never overtakes one waiting
+ * for budget. The first exception thrown by work stops handing out items
+ * and is rethrown.
+ *
+ * @param items the items to process
+ * @param work the function to apply to every item
+ * @param cost the function returning the cost of an item
+ * @param budget the budget for items processed at the same time
+ */
+template<typename T, typename F, typename C>
+void runBudgeted( Vector<T>& items, F work, C cost, const uint64_t budget )
+{
+   const std::size_t numOfWorkers( getNumOfWorkers( items.size(), 1 ) );
+   std::size_t next( 0 );
+   std::size_t running( 0 );
+   uint64_t spent( 0 );
+   std::exception_ptr error;
+   std::mutex mutex;
+   std::condition_variable released;
+
+   auto worker = [ & ]()
+   {
+      std::unique_lock<std::mutex> lock( mutex );
+      while ( true )
+      {
+         // Next item has to start first, wait for budget.
+         released.wait( lock, [ & ]()
+            {
+               return next == items.size() || running == 0 || spent + cost( items[ next ] ) <= budget;
+            } );
+         if ( next == items.size() )
+         {
+            break;
+         }
+
+         T& item( items[ next++ ] );
+         const uint64_t price( cost( item ) );
+         spent += price;
+         ++running;
+
+         lock.unlock();
+         try
+         {
+            work( item );
+         }
+         catch ( ... )
+         {
+            lock.lock();
+            if ( ! error )
+            {
+               error = std::current_exception();
+            }
+            next = items.size();
+            lock.unlock();
+         }
+         lock.lock();
+
+         spent -= price;
+         --running;
+         released.notify_all();
+      }
+   };
+
+   std::vector<std::thread> threads;
+   for ( std::size_t i = 1; i < numOfWorkers; ++i )
+   {
+      threads.push_back( std::thread( worker ) );
+   }
+   worker();
+   for ( auto& thread : threads )
+   {
+      thread.join();
+   }
+
+   if ( error )
+   {
+      std::rethrow_exception( error );
+   }
+}
+
+} }
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <stdexcept>
+
+#include "sesame/utils/BloomFilter.hpp"
+#include "sesame/utils/parallel.hpp"
+#include "sesame/utils/passwords.hpp"
+
+
+namespace
+{
+   // Generating a password takes a few microseconds, fewer
+   // passwords per worker are not worth a thread.
+   const std::size_t MIN_PASSWORDS_PER_WORKER( 256 );
+
+   // Passwords found in the breached password filter are generated again,
+   // give up if params leave (almost) nothing else.
+   const std::size_t MAX_BREACHED_RETRIES( 1000 );
+}
+
+namespace sesame { namespace utils {
+
+Vector<String> generatePasswords( const ApgParams& params, const std::size_t count )
+{
+   char probe[ APG_MAX_LENGTH + 1 ];
+   const bool valid( apgGenerate( params, probe ) > 0 );
+   apgWipe( probe, sizeof( probe ) );
+   if ( ! valid )
+   {
+      throw std::runtime_error( "invalid password parameters (or no random device)" );
+   }
+
+   const BloomFilter* filter( BloomFilter::getDefault() );
+
+   Vector<String> passwords( count );
+   runParallel( passwords, [ &params, filter ]( String& password )
+   {
+      std::size_t retries( 0 );
+      do
+      {
+         if ( retries++ > MAX_BREACHED_RETRIES )
+         {
+            throw std::runtime_error( "too many breached passwords generated" );
+         }
+
+         password = apgGenerate<String>( params );
+         if ( password.empty() )
+         {
+            throw std::runtime_error( "failed to generate password" );
+         }
+      }
+      while ( filter && filter->contains( password ) );
+   },
+   MIN_PASSWORDS_PER_WORKER );
+
+   return passwords;
+}
+
+} }
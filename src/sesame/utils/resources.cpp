@@ -24,6 +24,9 @@
 
 
 #include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
 #ifdef __gnu_linux__
 #include <grp.h>
 #endif
@@ -133,7 +136,42 @@ bool lockMemory()
       return false;
    }
 
+#ifdef MCL_ONFAULT
+   // Lock pages once touched, so mappings (like the bloom filter) aren't read and pinned as a whole.
+   if ( mlockall( MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT ) == 0 )
+   {
+      return true;
+   }
+#endif
+
    return ( mlockall( MCL_CURRENT | MCL_FUTURE ) == 0 );
 }
 
+uint64_t getAvailableMemory()
+{
+   // Free memory (MemFree) doesn't count caches which can be reclaimed, MemAvailable does.
+   std::ifstream meminfo( "/proc/meminfo" );
+   std::string key;
+   uint64_t value;
+   while ( meminfo >> key >> value )
+   {
+      if ( key == "MemAvailable:" )
+      {
+         return value * 1024;
+      }
+      meminfo.ignore( std::numeric_limits<std::streamsize>::max(), '\n' );
+   }
+
+#ifdef _SC_AVPHYS_PAGES
+   const long pages( sysconf( _SC_AVPHYS_PAGES ) );
+   const long pageSize( sysconf( _SC_PAGESIZE ) );
+   if ( pages > 0 && pageSize > 0 )
+   {
+      return static_cast<uint64_t>( pages ) * static_cast<uint64_t>( pageSize );
+   }
+#endif
+
+   return 0;
+}
+
 } }
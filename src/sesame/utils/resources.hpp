@@ -25,6 +25,8 @@
 #ifndef SESAME_UTILS_RESOURCES_HPP
 #define SESAME_UTILS_RESOURCES_HPP
 
+#include <cstdint>
+
 namespace sesame { namespace utils {
 
 /**
@@ -56,12 +58,21 @@ bool dropPrivileges();
 bool disableCoreFiles();
 
 /**
- * Locks allocated memory (present and future) to avoid swapping.
+ * Locks allocated memory (present and future) to avoid swapping,
+ * pages are locked once touched where supported.
  *
  * @return <tt>true</tt> for success, otherwise <tt>false</tt>
  */
 bool lockMemory();
 
+/**
+ * Returns the physical memory currently available
+ * (<tt>MemAvailable</tt>, incl. reclaimable caches).
+ *
+ * @return the available memory in bytes (<tt>0</tt> if unknown)
+ */
+uint64_t getAvailableMemory();
+
 } }
 
 #endif
@@ -0,0 +1,280 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "sesame/utils/socket.hpp"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+// Creates a socket which isn't inherited by child processes.
+int createSocket()
+{
+#ifdef SOCK_CLOEXEC
+   int fd( ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+#else
+   int fd( ::socket( AF_UNIX, SOCK_STREAM, 0 ) );
+   if ( fd != -1 )
+   {
+      fcntl( fd, F_SETFD, FD_CLOEXEC );
+   }
+#endif
+   if ( fd == -1 )
+   {
+      throw std::runtime_error( "failed to create socket" );
+   }
+
+   return fd;
+}
+
+struct sockaddr_un toAddress( const String& path )
+{
+   struct sockaddr_un address;
+   std::memset( &address, 0, sizeof( address ) );
+   address.sun_family = AF_UNIX;
+
+   if ( path.empty() || path.size() >= sizeof( address.sun_path ) )
+   {
+      throw std::runtime_error( "invalid socket path" );
+   }
+   std::memcpy( address.sun_path, path.data(), path.size() );
+
+   return address;
+}
+
+// Returns true if an agent accepts connections on the socket,
+// false if the socket is stale (connection refused).
+bool isServed( const struct sockaddr_un& address )
+{
+   int fd( createSocket() );
+
+   int rc( ::connect( fd, reinterpret_cast<const struct sockaddr*>( &address ), sizeof( address ) ) );
+   int error( errno );
+   ::close( fd );
+
+   if ( rc == 0 )
+   {
+      return true;
+   }
+   if ( error != ECONNREFUSED )
+   {
+      throw std::runtime_error( "failed to check socket" );
+   }
+
+   return false;
+}
+
+}
+
+namespace sesame { namespace utils {
+
+int listenOn( const String& path )
+{
+   struct sockaddr_un address( toAddress( path ) );
+
+   int fd( createSocket() );
+
+   // Remove stale socket, never anything else (like the socket of a running agent).
+   struct stat buf;
+   if ( lstat( path.c_str(), &buf ) != -1 && S_ISSOCK( buf.st_mode ) )
+   {
+      bool served( true );
+      try
+      {
+         served = isServed( address );
+      }
+      catch ( std::runtime_error& )
+      {
+         ::close( fd );
+         throw;
+      }
+
+      if ( served )
+      {
+         ::close( fd );
+         throw std::runtime_error( "agent already running" );
+      }
+      unlink( path.c_str() );
+   }
+
+   // Socket must be accessible by owner only.
+   mode_t mask( umask( 0177 ) );
+   int rc( ::bind( fd, reinterpret_cast<struct sockaddr*>( &address ), sizeof( address ) ) );
+   umask( mask );
+
+   if ( rc == -1 || ::listen( fd, 16 ) == -1 )
+   {
+      ::close( fd );
+      throw std::runtime_error( "failed to listen on socket" );
+   }
+
+   return fd;
+}
+
+int acceptOn( const int fd, const int timeout )
+{
+   int client;
+   do
+   {
+#ifdef __gnu_linux__
+      client = ::accept4( fd, nullptr, nullptr, SOCK_CLOEXEC );
+#else
+      client = ::accept( fd, nullptr, nullptr );
+#endif
+   }
+   while ( client == -1 && errno == ECONNABORTED );
+
+   if ( client == -1 )
+   {
+      throw std::runtime_error( "failed to accept connection" );
+   }
+#ifndef __gnu_linux__
+   fcntl( client, F_SETFD, FD_CLOEXEC );
+#endif
+
+   // Slow clients must not block the caller forever.
+   struct timeval tv;
+   tv.tv_sec = timeout / 1000;
+   tv.tv_usec = ( timeout % 1000 ) * 1000;
+   setsockopt( client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+   setsockopt( client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+
+   return client;
+}
+
+int connectTo( const String& path )
+{
+   struct sockaddr_un address( toAddress( path ) );
+
+   int fd( createSocket() );
+
+   if ( ::connect( fd, reinterpret_cast<struct sockaddr*>( &address ), sizeof( address ) ) == -1 )
+   {
+      ::close( fd );
+      throw std::runtime_error( "failed to connect to agent" );
+   }
+
+   return fd;
+}
+
+bool isPeerTrusted( const int fd )
+{
+#if defined(__gnu_linux__) || defined(__OpenBSD__)
+#ifdef __gnu_linux__
+   struct ucred credentials;
+#else
+   struct sockpeercred credentials;
+#endif
+   socklen_t size( sizeof( credentials ) );
+
+   if ( getsockopt( fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size ) == -1 )
+   {
+      return false;
+   }
+
+   return credentials.uid == getuid();
+#else
+   uid_t uid;
+   gid_t gid;
+
+   if ( getpeereid( fd, &uid, &gid ) == -1 )
+   {
+      return false;
+   }
+
+   return uid == getuid();
+#endif
+}
+
+void sendAll( const int fd, const Vector<uint8_t>& data )
+{
+   std::size_t sent( 0 );
+   while ( sent < data.size() )
+   {
+      ssize_t count( ::send( fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL ) );
+      if ( count == -1 )
+      {
+         if ( errno == EINTR )
+         {
+            continue;
+         }
+         throw std::runtime_error( "failed to send data" );
+      }
+      sent += count;
+   }
+
+   // Signal end of message.
+   ::shutdown( fd, SHUT_WR );
+}
+
+void receiveAll( const int fd, Vector<uint8_t>& data, const std::size_t maxSize )
+{
+   // Received data may be secret, Allocator wipes the buffer.
+   Vector<uint8_t> buffer( 4096 );
+   data.clear();
+
+   while ( true )
+   {
+      ssize_t count( ::recv( fd, buffer.data(), buffer.size(), 0 ) );
+      if ( count == -1 )
+      {
+         if ( errno == EINTR )
+         {
+            continue;
+         }
+         throw std::runtime_error( "failed to receive data" );
+      }
+      if ( count == 0 )
+      {
+         break;
+      }
+      if ( data.size() + count > maxSize )
+      {
+         throw std::runtime_error( "message too large" );
+      }
+      data.insert( data.end(), buffer.data(), buffer.data() + count );
+   }
+}
+
+void closeSocket( const int fd )
+{
+   ::close( fd );
+}
+
+} }
@@ -23,7 +23,10 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <cctype>
 #include <clocale>
+#include <cstdint>
+#include <cstring>
 #include <locale>
 #include <iostream>
 #include <stdexcept>
@@ -39,6 +42,126 @@ namespace
          string = "";
       }
    }
+
+   /**
+    * Returns true if the encoding names UTF-8 (e.g. UTF-8 or utf8).
+    */
+   bool isUtf8( const String& encoding )
+   {
+      String name;
+      for ( const char c : encoding )
+      {
+         if ( c != '-' && c != '_' )
+         {
+            name += std::tolower( static_cast<unsigned char>( c ) );
+         }
+      }
+
+      return name == "utf8";
+   }
+
+   /**
+    * Returns the number of leading ASCII bytes, 8 bytes are checked
+    * at once as long as possible.
+    */
+   std::size_t skipAscii( const uint8_t* text, const std::size_t length )
+   {
+      std::size_t i( 0 );
+      for ( ; ( i + 8 ) <= length; i += 8 )
+      {
+         uint64_t word;
+         std::memcpy( &word, text + i, sizeof( word ) );
+         if ( word & 0x8080808080808080ULL )
+         {
+            break;
+         }
+      }
+      while ( i < length && text[ i ] < 0x80 )
+      {
+         ++i;
+      }
+
+      return i;
+   }
+
+   /**
+    * Returns true if text is well-formed UTF-8: overlong forms,
+    * surrogates, code points above U+10FFFF and incomplete sequences
+    * are rejected.
+    */
+   bool isValidUtf8( const char* text, const std::size_t length )
+   {
+      const uint8_t* data( reinterpret_cast<const uint8_t*>( text ) );
+
+      std::size_t i( 0 );
+      while ( ( i += skipAscii( data + i, length - i ) ) < length )
+      {
+         const uint8_t lead( data[ i ] );
+         std::size_t size( 0 );
+         uint8_t min( 0x80 ), max( 0xbf );
+
+         if ( lead >= 0xc2 && lead <= 0xdf )
+         {
+            size = 2;
+         }
+         else if ( lead >= 0xe0 && lead <= 0xef )
+         {
+            size = 3;
+            if ( lead == 0xe0 ) { min = 0xa0; }
+            if ( lead == 0xed ) { max = 0x9f; }
+         }
+         else if ( lead >= 0xf0 && lead <= 0xf4 )
+         {
+            size = 4;
+            if ( lead == 0xf0 ) { min = 0x90; }
+            if ( lead == 0xf4 ) { max = 0x8f; }
+         }
+         else
+         {
+            return false;
+         }
+
+         if ( ( length - i ) < size )
+         {
+            return false;
+         }
+
+         for ( std::size_t j( 1 ); j < size; ++j, min = 0x80, max = 0xbf )
+         {
+            if ( data[ i + j ] < min || data[ i + j ] > max )
+            {
+               return false;
+            }
+         }
+
+         i += size;
+      }
+
+      return true;
+   }
+
+   /**
+    * Copies text which is already encoded in the target encoding,
+    * a leading UTF-8 BOM is stripped like Transcoder does.
+    */
+   String passThrough( const char* text, const std::size_t length )
+   {
+      std::size_t bom( 0 );
+      if ( length > 3 && std::memcmp( text, "\xef\xbb\xbf", 3 ) == 0 )
+      {
+         bom = 3;
+      }
+
+      return String( text + bom, length - bom );
+   }
+
+   /**
+    * Returns true if text consists of ASCII bytes only.
+    */
+   bool isAscii( const char* text, const std::size_t length )
+   {
+      return skipAscii( reinterpret_cast<const uint8_t*>( text ), length ) == length;
+   }
 }
 
 namespace sesame { namespace utils {
@@ -148,7 +271,18 @@ std::pair<String,String> split( const String& string )
 
 String toUtf8( const char* text, const std::size_t length )
 {
-   static Transcoder transcoder( getEncoding(), "UTF-8" );
+   static const String encoding( getEncoding() );
+   static const bool utf8( isUtf8( encoding ) );
+
+   // No need to transcode ASCII or valid UTF-8 to UTF-8, anything
+   // else is left to iconv (incl. error handling).
+   if ( utf8 ? isValidUtf8( text, length ) : isAscii( text, length ) )
+   {
+      return passThrough( text, length );
+   }
+
+   // One descriptor per thread, iconv_t must not be shared.
+   thread_local Transcoder transcoder( encoding, "UTF-8" );
 
    return transcoder.transcode( text, length );
 }
@@ -160,7 +294,18 @@ String toUtf8( const String& text )
 
 String fromUtf8( const char* text, const std::size_t length )
 {
-   static Transcoder transcoder( "UTF-8", getEncoding() );
+   static const String encoding( getEncoding() );
+   static const bool utf8( isUtf8( encoding ) );
+
+   // No need to transcode valid UTF-8 to UTF-8 or ASCII, anything
+   // else is left to iconv (incl. error handling).
+   if ( utf8 ? isValidUtf8( text, length ) : isAscii( text, length ) )
+   {
+      return passThrough( text, length );
+   }
+
+   // One descriptor per thread, iconv_t must not be shared.
+   thread_local Transcoder transcoder( "UTF-8", encoding );
 
    return transcoder.transcode( text, length );
 }
@@ -0,0 +1,191 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "msgpack.hpp"
+#include "sesame/utils/zone.hpp"
+
+namespace
+{
+   /** Bytes of released chunks kept for reuse. */
+   const std::size_t MAX_FREE_BYTES( 1 << 20 );
+   /** Chunk header of msgpack zones (approximately), used for reservation only. */
+   const std::size_t HEADER_SIZE( 64 );
+
+   /**
+    * Blocks are prefixed with their size. A free block is reused
+    * for requests of at least half its size.
+    */
+   struct Arena
+   {
+      Arena() : m_FreeBytes( 0 ) {}
+
+      std::mutex m_Mutex;
+      std::multimap<std::size_t, uint8_t*> m_Free;
+      std::size_t m_FreeBytes;
+   };
+
+   Arena& getArena()
+   {
+      // Never destroyed, zones might be released during static destruction.
+      static Arena* arena( new Arena() );
+      return *arena;
+   }
+
+   void wipe( uint8_t* p, std::size_t size )
+   {
+      volatile uint8_t* _p( p );
+      while ( size-- )
+      {
+         *( _p++ ) = 0;
+      }
+   }
+
+   // Blocks are mapped separately, so locking one never touches pages of another.
+   std::size_t getMappedSize( const std::size_t size )
+   {
+      static const std::size_t pageSize( sysconf( _SC_PAGESIZE ) );
+      const std::size_t bytes( sizeof( std::size_t ) + size );
+      return ( ( bytes + pageSize - 1 ) / pageSize ) * pageSize;
+   }
+
+   uint8_t* createBlock( const std::size_t size )
+   {
+      const std::size_t bytes( getMappedSize( size ) );
+      void* p( mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+      if ( p == MAP_FAILED )
+      {
+         return nullptr;
+      }
+
+      // Best effort, memory is locked anyway if mlockall() succeeded.
+      uint8_t* block( static_cast<uint8_t*>( p ) );
+      mlock( block, bytes );
+      *reinterpret_cast<std::size_t*>( block ) = size;
+
+      return block;
+   }
+
+   void destroyBlock( uint8_t* block )
+   {
+      const std::size_t bytes( getMappedSize( *reinterpret_cast<std::size_t*>( block ) ) );
+      munlock( block, bytes );
+      munmap( block, bytes );
+   }
+
+   void* allocate( std::size_t size )
+   {
+      Arena& arena( getArena() );
+      uint8_t* block( nullptr );
+      {
+         std::lock_guard<std::mutex> lock( arena.m_Mutex );
+         std::multimap<std::size_t, uint8_t*>::iterator it( arena.m_Free.lower_bound( size ) );
+         if ( it != arena.m_Free.end() && it->first / 2 <= size )
+         {
+            block = it->second;
+            arena.m_FreeBytes -= it->first;
+            arena.m_Free.erase( it );
+         }
+      }
+
+      if ( block == nullptr )
+      {
+         block = createBlock( size );
+         if ( block == nullptr )
+         {
+            return nullptr;
+         }
+      }
+
+      return block + sizeof( std::size_t );
+   }
+
+   void deallocate( void* p, std::size_t )
+   {
+      uint8_t* block( static_cast<uint8_t*>( p ) - sizeof( std::size_t ) );
+      const std::size_t size( *reinterpret_cast<std::size_t*>( block ) );
+      wipe( block + sizeof( std::size_t ), size );
+
+      Arena& arena( getArena() );
+      {
+         std::lock_guard<std::mutex> lock( arena.m_Mutex );
+         if ( arena.m_FreeBytes + size <= MAX_FREE_BYTES )
+         {
+            arena.m_Free.insert( std::make_pair( size, block ) );
+            arena.m_FreeBytes += size;
+            return;
+         }
+      }
+
+      destroyBlock( block );
+   }
+}
+
+namespace sesame { namespace utils {
+
+void useSecureZones( const std::size_t reserved )
+{
+   Arena& arena( getArena() );
+   {
+      std::lock_guard<std::mutex> lock( arena.m_Mutex );
+      const std::size_t size( MSGPACK_ZONE_CHUNK_SIZE + HEADER_SIZE );
+      for ( std::size_t i = arena.m_Free.size(); i < reserved; ++i )
+      {
+         if ( arena.m_FreeBytes + size > MAX_FREE_BYTES )
+         {
+            break;
+         }
+
+         uint8_t* block( createBlock( size ) );
+         if ( block == nullptr )
+         {
+            throw std::bad_alloc();
+         }
+         arena.m_Free.insert( std::make_pair( size, block ) );
+         arena.m_FreeBytes += size;
+      }
+   }
+
+   msgpack::zone_chunk_allocator allocator = { &allocate, &deallocate };
+   msgpack::set_zone_chunk_allocator( allocator );
+}
+
+std::size_t getNumOfFreeZoneChunks()
+{
+   Arena& arena( getArena() );
+   std::lock_guard<std::mutex> lock( arena.m_Mutex );
+
+   return arena.m_Free.size();
+}
+
+} }
@@ -31,9 +31,9 @@
 
 namespace sesame {
 
-const uint32_t VERSION_MAJOR = 0;
-const uint32_t VERSION_MINOR = 6;
-const uint32_t VERSION_BUGFIX = 7;
+const uint32_t VERSION_MAJOR = 1;
+const uint32_t VERSION_MINOR = 0;
+const uint32_t VERSION_BUGFIX = 0;
 
 namespace
 {
@@ -25,7 +25,9 @@
 
 #include <algorithm>
 #include <fstream>
+#include <memory>
 #include <stdexcept>
+#include <thread>
 #include "gtest/gtest.h"
 #include "types.hpp"
 #include "sesame/definitions.hpp"
@@ -175,18 +177,10 @@ TEST( InstanceTest, DeSerialization )
 {
    utils::setLocale();
 
-   Map<String,Vector<uint8_t>> params1;
-   {
-      Vector<uint8_t> ldN;
-      packV( ldN, 10U );
-      params1[ utils::fromUtf8( u8"ldN" ) ] = ldN;
-   }
-   Map<String,Vector<uint8_t>> params2;
-   {
-      Vector<uint8_t> ldN;
-      packV( ldN, 8U );
-      params2[ utils::fromUtf8( u8"ldN" ) ] = ldN;
-   }
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
 
    Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
    ASSERT_EQ( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, instance.getProtocol() );
@@ -243,18 +237,10 @@ TEST( InstanceTest, LabeledData )
 {
    utils::setLocale();
 
-   Map<String,Vector<uint8_t>> params1;
-   {
-      Vector<uint8_t> ldN;
-      packV( ldN, 10U );
-      params1[ utils::fromUtf8( u8"ldN" ) ] = ldN;
-   }
-   Map<String,Vector<uint8_t>> params2;
-   {
-      Vector<uint8_t> ldN;
-      packV( ldN, 8U );
-      params2[ utils::fromUtf8( u8"ldN" ) ] = ldN;
-   }
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
 
    Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
    ASSERT_EQ( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, instance.getProtocol() );
@@ -298,4 +284,381 @@ TEST( InstanceTest, LabeledData )
    ASSERT_EQ( String( "password" ), copy.getLabeledData().begin()->second.getPlaintext<String>() );
 }
 
+TEST( InstanceTest, EncryptEntries )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   Entry e1( "Example Entry 1" );
+   ASSERT_TRUE( e1.addLabeledData( "password", Data( "old" ) ) );
+   ASSERT_TRUE( instance.addEntry( e1 ) );
+
+   std::stringstream stream;
+   ASSERT_NO_THROW( instance.write( stream, "hello world" ) );
+
+   Entry copy( instance.findEntry( e1.getIdAsHexString() ) );
+   ASSERT_TRUE( copy.updateLabeledData( "password", "password", Data( "new" ) ) );
+   ASSERT_TRUE( instance.updateEntry( copy ) );
+
+   ASSERT_THROW( instance.encryptEntries( "wrong" ), std::runtime_error );
+   ASSERT_TRUE( instance.findEntry( e1.getIdAsHexString() ).getLabeledData().begin()->second.isDirty() );
+
+   ASSERT_NO_THROW( instance.encryptEntries( "hello world" ) );
+   ASSERT_FALSE( instance.findEntry( e1.getIdAsHexString() ).getLabeledData().begin()->second.isDirty() );
+   ASSERT_TRUE( instance.isDirty() );
+
+   stream.str( "" );
+   ASSERT_NO_THROW( instance.write( stream, "hello world" ) );
+   stream.seekg( 0, std::ios_base::beg );
+   Instance rebuild( stream, "hello world" );
+   copy = rebuild.findEntry( e1.getIdAsHexString() );
+   ASSERT_NO_THROW( rebuild.decryptEntry( copy, "hello world" ) );
+   ASSERT_EQ( String( "new" ), copy.getLabeledData().begin()->second.getPlaintext<String>() );
+}
+
+TEST( InstanceTest, Journal )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+
+   Entry e1( "Example Entry 1" );
+   Entry e2( "Example Entry 2" );
+   Entry e3( "Example Entry 3" );
+   ASSERT_TRUE( instance.addEntry( e1 ) );
+   ASSERT_TRUE( instance.addEntry( e2 ) );
+
+   // Journal requires a snapshot.
+   {
+      StringStream tmp;
+      ASSERT_THROW( instance.writeJournal( tmp, "hello world" ), std::runtime_error );
+   }
+
+   StringStream container;
+   ASSERT_NO_THROW( instance.write( container, "hello world" ) );
+   ASSERT_EQ( 0, instance.getNumOfChanges() );
+   ASSERT_TRUE( instance.isStoredIn( container ) );
+   const std::size_t snapshotSize( container.str().size() );
+
+   // Changes: add e3, update e1 (with a password), delete e2.
+   ASSERT_TRUE( instance.addEntry( e3 ) );
+   Entry copy( instance.findEntry( e1.getIdAsHexString() ) );
+   copy.setName( "Example Entry 4" );
+   ASSERT_TRUE( copy.addLabeledData( "password", Data( "password" ) ) );
+   ASSERT_TRUE( instance.updateEntry( copy ) );
+   Entry e2copy( instance.findEntry( e2.getIdAsHexString() ) );
+   ASSERT_TRUE( instance.deleteEntry( e2copy ) );
+   ASSERT_EQ( 3, instance.getNumOfChanges() );
+   ASSERT_TRUE( instance.isDirty() );
+
+   {
+      StringStream records;
+      ASSERT_EQ( 3, instance.writeJournal( records, "hello world" ) );
+      container.seekp( 0, std::ios_base::end );
+      container << records.str();
+   }
+   ASSERT_FALSE( instance.isDirty() );
+   ASSERT_EQ( 0, instance.getNumOfChanges() );
+   ASSERT_TRUE( instance.isStoredIn( container ) );
+
+   // Journal records are small compared to the snapshot.
+   const String dump( container.str() );
+   ASSERT_LT( dump.size() - snapshotSize, 2 * snapshotSize );
+
+   // Replay.
+   {
+      StringStream stream( dump );
+      Instance rebuild( stream, "hello world" );
+      ASSERT_TRUE( rebuild.isJournaled() );
+      ASSERT_FALSE( rebuild.isDirty() );
+      ASSERT_EQ( instance.getEntries(), rebuild.getEntries() );
+      ASSERT_EQ( 2, rebuild.getNumOfEntries() );
+      ASSERT_EQ( String( "Example Entry 4" ), rebuild.findEntry( e1.getIdAsHexString() ).getName() );
+      ASSERT_THROW( rebuild.findEntry( e2.getIdAsHexString() ), std::runtime_error );
+
+      Entry decrypted( rebuild.findEntry( e1.getIdAsHexString() ) );
+      ASSERT_NO_THROW( rebuild.decryptEntry( decrypted, "hello world" ) );
+      ASSERT_EQ( String( "password" ), decrypted.getLabeledData().begin()->second.getPlaintext<String>() );
+      ASSERT_TRUE( rebuild.isStoredIn( stream ) );
+   }
+
+   // A torn last record is ignored.
+   {
+      StringStream stream( dump.substr( 0, snapshotSize + 5 ) );
+      Instance rebuild( stream, "hello world" );
+      ASSERT_FALSE( rebuild.isJournaled() );
+      ASSERT_EQ( 2, rebuild.getNumOfEntries() );
+      ASSERT_EQ( String( "Example Entry 1" ), rebuild.findEntry( e1.getIdAsHexString() ).getName() );
+      ASSERT_FALSE( rebuild.isStoredIn( stream ) );
+   }
+
+   // A manipulated record is detected.
+   {
+      String manipulated( dump );
+      manipulated[ snapshotSize + 10 ] ^= 0x01;
+      StringStream stream( manipulated );
+      ASSERT_THROW( Instance rebuild( stream, "hello world" ), std::runtime_error );
+   }
+
+   // A corrupted record followed by others isn't taken as torn.
+   {
+      String corrupted( dump );
+      corrupted[ snapshotSize ] = static_cast<char>( 0xc1 );
+      StringStream stream( corrupted );
+      ASSERT_THROW( Instance rebuild( stream, "hello world" ), std::runtime_error );
+   }
+
+   // Compaction drops the journal.
+   {
+      StringStream stream( dump );
+      Instance rebuild( stream, "hello world" );
+      StringStream compacted;
+      ASSERT_NO_THROW( rebuild.write( compacted, "hello world" ) );
+      Instance rebuild2( compacted, "hello world" );
+      ASSERT_FALSE( rebuild2.isJournaled() );
+      ASSERT_EQ( instance.getEntries(), rebuild2.getEntries() );
+   }
+}
+
+TEST( InstanceTest, Formats )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   ASSERT_EQ( FORMAT_V1, instance.getFormat() );
+
+   Entry e1( "Example Entry 1" );
+   e1.addTag( "tag1" );
+   e1.addAttribute( "user", "john" );
+   ASSERT_TRUE( e1.addLabeledData( "password", Data( "password" ) ) );
+   Entry e2( "Example Entry 2" );
+   ASSERT_TRUE( instance.addEntry( e1 ) );
+   ASSERT_TRUE( instance.addEntry( e2 ) );
+
+   StringStream v1;
+   ASSERT_NO_THROW( instance.write( v1, "hello world" ) );
+
+   // Entries are loaded on first access only.
+   Instance rebuild( v1, "hello world" );
+   ASSERT_EQ( FORMAT_V1, rebuild.getFormat() );
+   ASSERT_FALSE( rebuild.isPlain() );
+   Set<Entry> index( rebuild.getIndex() );
+   ASSERT_EQ( 2, index.size() );
+   for ( const auto& entry : index )
+   {
+      ASSERT_FALSE( entry.isLoaded() );
+      ASSERT_TRUE( entry.getAttributes().empty() );
+   }
+   ASSERT_EQ( 1, rebuild.getIndex( { "tag1" } ).size() );
+   ASSERT_EQ( Set<String>( { "tag1" } ), rebuild.getTags() );
+
+   // Not loaded entries can't be updated.
+   Entry stub( *( rebuild.findIndex( e1.getIdAsHexString() ).begin() ) );
+   ASSERT_FALSE( rebuild.updateEntry( stub ) );
+
+   Entry loaded( rebuild.findEntry( e1.getIdAsHexString() ) );
+   ASSERT_TRUE( loaded.isLoaded() );
+   ASSERT_EQ( String( "john" ), loaded.getAttributes().at( "user" ) );
+   ASSERT_FALSE( rebuild.isDirty() );
+   ASSERT_FALSE( ( *( rebuild.findIndex( e2.getIdAsHexString() ).begin() ) ).isLoaded() );
+
+   // Not loaded entries are written as they are.
+   loaded.setName( "Example Entry 3" );
+   ASSERT_TRUE( rebuild.updateEntry( loaded ) );
+   StringStream v1b;
+   ASSERT_NO_THROW( rebuild.write( v1b, "hello world" ) );
+   {
+      Instance tmp( v1b, "hello world" );
+      ASSERT_EQ( String( "Example Entry 3" ), tmp.findEntry( e1.getIdAsHexString() ).getName() );
+      ASSERT_EQ( String( "Example Entry 2" ), tmp.findEntry( e2.getIdAsHexString() ).getName() );
+      Entry decrypted( tmp.findEntry( e1.getIdAsHexString() ) );
+      ASSERT_NO_THROW( tmp.decryptEntry( decrypted, "hello world" ) );
+      ASSERT_EQ( String( "password" ), decrypted.getLabeledData().begin()->second.getPlaintext<String>() );
+   }
+
+   // Convert to v0 and back.
+   rebuild.setFormat( FORMAT_V0 );
+   StringStream v0;
+   ASSERT_NO_THROW( rebuild.write( v0, "hello world" ) );
+   {
+      uint32_t majorVersion;
+      unpack( v0, majorVersion );
+      ASSERT_EQ( 0, majorVersion );
+      v0.seekg( 0, std::ios_base::beg );
+   }
+   Instance rebuildV0( v0, "hello world" );
+   ASSERT_EQ( FORMAT_V0, rebuildV0.getFormat() );
+   ASSERT_TRUE( ( *( rebuildV0.getIndex().begin() ) ).isLoaded() );
+   ASSERT_EQ( rebuild.getEntries(), rebuildV0.getEntries() );
+
+   rebuildV0.setFormat( FORMAT_V1 );
+   StringStream v1c;
+   ASSERT_NO_THROW( rebuildV0.write( v1c, "hello world" ) );
+   Instance rebuildV1( v1c, "hello world" );
+   ASSERT_EQ( FORMAT_V1, rebuildV1.getFormat() );
+   ASSERT_EQ( rebuild.getEntries(), rebuildV1.getEntries() );
+   for ( const auto& entry : rebuildV1.getIndex() )
+   {
+      ASSERT_TRUE( entry.isLoaded() );
+   }
+   ASSERT_FALSE( rebuildV1.isDirty() );
+}
+
+TEST( InstanceTest, Compression )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   ASSERT_EQ( COMPRESSION_NONE, instance.getCompression() );
+
+   Set<String> ids;
+   for ( std::size_t i = 0; i < 20; ++i )
+   {
+      StringStream name;
+      name << "Example Entry " << i;
+      Entry entry( name.str() );
+      entry.addTag( "example" );
+      entry.addAttribute( "user", "john.doe@example.com" );
+      entry.addAttribute( "url", "https://www.example.com/login" );
+      entry.addAttribute( "comment", "security question: name of the first pet, answer: see below" );
+      ASSERT_TRUE( instance.addEntry( entry ) );
+      ids.insert( entry.getIdAsHexString() );
+   }
+
+   StringStream plain;
+   ASSERT_NO_THROW( instance.write( plain, "hello world" ) );
+
+   // Compression is applied on next write (a snapshot, not journal records).
+   ASSERT_FALSE( instance.isDirty() );
+   instance.setCompression( COMPRESSION_DEFLATE );
+   ASSERT_TRUE( instance.isLayoutChanged() );
+   ASSERT_TRUE( instance.isDirty() );
+   StringStream compressed;
+   ASSERT_NO_THROW( instance.write( compressed, "hello world" ) );
+   ASSERT_FALSE( instance.isLayoutChanged() );
+   ASSERT_FALSE( instance.isDirty() );
+   ASSERT_LT( compressed.str().size(), plain.str().size() );
+
+   Instance rebuild( compressed, "hello world" );
+   ASSERT_EQ( COMPRESSION_DEFLATE, rebuild.getCompression() );
+   ASSERT_EQ( 20, rebuild.getNumOfEntries() );
+   for ( const auto& id : ids )
+   {
+      ASSERT_EQ( instance.findEntry( id ), rebuild.findEntry( id ) );
+   }
+   ASSERT_FALSE( rebuild.isDirty() );
+
+   // Not loaded entries are recompressed, if compression changes.
+   compressed.seekg( 0, std::ios_base::beg );
+   Instance other( compressed, "hello world" );
+   other.setCompression( COMPRESSION_NONE );
+   StringStream uncompressed;
+   ASSERT_NO_THROW( other.write( uncompressed, "hello world" ) );
+   Instance rebuild2( uncompressed, "hello world" );
+   ASSERT_EQ( COMPRESSION_NONE, rebuild2.getCompression() );
+   ASSERT_EQ( instance.getEntries(), rebuild2.getEntries() );
+}
+
+TEST( InstanceTest, ConcurrentOpen )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   auto password = []( const std::size_t i )
+   {
+      StringStream s;
+      s << "password " << i;
+      return s.str();
+   };
+
+   // Containers with different passwords.
+   const std::size_t numOfContainers( 4 );
+   Vector<String> dumps;
+   Vector<uint32_t> ids;
+   for ( std::size_t i = 0; i < numOfContainers; ++i )
+   {
+      Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+      Entry entry( "Example Entry" );
+      ASSERT_TRUE( entry.addLabeledData( "password", Data( "password" ) ) );
+      ASSERT_TRUE( instance.addEntry( entry ) );
+
+      StringStream stream;
+      ASSERT_NO_THROW( instance.write( stream, password( i ) ) );
+      dumps.push_back( stream.str() );
+      ids.push_back( instance.getId() );
+
+      // Memory needed to derive the first key is known before opening.
+      StringStream parsed( dumps.back() );
+      ASSERT_EQ( 128U * 8 * ( ( 1U << 10 ) + 1 + 2 ), Instance::parse( parsed ).getMemory() );
+   }
+
+   // Open every container twice at once, with correct and wrong password.
+   Vector<std::shared_ptr<Instance>> opened( 2 * numOfContainers );
+   Vector<String> errors( 2 * numOfContainers );
+   std::vector<std::thread> threads;
+   for ( std::size_t i = 0; i < opened.size(); ++i )
+   {
+      threads.push_back( std::thread( [ &, i ]()
+         {
+            const std::size_t container( i / 2 );
+            const bool correct( i % 2 == 0 );
+            try
+            {
+               StringStream stream( dumps[ container ] );
+               opened[ i ].reset( new Instance( stream, password( correct ? container : container + 1 ) ) );
+            }
+            catch ( std::runtime_error& e )
+            {
+               errors[ i ] = e.what();
+            }
+         } ) );
+   }
+   for ( auto& thread : threads )
+   {
+      thread.join();
+   }
+
+   for ( std::size_t i = 0; i < opened.size(); ++i )
+   {
+      if ( i % 2 == 0 )
+      {
+         ASSERT_TRUE( errors[ i ].empty() );
+         ASSERT_EQ( ids[ i / 2 ], opened[ i ]->getId() );
+
+         Entry entry( *opened[ i ]->getEntries().begin() );
+         ASSERT_NO_THROW( opened[ i ]->decryptEntry( entry, password( i / 2 ) ) );
+         ASSERT_EQ( String( "password" ), entry.getLabeledData().begin()->second.getPlaintext<String>() );
+      }
+      else
+      {
+         ASSERT_FALSE( opened[ i ] );
+         ASSERT_EQ( String( "key is invalid" ), errors[ i ] );
+      }
+   }
+}
+
 } }
@@ -0,0 +1,123 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+#include "types.hpp"
+#include "sesame/Instance.hpp"
+#include "sesame/packaging.hpp"
+#include "sesame/utils/string.hpp"
+
+
+namespace
+{
+   const std::size_t ENTRIES( 10000 );
+   const std::size_t RUNS( 10 );
+
+   template <typename F>
+   void measure( const char* label, F f )
+   {
+      const std::chrono::steady_clock::time_point start( std::chrono::steady_clock::now() );
+      for ( std::size_t i = 0; i < RUNS; ++i )
+      {
+         f();
+      }
+      const std::chrono::duration<double, std::milli> elapsed( std::chrono::steady_clock::now() - start );
+
+      std::cout << std::left << std::setw( 40 ) << label << std::right << std::fixed <<
+         std::setprecision( 2 ) << std::setw( 10 ) << elapsed.count() / RUNS << " ms" << std::endl;
+   }
+}
+
+/**
+ * Benchmarks packing of an instance with 10k entries.
+ */
+int main()
+{
+   using namespace sesame;
+
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   for ( std::size_t i = 0; i < ENTRIES; ++i )
+   {
+      StringStream name;
+      name << "Account " << i;
+      Entry entry( name.str() );
+      entry.addTag( "work" );
+      entry.addAttribute( "user", "john.doe@example.com" );
+      entry.addAttribute( "url", "https://login.example.com/" );
+      instance.addEntry( entry );
+   }
+
+   Vector<uint8_t> v;
+   packV( v, instance );
+   std::cout << "Packing instance with " << ENTRIES << " entries (" << v.size() << " bytes):" << std::endl;
+
+   measure( "StringStream + readIntoVector", [ &instance ]()
+      {
+         StringStream s;
+         pack( s, instance );
+         Vector<uint8_t> tmp;
+         readIntoVector( s, tmp );
+      }
+   );
+   measure( "packV", [ &instance ]()
+      {
+         Vector<uint8_t> tmp;
+         packV( tmp, instance );
+      }
+   );
+   measure( "packV (size hint)", [ &instance, &v ]()
+      {
+         Vector<uint8_t> tmp;
+         packV( tmp, instance, v.size() );
+      }
+   );
+   measure( "isDirty", [ &instance ]()
+      {
+         instance.isDirty();
+      }
+   );
+
+   StringStream s;
+   instance.write( s, "benchmark" );
+   measure( "write (keys cached)", [ &instance ]()
+      {
+         StringStream s;
+         instance.write( s, "benchmark" );
+      }
+   );
+
+   return 0;
+}
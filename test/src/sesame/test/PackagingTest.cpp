@@ -0,0 +1,160 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <cstdint>
+#include "gtest/gtest.h"
+
+#include "types.hpp"
+#include "sesame/crypto/KdfParams.hpp"
+#include "sesame/packaging.hpp"
+#include "sesame/utils/string.hpp"
+#include "sesame/utils/zone.hpp"
+
+
+namespace sesame { namespace test {
+
+TEST( PackagingTest, Vector )
+{
+   Vector<uint8_t> empty;
+   Vector<uint8_t> large( 1000 );
+   for ( std::size_t i = 0; i < large.size(); ++i )
+   {
+      large[ i ] = static_cast<uint8_t>( i );
+   }
+
+   // Payloads span multiple reads from stream.
+   StringStream s;
+   pack( s, empty );
+   pack( s, large );
+   pack( s, empty );
+
+   Vector<uint8_t> v( 3, 0xff );
+   unpack( s, v );
+   ASSERT_TRUE( v.empty() );
+   unpack( s, v );
+   ASSERT_EQ( large, v );
+   unpack( s, v );
+   ASSERT_TRUE( v.empty() );
+   ASSERT_THROW( unpack( s, v ), std::runtime_error );
+
+   Vector<uint8_t> packed;
+   packV( packed, large );
+   Vector<uint8_t> unpacked;
+   unpackV( packed, unpacked );
+   ASSERT_EQ( large, unpacked );
+}
+
+TEST( PackagingTest, String )
+{
+   utils::setLocale();
+
+   String text( utils::fromUtf8( u8"Grüße" ) );
+   Map<String,Vector<uint8_t>> map;
+   map[ text ] = Vector<uint8_t>( 200, 0x2a );
+   map[ String( "empty" ) ] = Vector<uint8_t>();
+
+   StringStream s;
+   pack( s, text );
+   pack( s, map );
+
+   String t;
+   unpack( s, t );
+   ASSERT_EQ( text, t );
+   Map<String,Vector<uint8_t>> m;
+   unpack( s, m );
+   ASSERT_EQ( map, m );
+}
+
+TEST( PackagingTest, SecureZones )
+{
+   utils::setLocale();
+
+   utils::useSecureZones( 4 );
+   const std::size_t free( utils::getNumOfFreeZoneChunks() );
+   ASSERT_LE( 4, free );
+
+   Map<String,Vector<uint8_t>> map;
+   for ( std::size_t i = 0; i < 1000; ++i )
+   {
+      StringStream key;
+      key << "key" << i;
+      map[ key.str() ] = Vector<uint8_t>( 32, static_cast<uint8_t>( i ) );
+   }
+
+   StringStream s;
+   pack( s, map );
+   Map<String,Vector<uint8_t>> m;
+   unpack( s, m );
+   ASSERT_EQ( map, m );
+
+   // Chunks are returned to the arena.
+   ASSERT_LE( free, utils::getNumOfFreeZoneChunks() );
+}
+
+TEST( PackagingTest, KdfParams )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params;
+   params.m_Salt = Vector<uint8_t>( 32, 0x2a );
+   params.m_LdN = 20;
+   params.m_R = 8;
+   params.m_P = 1;
+
+   // Former representation.
+   Map<String,Vector<uint8_t>> map;
+   packV( map[ utils::fromUtf8( u8"salt" ) ], params.m_Salt );
+   packV( map[ utils::fromUtf8( u8"ldN" ) ], params.m_LdN );
+   packV( map[ utils::fromUtf8( u8"r" ) ], params.m_R );
+   packV( map[ utils::fromUtf8( u8"p" ) ], params.m_P );
+
+   // Wire compatible in both directions.
+   Vector<uint8_t> packedParams;
+   packV( packedParams, params );
+   Vector<uint8_t> packedMap;
+   packV( packedMap, map );
+   ASSERT_EQ( packedMap, packedParams );
+
+   crypto::KdfParams unpacked;
+   unpackV( packedMap, unpacked );
+   ASSERT_EQ( params, unpacked );
+
+   // Unset params are omitted.
+   crypto::KdfParams partial;
+   partial.m_LdN = 10;
+   Map<String,Vector<uint8_t>> partialMap;
+   packV( partialMap[ utils::fromUtf8( u8"ldN" ) ], partial.m_LdN );
+   packV( packedParams, partial );
+   packV( packedMap, partialMap );
+   ASSERT_EQ( packedMap, packedParams );
+
+   // Unknown params are rejected.
+   packV( map[ utils::fromUtf8( u8"N" ) ], params.m_LdN );
+   packV( packedMap, map );
+   ASSERT_THROW( unpackV( packedMap, unpacked ), std::runtime_error );
+}
+
+} }
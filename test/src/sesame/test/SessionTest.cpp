@@ -0,0 +1,70 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <memory>
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/definitions.hpp"
+#include "sesame/Instance.hpp"
+#include "sesame/Session.hpp"
+#include "sesame/utils/string.hpp"
+
+
+namespace sesame { namespace test {
+
+TEST( SessionTest, BasicUsage )
+{
+   utils::setLocale();
+
+   std::shared_ptr<Instance> i1( new Instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1 ) );
+   std::shared_ptr<Instance> i2( new Instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1 ) );
+   std::shared_ptr<Instance> i3( new Instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1 ) );
+
+   Session::add( i1 );
+   Session::add( i2 );
+   Session::add( i2 );
+   ASSERT_EQ( 2, Session::getInstances().size() );
+
+   ASSERT_EQ( i1, Session::find( "#" + i1->getIdAsHexString() ) );
+   ASSERT_EQ( i2, Session::find( i2->getIdAsHexString() ) );
+   ASSERT_THROW( Session::find( "" ), std::runtime_error );
+   ASSERT_THROW( Session::find( i3->getIdAsHexString() ), std::runtime_error );
+
+   Session::replace( i1, i3 );
+   ASSERT_EQ( i3, Session::getInstances().front() );
+   ASSERT_THROW( Session::find( i1->getIdAsHexString() ), std::runtime_error );
+
+   ASSERT_EQ( i3, Session::remove( i2 ) );
+   ASSERT_EQ( nullptr, Session::remove( i3 ) );
+   ASSERT_TRUE( Session::getInstances().empty() );
+
+   Session::add( i1 );
+   Session::clear();
+   ASSERT_TRUE( Session::getInstances().empty() );
+}
+
+} }
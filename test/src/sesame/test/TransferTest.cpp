@@ -0,0 +1,205 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <sstream>
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/definitions.hpp"
+#include "sesame/Data.hpp"
+#include "sesame/Entry.hpp"
+#include "sesame/Instance.hpp"
+#include "sesame/transfer.hpp"
+#include "sesame/utils/csv.hpp"
+#include "sesame/utils/json.hpp"
+#include "sesame/utils/string.hpp"
+
+
+namespace sesame { namespace test {
+
+Entry findByName( const Instance& instance, const String& name )
+{
+   for ( const auto& entry : instance.getEntries() )
+   {
+      if ( entry.getName() == name )
+      {
+         return entry;
+      }
+   }
+   throw std::runtime_error( "entry not found" );
+}
+
+TEST( TransferTest, Csv )
+{
+   std::stringstream stream( "a,\"b,c\",\"d\"\"e\"\r\n\"multi\nline\",,x\nlast" );
+   Vector<String> fields;
+
+   ASSERT_TRUE( utils::readCsvRecord( stream, fields ) );
+   ASSERT_EQ( Vector<String>( { "a", "b,c", "d\"e" } ), fields );
+   ASSERT_TRUE( utils::readCsvRecord( stream, fields ) );
+   ASSERT_EQ( Vector<String>( { "multi\nline", "", "x" } ), fields );
+   ASSERT_TRUE( utils::readCsvRecord( stream, fields ) );
+   ASSERT_EQ( Vector<String>( { "last" } ), fields );
+   ASSERT_FALSE( utils::readCsvRecord( stream, fields ) );
+
+   std::stringstream unterminated( "\"open" );
+   ASSERT_THROW( utils::readCsvRecord( unterminated, fields ), std::runtime_error );
+
+   std::ostringstream out;
+   utils::writeCsvRecord( out, { "a", "b,c", "d\"e", "f\ng" } );
+   ASSERT_EQ( "a,\"b,c\",\"d\"\"e\",\"f\ng\"\r\n", out.str() );
+}
+
+TEST( TransferTest, Json )
+{
+   const utils::JsonValue value( utils::parseJson(
+      " {\"a\": [1, -2.5e3, true, false, null], \"b\": \"x\\\"\\u00e4\\ud83d\\ude00\"} " ) );
+
+   ASSERT_EQ( utils::JsonValue::JSON_OBJECT, value.m_Type );
+   const utils::JsonValue* a( value.find( "a" ) );
+   ASSERT_NE( nullptr, a );
+   ASSERT_EQ( 5, a->m_Array.size() );
+   ASSERT_EQ( String( "-2.5e3" ), a->m_Array[ 1 ].m_String );
+   ASSERT_TRUE( a->m_Array[ 2 ].m_Bool );
+   ASSERT_EQ( utils::JsonValue::JSON_NULL, a->m_Array[ 4 ].m_Type );
+   ASSERT_EQ( String( "x\"\xc3\xa4\xf0\x9f\x98\x80" ), value.find( "b" )->m_String );
+   ASSERT_EQ( nullptr, value.find( "c" ) );
+
+   ASSERT_THROW( utils::parseJson( "{\"a\":1,}" ), std::runtime_error );
+   ASSERT_THROW( utils::parseJson( "[1] 2" ), std::runtime_error );
+   ASSERT_THROW( utils::parseJson( "\"\\ud83d\"" ), std::runtime_error );
+   ASSERT_THROW( utils::parseJson( String( 100, '[' ) + String( 100, ']' ) ), std::runtime_error );
+}
+
+TEST( TransferTest, ImportCsv )
+{
+   utils::setLocale();
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1 );
+   std::stringstream csv(
+      "\xef\xbb\xbf\"Group\",\"Title\",\"Username\",\"Password\",\"URL\",\"Notes\"\r\n"
+      "\"Internet\",\"Mail\",\"john\",\"p,w\",\"https://mail\",\"\"\r\n"
+      "\"Work\",\"VPN\",\"\",\"secret\",\"\",\"two\nlines\"\r\n" );
+
+   ASSERT_EQ( 2, importEntries( instance, csv, TRANSFER_CSV ) );
+
+   const Entry mail( findByName( instance, "Mail" ) );
+   ASSERT_EQ( Set<String>( { "Internet" } ), mail.getTags() );
+   ASSERT_EQ( 2, mail.getAttributes().size() );
+   ASSERT_EQ( String( "john" ), mail.getAttributes().at( "Username" ) );
+   ASSERT_EQ( String( "p,w" ), mail.getLabeledData().at( "Password" ).getPlaintext<String>() );
+
+   const Entry vpn( findByName( instance, "VPN" ) );
+   ASSERT_EQ( String( "two\nlines" ), vpn.getAttributes().at( "Notes" ) );
+
+   std::stringstream noName( "user,password\njohn,secret\n" );
+   ASSERT_THROW( importEntries( instance, noName, TRANSFER_CSV ), std::runtime_error );
+   std::stringstream badKey( "name,key:ssh\nx,abc\n" );
+   ASSERT_THROW( importEntries( instance, badKey, TRANSFER_CSV ), std::runtime_error );
+
+   // A bad record after the first batch leaves no entry imported.
+   std::stringstream lateBadKey;
+   lateBadKey << "name,key:ssh\n";
+   for ( std::size_t i = 0; i < 600; ++i )
+   {
+      lateBadKey << "x" << i << ",00ff\n";
+   }
+   lateBadKey << "y,abc\n";
+   ASSERT_THROW( importEntries( instance, lateBadKey, TRANSFER_CSV ), std::runtime_error );
+   ASSERT_EQ( 2, instance.getNumOfEntries() );
+}
+
+TEST( TransferTest, RoundTrip )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   for ( std::size_t i = 0; i < 1000; ++i )
+   {
+      StringStream name;
+      name << "Entry " << i;
+      Entry entry( name.str() );
+      entry.addTag( i % 2 ? "odd" : "even" );
+      entry.addTag( "all;tags" );
+      entry.addAttribute( "user", "john \"doe\"" );
+      ASSERT_TRUE( entry.addLabeledData( "password", Data( name.str() + ",\n" ) ) );
+      ASSERT_TRUE( entry.addLabeledData( "key", Data( Vector<uint8_t>( { 0x00, 0xff, uint8_t( i ) } ) ) ) );
+      ASSERT_TRUE( instance.addEntry( entry ) );
+   }
+
+   // Entries are encrypted and decrypted by several threads.
+   StringStream container;
+   ASSERT_NO_THROW( instance.write( container, "hello world" ) );
+   Instance rebuild( container, "hello world" );
+   ASSERT_NO_THROW( rebuild.decryptEntries( "hello world" ) );
+
+   std::stringstream json;
+   ASSERT_EQ( 1000, exportEntries( rebuild, json, TRANSFER_JSON ) );
+   std::stringstream csv;
+   ASSERT_EQ( 1000, exportEntries( rebuild, csv, TRANSFER_CSV ) );
+
+   for ( const auto format : { TRANSFER_JSON, TRANSFER_CSV } )
+   {
+      Instance copy( PROTOCOL_SCRYPT_AES_CBC_SHA_V1 );
+      std::size_t batches( 0 );
+      ASSERT_EQ( 1000, importEntries(
+                    copy, format == TRANSFER_JSON ? json : csv, format,
+                    [ & ]( std::size_t ) { ++batches; } ) );
+      ASSERT_EQ( 2, batches );
+
+      const Entry entry( findByName( copy, "Entry 7" ) );
+      ASSERT_EQ( String( "john \"doe\"" ), entry.getAttributes().at( "user" ) );
+      ASSERT_EQ( String( "Entry 7,\n" ), entry.getLabeledData().at( "password" ).getPlaintext<String>() );
+      ASSERT_EQ( Vector<uint8_t>( { 0x00, 0xff, 0x07 } ),
+                 entry.getLabeledData().at( "key" ).getPlaintext<Vector<uint8_t>>() );
+      if ( format == TRANSFER_JSON )
+      {
+         ASSERT_EQ( Set<String>( { "odd", "all;tags" } ), entry.getTags() );
+      }
+      else
+      {
+         ASSERT_EQ( Set<String>( { "odd", "all", "tags" } ), entry.getTags() );
+      }
+   }
+
+   // Encrypted entries aren't exported.
+   container.clear();
+   container.seekg( 0 );
+   Instance encrypted( container, "hello world" );
+   std::stringstream out;
+   ASSERT_THROW( exportEntries( encrypted, out, TRANSFER_JSON ), std::runtime_error );
+
+   ASSERT_EQ( TRANSFER_CSV, getTransferFormat( "/tmp/a.CSV" ) );
+   ASSERT_EQ( TRANSFER_JSON, getTransferFormat( "a.jsonl" ) );
+   ASSERT_THROW( getTransferFormat( "a.txt" ), std::runtime_error );
+}
+
+} }
@@ -0,0 +1,184 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/definitions.hpp"
+#include "sesame/Data.hpp"
+#include "sesame/Entry.hpp"
+#include "sesame/Instance.hpp"
+#include "sesame/agent/Agent.hpp"
+#include "sesame/utils/socket.hpp"
+#include "sesame/utils/string.hpp"
+
+
+namespace sesame { namespace test {
+
+namespace
+{
+   std::shared_ptr<Instance> createInstance( String& id )
+   {
+      crypto::KdfParams params1;
+      params1.m_LdN = 10;
+      crypto::KdfParams params2;
+      params2.m_LdN = 8;
+
+      Instance instance( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+
+      Entry e1( "Mail" );
+      e1.addTag( "work" );
+      e1.addAttribute( "user", "jdoe" );
+      e1.addLabeledData( "password", Data( "secret" ) );
+      instance.addEntry( e1 );
+      id = e1.getIdAsHexString();
+
+      Entry e2( "Bank" );
+      e2.addTag( "private" );
+      instance.addEntry( e2 );
+
+      StringStream stream;
+      instance.write( stream, "hello world" );
+      stream.seekg( 0, std::ios_base::beg );
+
+      return std::shared_ptr<Instance>( new Instance( stream, "hello world" ) );
+   }
+}
+
+TEST( AgentTest, Handle )
+{
+   utils::setLocale();
+
+   String id;
+   std::shared_ptr<Instance> instance( createInstance( id ) );
+   ASSERT_THROW( agent::Agent( instance, "wrong" ), std::runtime_error );
+   ASSERT_THROW( agent::Agent agent( instance ), std::runtime_error );
+
+   agent::Agent agent( instance, "hello world" );
+
+   Vector<String> response( agent.handle( { "list" } ) );
+   ASSERT_EQ( 3U, response.size() );
+   ASSERT_EQ( String( "ok" ), response[ 0 ] );
+   ASSERT_NE( String::npos, response[ 1 ].find( "\tBank" ) );
+   ASSERT_EQ( id + "\tMail", response[ 2 ] );
+
+   response = agent.handle( { "search", "^WOR" } );
+   ASSERT_EQ( 2U, response.size() );
+   ASSERT_EQ( id + "\tMail", response[ 1 ] );
+
+   response = agent.handle( { "show", id } );
+   ASSERT_EQ( String( "ok" ), response[ 0 ] );
+   ASSERT_EQ( String( "name\tMail" ), response[ 2 ] );
+   ASSERT_EQ( String( "tag\twork" ), response[ 3 ] );
+   ASSERT_EQ( String( "attribute\tuser\tjdoe" ), response[ 4 ] );
+   ASSERT_EQ( String( "password\tpassword" ), response[ 5 ] );
+
+   response = agent.handle( { "export", id, "#1" } );
+   ASSERT_EQ( 2U, response.size() );
+   ASSERT_EQ( String( "secret" ), response[ 1 ] );
+
+   response = agent.handle( { "export", id, "2" } );
+   ASSERT_EQ( String( "error" ), response[ 0 ] );
+   response = agent.handle( { "search", "(" } );
+   ASSERT_EQ( String( "error" ), response[ 0 ] );
+   response = agent.handle( { "quit" } );
+   ASSERT_EQ( String( "error" ), response[ 0 ] );
+   response = agent.handle( {} );
+   ASSERT_EQ( String( "error" ), response[ 0 ] );
+}
+
+TEST( AgentTest, Unlock )
+{
+   utils::setLocale();
+
+   crypto::KdfParams params1;
+   params1.m_LdN = 10;
+   crypto::KdfParams params2;
+   params2.m_LdN = 8;
+
+   // No encrypted data at all, password is checked anyway.
+   Instance plain( PROTOCOL_SCRYPT_AES_CBC_SHA_V1, params1, params2 );
+   Entry e1( "Bank" );
+   plain.addEntry( e1 );
+
+   StringStream stream;
+   plain.write( stream, "hello world" );
+   stream.seekg( 0, std::ios_base::beg );
+   std::shared_ptr<Instance> instance( new Instance( stream, "hello world" ) );
+
+   ASSERT_FALSE( instance->isUnlocked() );
+   ASSERT_THROW( agent::Agent( instance, "wrong" ), std::runtime_error );
+   ASSERT_FALSE( instance->isUnlocked() );
+   ASSERT_NO_THROW( agent::Agent( instance, "hello world" ) );
+   ASSERT_TRUE( instance->isUnlocked() );
+   ASSERT_NO_THROW( agent::Agent agent( instance ) );
+}
+
+TEST( AgentTest, Socket )
+{
+   utils::setLocale();
+
+   String id;
+   std::shared_ptr<Instance> instance( createInstance( id ) );
+   agent::Agent agent( instance, "hello world" );
+
+   StringStream path;
+   path << "sesame-agent-test-" << getpid();
+
+   bool stopRequested( false );
+   std::thread server( [&]() { agent.serve( path.str(), stopRequested ); } );
+
+   // Wait for socket.
+   Vector<String> response;
+   for ( uint32_t i = 0; i < 100 && response.empty(); ++i )
+   {
+      try
+      {
+         response = agent::Agent::query( path.str(), { "export", id } );
+      }
+      catch ( std::runtime_error& )
+      {
+         std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+      }
+   }
+
+   // Socket of a running agent isn't taken over.
+   ASSERT_THROW( utils::listenOn( path.str() ), std::runtime_error );
+
+   stopRequested = true;
+   server.join();
+
+   ASSERT_EQ( 2U, response.size() );
+   ASSERT_EQ( String( "ok" ), response[ 0 ] );
+   ASSERT_EQ( String( "secret" ), response[ 1 ] );
+   ASSERT_THROW( agent::Agent::query( path.str(), { "list" } ), std::runtime_error );
+}
+
+} }
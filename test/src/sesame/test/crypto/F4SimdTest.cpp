@@ -0,0 +1,169 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "jpeglib.h"
+#include "types.hpp"
+#include "sesame/crypto/F4.hpp"
+#include "sesame/crypto/f4simd.h"
+#include "sesame/utils/filesystem.hpp"
+
+
+namespace sesame { namespace test { namespace crypto {
+
+namespace
+{
+   const f4_simd SIMDS[] = { F4_SIMD_SSE2, F4_SIMD_AVX2 };
+
+   void expectSameMasks( const JCOEF* block )
+   {
+      uint64_t expected[ 3 ];
+      f4_get_block_masks( F4_SIMD_NONE )( block, &expected[ 0 ], &expected[ 1 ], &expected[ 2 ] );
+
+      for ( auto simd : SIMDS )
+      {
+         f4_block_masks_fn fn( f4_get_block_masks( simd ) );
+         if ( fn == nullptr )
+         {
+            continue;
+         }
+
+         uint64_t masks[ 3 ];
+         fn( block, &masks[ 0 ], &masks[ 1 ], &masks[ 2 ] );
+         ASSERT_EQ( expected[ 0 ], masks[ 0 ] ) << "simd " << simd;
+         ASSERT_EQ( expected[ 1 ], masks[ 1 ] ) << "simd " << simd;
+         ASSERT_EQ( expected[ 2 ], masks[ 2 ] ) << "simd " << simd;
+      }
+   }
+
+   Vector<char> readFile( const String& path )
+   {
+      Vector<char> data( sesame::utils::getFileSize( path ) );
+      std::ifstream file( path.c_str(), std::ios_base::in | std::ios_base::binary );
+      file.read( data.data(), data.size() );
+      return data;
+   }
+}
+
+TEST( F4SimdTest, Extremes )
+{
+   const JCOEF values[] = { 0, 1, -1, 2, -2, 3, -3, 32767, -32768, 32766, -32767, 255, -256 };
+   const std::size_t numOfValues( sizeof( values ) / sizeof( values[ 0 ] ) );
+
+   JBLOCK block;
+   for ( std::size_t offset = 0; offset < numOfValues; ++offset )
+   {
+      for ( std::size_t i = 0; i < DCTSIZE2; ++i )
+      {
+         block[ i ] = values[ ( i + offset ) % numOfValues ];
+      }
+      expectSameMasks( block );
+   }
+
+   std::srand( 42 );
+   for ( std::size_t round = 0; round < 10000; ++round )
+   {
+      for ( std::size_t i = 0; i < DCTSIZE2; ++i )
+      {
+         block[ i ] = static_cast<JCOEF>( ( std::rand() % 7 ) - 3 ) * ( ( round % 3 ) + 1 );
+      }
+      expectSameMasks( block );
+   }
+}
+
+TEST( F4SimdTest, TuxCoefficients )
+{
+   struct jpeg_decompress_struct info;
+   struct jpeg_error_mgr err;
+
+   info.err = jpeg_std_error( &err );
+   jpeg_create_decompress( &info );
+
+   FILE* file( fopen( F4_TEST_IMAGE, "rb" ) );
+   ASSERT_TRUE( file != nullptr );
+   jpeg_stdio_src( &info, file );
+   jpeg_read_header( &info, TRUE );
+   jvirt_barray_ptr* arrays( jpeg_read_coefficients( &info ) );
+
+   for ( int c = 0; c < info.num_components; ++c )
+   {
+      jpeg_component_info* component( info.comp_info + c );
+      for ( JDIMENSION row = 0; row < component->height_in_blocks; ++row )
+      {
+         JBLOCKARRAY blocks( ( *info.mem->access_virt_barray )(
+            reinterpret_cast<j_common_ptr>( &info ), arrays[ c ], row, 1, FALSE ) );
+         for ( JDIMENSION block = 0; block < component->width_in_blocks; ++block )
+         {
+            expectSameMasks( blocks[ 0 ][ block ] );
+         }
+      }
+   }
+
+   jpeg_finish_decompress( &info );
+   jpeg_destroy_decompress( &info );
+   fclose( file );
+}
+
+TEST( F4SimdTest, TuxEmbedding )
+{
+   Vector<char> cover( readFile( F4_TEST_IMAGE ) );
+   Vector<char> data( 4000 );
+   std::srand( 7 );
+   for ( auto& c : data )
+   {
+      c = static_cast<char>( std::rand() >> 8 );
+   }
+
+   sesame::crypto::F4 algo;
+   Vector<char> expected;
+
+   ASSERT_EQ( F4_SIMD_NONE, f4_select_simd( F4_SIMD_NONE ) );
+   algo.embed( cover, expected, data );
+
+   for ( auto simd : SIMDS )
+   {
+      if ( f4_select_simd( simd ) != simd )
+      {
+         continue;
+      }
+
+      // Same image and same data extracted.
+      Vector<char> image;
+      algo.embed( cover, image, data );
+      ASSERT_EQ( expected, image ) << "simd " << simd;
+
+      Vector<char> result;
+      algo.extract( image, result );
+      ASSERT_EQ( data, result ) << "simd " << simd;
+   }
+
+   f4_select_simd( F4_SIMD_AVX2 );
+}
+
+
+} } }
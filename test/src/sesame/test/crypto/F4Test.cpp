@@ -23,15 +23,119 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include "gtest/gtest.h"
+#include "jpeglib.h"
 #include "types.hpp"
 #include "sesame/crypto/F4.hpp"
+#include "sesame/crypto/jpegtranf4.h"
 #include "sesame/utils/filesystem.hpp"
 
 
 namespace sesame { namespace test { namespace crypto {
 
+namespace
+{
+   Vector<char> genData( std::size_t length )
+   {
+      Vector<char> data( length );
+      for ( std::size_t i = 0; i < length; ++i )
+      {
+         data[ i ] = static_cast<char>( ( i * 131 ) ^ ( i >> 3 ) );
+      }
+
+      return data;
+   }
+
+   // Lossless transcoding into a progressive JPEG (like jpegtran -progressive).
+   void makeProgressive( const String& fileNameIn, const String& fileNameOut )
+   {
+      struct jpeg_decompress_struct srcinfo;
+      struct jpeg_compress_struct dstinfo;
+      struct jpeg_error_mgr jsrcerr, jdsterr;
+
+      srcinfo.err = jpeg_std_error( &jsrcerr );
+      jpeg_create_decompress( &srcinfo );
+      dstinfo.err = jpeg_std_error( &jdsterr );
+      jpeg_create_compress( &dstinfo );
+
+      FILE* in( fopen( fileNameIn.c_str(), "rb" ) );
+      FILE* out( fopen( fileNameOut.c_str(), "wb" ) );
+      ASSERT_TRUE( in != nullptr );
+      ASSERT_TRUE( out != nullptr );
+
+      jpeg_stdio_src( &srcinfo, in );
+      jpeg_read_header( &srcinfo, TRUE );
+      jvirt_barray_ptr* coefArrays( jpeg_read_coefficients( &srcinfo ) );
+
+      jpeg_copy_critical_parameters( &srcinfo, &dstinfo );
+      jpeg_simple_progression( &dstinfo );
+      jpeg_stdio_dest( &dstinfo, out );
+      jpeg_write_coefficients( &dstinfo, coefArrays );
+
+      jpeg_finish_compress( &dstinfo );
+      jpeg_destroy_compress( &dstinfo );
+      jpeg_finish_decompress( &srcinfo );
+      jpeg_destroy_decompress( &srcinfo );
+
+      fclose( out );
+      fclose( in );
+   }
+
+   // Number of coefficients (first component) differing between both images.
+   std::size_t countChanges( const String& fileNameA, const String& fileNameB )
+   {
+      struct jpeg_decompress_struct infoA, infoB;
+      struct jpeg_error_mgr errA, errB;
+
+      infoA.err = jpeg_std_error( &errA );
+      jpeg_create_decompress( &infoA );
+      infoB.err = jpeg_std_error( &errB );
+      jpeg_create_decompress( &infoB );
+
+      FILE* a( fopen( fileNameA.c_str(), "rb" ) );
+      FILE* b( fopen( fileNameB.c_str(), "rb" ) );
+
+      jpeg_stdio_src( &infoA, a );
+      jpeg_read_header( &infoA, TRUE );
+      jvirt_barray_ptr* arraysA( jpeg_read_coefficients( &infoA ) );
+      jpeg_stdio_src( &infoB, b );
+      jpeg_read_header( &infoB, TRUE );
+      jvirt_barray_ptr* arraysB( jpeg_read_coefficients( &infoB ) );
+
+      std::size_t changes( 0 );
+      jpeg_component_info* component( infoA.comp_info );
+      for ( JDIMENSION row = 0; row < component->height_in_blocks; ++row )
+      {
+         JBLOCKARRAY blocksA( ( *infoA.mem->access_virt_barray )(
+            reinterpret_cast<j_common_ptr>( &infoA ), arraysA[ 0 ], row, 1, FALSE ) );
+         JBLOCKARRAY blocksB( ( *infoB.mem->access_virt_barray )(
+            reinterpret_cast<j_common_ptr>( &infoB ), arraysB[ 0 ], row, 1, FALSE ) );
+         for ( JDIMENSION block = 0; block < component->width_in_blocks; ++block )
+         {
+            for ( std::size_t i = 0; i < DCTSIZE2; ++i )
+            {
+               changes += ( blocksA[ 0 ][ block ][ i ] != blocksB[ 0 ][ block ][ i ] ) ? 1 : 0;
+            }
+         }
+      }
+
+      jpeg_finish_decompress( &infoA );
+      jpeg_destroy_decompress( &infoA );
+      jpeg_finish_decompress( &infoB );
+      jpeg_destroy_decompress( &infoB );
+
+      fclose( b );
+      fclose( a );
+
+      return changes;
+   }
+}
+
 TEST( F4Test, BasicUsage )
 {
    String s1( "Hello, world!" );
@@ -57,5 +161,284 @@ TEST( F4Test, BasicUsage )
    }
 }
 
+TEST( F4Test, ExactLength )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+
+   for ( std::size_t length : { 1, 7, 8, 9, 1000, 4096 } )
+   {
+      Vector<char> data( genData( length ) );
+
+      sesame::crypto::F4 algo;
+      algo.embed( in, out, data );
+
+      Vector<char> result;
+      algo.extract( out, result );
+      ASSERT_EQ( data, result );
+   }
+}
+
+TEST( F4Test, Progressive )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+   String progressive( sesame::utils::incrementFileName( out ) );
+   Vector<char> data( genData( 2000 ) );
+
+   sesame::crypto::F4 algo;
+   algo.embed( in, out, data );
+   makeProgressive( out, progressive );
+
+   // Coefficients are complete only after the last scan.
+   Vector<char> result;
+   algo.extract( progressive, result );
+   ASSERT_EQ( data, result );
+}
+
+TEST( F4Test, WithoutHeader )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+   Vector<char> data( genData( 3000 ) );
+
+   // Embed data like older versions did, without header.
+   ASSERT_EQ( 0, f4_embed( in.c_str(), out.c_str(), data.data(), data.size() ) );
+
+   sesame::crypto::F4 algo;
+   Vector<char> result;
+   algo.extract( out, result );
+
+   ASSERT_EQ( sesame::utils::getFileSize( out ) / 5, result.size() );
+   ASSERT_TRUE( std::equal( data.begin(), data.end(), result.begin() ) );
+}
+
+TEST( F4Test, Capacity )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+
+   sesame::crypto::F4 algo;
+   std::size_t capacity( algo.getCapacity( in ) );
+   ASSERT_TRUE( capacity > 0 );
+
+   // Random data close to estimated capacity fits, twice as much doesn't.
+   Vector<char> data( capacity * 9 / 10 );
+   for ( auto& c : data )
+   {
+      c = static_cast<char>( std::rand() );
+   }
+   algo.embed( in, out, data );
+
+   Vector<char> result;
+   algo.extract( out, result );
+   ASSERT_EQ( data, result );
+
+   data.resize( capacity * 2 );
+   ASSERT_THROW( algo.embed( in, out, data ), std::runtime_error );
+
+   ASSERT_THROW( algo.getCapacity( in + ".missing" ), std::runtime_error );
+}
+
+TEST( F4Test, InMemory )
+{
+   String in( F4_TEST_IMAGE );
+   Vector<char> image( sesame::utils::getFileSize( in ) );
+   {
+      std::ifstream file( in.c_str(), std::ios_base::in | std::ios_base::binary );
+      ASSERT_TRUE( file.read( image.data(), image.size() ).good() );
+   }
+
+   sesame::crypto::F4 algo;
+   Vector<char> data( genData( 1500 ) );
+   Vector<char> stego;
+   algo.embed( image, stego, data );
+
+   Vector<char> result;
+   algo.extract( stego, result );
+   ASSERT_EQ( data, result );
+
+   // Same result as embedding into the file.
+   String out( sesame::utils::incrementFileName( in ) );
+   algo.embed( in, out, data );
+   Vector<char> written( sesame::utils::getFileSize( out ) );
+   {
+      std::ifstream file( out.c_str(), std::ios_base::in | std::ios_base::binary );
+      ASSERT_TRUE( file.read( written.data(), written.size() ).good() );
+   }
+   ASSERT_EQ( stego, written );
+
+   Vector<char> invalid( 1000, 'x' );
+   ASSERT_THROW( algo.embed( invalid, stego, data ), std::runtime_error );
+}
+
+TEST( F4Test, CachedCover )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+   sesame::crypto::F4 algo;
+
+   // Embedding again into the cached cover must not see earlier data.
+   Vector<char> first( genData( 4000 ) );
+   Vector<char> second( 10, 'x' );
+   Vector<char> result;
+
+   algo.embed( in, out, first );
+   algo.embed( in, out, second );
+   algo.extract( out, result );
+   ASSERT_EQ( second, result );
+
+   sesame::crypto::F4::clearCache();
+   algo.embed( in, out, first );
+   algo.extract( out, result );
+   ASSERT_EQ( first, result );
+}
+
+TEST( F4Test, MatrixEncoding )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+   Vector<char> data( 200 );
+   for ( auto& c : data )
+   {
+      c = static_cast<char>( std::rand() >> 8 );
+   }
+
+   std::size_t lastCapacity( 0 );
+   std::size_t lastChanges( 0 );
+
+   for ( int k = 1; k <= F4_MAX_K; ++k )
+   {
+      sesame::crypto::F4 algo( k );
+      algo.embed( in, out, data );
+
+      Vector<char> result;
+      algo.extract( out, result );
+      ASSERT_EQ( data, result ) << "k " << k;
+
+      // Less capacity, but fewer changes.
+      std::size_t capacity( algo.getCapacity( in ) );
+      std::size_t changes( countChanges( in, out ) );
+      if ( k > 1 )
+      {
+         ASSERT_LT( capacity, lastCapacity ) << "k " << k;
+         ASSERT_LT( changes, lastChanges ) << "k " << k;
+      }
+      lastCapacity = capacity;
+      lastChanges = changes;
+
+      // Random data close to estimated capacity fits.
+      Vector<char> full( capacity * 9 / 10 );
+      for ( auto& c : full )
+      {
+         c = static_cast<char>( std::rand() >> 8 );
+      }
+      algo.embed( in, out, full );
+      algo.extract( out, result );
+      ASSERT_EQ( full, result ) << "k " << k;
+   }
+
+   ASSERT_THROW( sesame::crypto::F4( F4_MAX_K + 1 ), std::runtime_error );
+   ASSERT_THROW( sesame::crypto::F4( -1 ), std::runtime_error );
+}
+
+TEST( F4Test, MatrixEncodingAuto )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+   sesame::crypto::F4 plain;
+   sesame::crypto::F4 algo( sesame::crypto::F4::AUTO );
+
+   // Plain F4 capacity is the maximum, auto falls back to it.
+   ASSERT_EQ( plain.getCapacity( in ), algo.getCapacity( in ) );
+
+   for ( std::size_t length : { std::size_t( 100 ), plain.getCapacity( in ) * 9 / 10 } )
+   {
+      Vector<char> data( length );
+      for ( auto& c : data )
+      {
+         c = static_cast<char>( std::rand() >> 8 );
+      }
+
+      plain.embed( in, out, data );
+      std::size_t changes( countChanges( in, out ) );
+
+      algo.embed( in, out, data );
+      Vector<char> result;
+      algo.extract( out, result );
+      ASSERT_EQ( data, result );
+      ASSERT_LE( countChanges( in, out ), changes );
+   }
+}
+
+TEST( F4Test, MultipleCarriers )
+{
+   String in( F4_TEST_IMAGE );
+   Vector<char> image( sesame::utils::getFileSize( in ) );
+   {
+      std::ifstream file( in.c_str(), std::ios_base::in | std::ios_base::binary );
+      ASSERT_TRUE( file.read( image.data(), image.size() ).good() );
+   }
+
+   Vector<String> carriers;
+   Vector<String> carriersOut;
+   for ( auto name : { "a", "b", "c" } )
+   {
+      carriers.push_back( in + "." + name + ".jpg" );
+      sesame::utils::writeFile( carriers.back(), image.data(), image.size() );
+      carriersOut.push_back( sesame::utils::incrementFileName( carriers.back() ) );
+   }
+
+   sesame::crypto::F4 algo;
+   const std::size_t capacity( algo.getCapacity( in ) );
+   ASSERT_TRUE( algo.getCapacity( carriers ) > capacity * 2 );
+
+   // Too much data for a single image.
+   Vector<char> data( capacity * 2 );
+   for ( auto& c : data )
+   {
+      c = static_cast<char>( std::rand() >> 8 );
+   }
+   ASSERT_THROW( algo.embed( in, carriersOut[ 0 ], data ), std::runtime_error );
+   algo.embed( carriers, carriersOut, data );
+
+   // Order of carriers doesn't matter.
+   Vector<char> result;
+   algo.extract( carriersOut, result );
+   ASSERT_EQ( data, result );
+   std::reverse( carriersOut.begin(), carriersOut.end() );
+   algo.extract( carriersOut, result );
+   ASSERT_EQ( data, result );
+
+   // All parts of the same container are needed.
+   ASSERT_THROW( algo.extract( carriersOut[ 0 ], result ), std::runtime_error );
+   Vector<String> incomplete( carriersOut.begin(), carriersOut.begin() + 2 );
+   ASSERT_THROW( algo.extract( incomplete, result ), std::runtime_error );
+
+   Vector<String> other( carriers.begin(), carriers.begin() + 2 );
+   Vector<String> otherOut( incomplete );
+   algo.embed( other, otherOut, genData( 100 ) );
+   ASSERT_THROW( algo.extract( carriersOut, result ), std::runtime_error );
+
+   data.resize( capacity * 4 );
+   ASSERT_THROW( algo.embed( carriers, carriersOut, data ), std::runtime_error );
+}
+
+TEST( F4Test, InvalidHeader )
+{
+   String in( F4_TEST_IMAGE );
+   String out( sesame::utils::incrementFileName( in ) );
+
+   // Header announcing more data than the image can carry.
+   Vector<char> data( genData( 64 ) );
+   std::memcpy( data.data(), F4_MAGIC, F4_MAGIC_SIZE );
+   std::memset( data.data() + F4_MAGIC_SIZE, 0x7f, 4 );
+   ASSERT_EQ( 0, f4_embed( in.c_str(), out.c_str(), data.data(), data.size() ) );
+
+   sesame::crypto::F4 algo;
+   Vector<char> result;
+   ASSERT_THROW( algo.extract( out, result ), std::runtime_error );
+}
+
 
 } } }
@@ -203,4 +203,28 @@ TEST( ScryptAesCbcShaV1MachineTest, Hmac )
    std::cout << "hmac3: " << hmac2 << std::endl;
 }
 
+TEST( ScryptAesCbcShaV1MachineTest, KdfMemory )
+{
+   sesame::crypto::ScryptAesCbcShaV1Machine machine;
+
+   // 128 * r * ( N + p + 2 ) bytes.
+   sesame::crypto::KdfParams params;
+   params.m_LdN = 10;
+   params.m_R = 1;
+   params.m_P = 1;
+   ASSERT_EQ( 128U * 1 * ( 1024 + 1 + 2 ), params.getMemory() );
+   params.m_P = 4;
+   ASSERT_EQ( 128U * 1 * ( 1024 + 4 + 2 ), params.getMemory() );
+
+   // Defaults (r = 8, p = 1) count, too.
+   params = sesame::crypto::KdfParams();
+   params.m_LdN = 19;
+   ASSERT_TRUE( machine.getKeyDerivationParams( params ) );
+   ASSERT_EQ( 128ULL * 8 * ( ( 1ULL << 19 ) + 1 + 2 ), params.getMemory() );
+
+   // No overflow for big N.
+   params.m_LdN = 40;
+   ASSERT_EQ( 128ULL * 8 * ( ( 1ULL << 40 ) + 1 + 2 ), params.getMemory() );
+}
+
 } } }
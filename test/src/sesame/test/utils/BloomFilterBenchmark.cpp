@@ -0,0 +1,123 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "types.hpp"
+#include "sesame/utils/BloomFilter.hpp"
+#include "sesame/utils/resources.hpp"
+
+
+namespace
+{
+   const std::size_t WORDS( 1000000 );
+   const std::size_t PROBES( 1000000 );
+
+   double elapsed( const std::chrono::steady_clock::time_point& start )
+   {
+      return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+   }
+
+   void report( const char* label, const double value, const char* unit )
+   {
+      std::cout << std::left << std::setw( 40 ) << label << std::right << std::fixed <<
+         std::setprecision( 4 ) << std::setw( 12 ) << value << " " << unit << std::endl;
+   }
+
+   // Resident memory in kB (VmRSS), 0 if unknown.
+   double getResident()
+   {
+      std::ifstream status( "/proc/self/status" );
+      std::string key;
+      double value;
+      while ( status >> key )
+      {
+         if ( key == "VmRSS:" && status >> value )
+         {
+            return value;
+         }
+      }
+      return 0;
+   }
+}
+
+/**
+ * Benchmarks loading and probing a filter of 1M words (default rate),
+ * with memory locked like sesame (if permitted).
+ */
+int main()
+{
+   using namespace sesame;
+
+   report( "memory locked", utils::lockMemory() ? 1 : 0, "" );
+
+   const String list( "/tmp/sesame_bloom_benchmark.txt" );
+   const String path( list + ".bloom" );
+   {
+      std::ofstream out( list.c_str() );
+      for ( std::size_t i = 0; i < WORDS; ++i )
+      {
+         out << "breached" << i << "\n";
+      }
+   }
+
+   std::chrono::steady_clock::time_point start( std::chrono::steady_clock::now() );
+   utils::BloomFilter::build( list, path );
+   report( "build", elapsed( start ), "ms" );
+
+   const double resident( getResident() );
+   start = std::chrono::steady_clock::now();
+   const utils::BloomFilter filter( path );
+   report( "load", elapsed( start ), "ms" );
+   report( "resident after load", getResident() - resident, "kB" );
+
+   Vector<String> words;
+   for ( std::size_t i = 0; i < PROBES; ++i )
+   {
+      StringStream word;
+      word << "fresh" << i;
+      words.push_back( word.str() );
+   }
+
+   std::size_t falsePositives( 0 );
+   start = std::chrono::steady_clock::now();
+   for ( const auto& word : words )
+   {
+      falsePositives += filter.contains( word ) ? 1 : 0;
+   }
+   report( "probe", elapsed( start ) * 1000000.0 / PROBES, "ns" );
+   report( "false positive rate", static_cast<double>( falsePositives ) / PROBES, "" );
+
+   unlink( list.c_str() );
+   unlink( path.c_str() );
+
+   return 0;
+}
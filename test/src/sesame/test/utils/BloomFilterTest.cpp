@@ -0,0 +1,108 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/utils/BloomFilter.hpp"
+
+
+namespace sesame { namespace test {
+
+String createWordList( const String& prefix, const std::size_t count )
+{
+   char name[] = "/tmp/sesame_bloom_test.XXXXXX";
+   const int fd( mkstemp( name ) );
+   EXPECT_NE( -1, fd );
+   close( fd );
+
+   std::ofstream list( name );
+   for ( std::size_t i = 0; i < count; ++i )
+   {
+      list << prefix << i << ( i % 2 ? "\r\n" : "\n\n" );
+   }
+
+   return String( name );
+}
+
+TEST( BloomFilterTest, ContainsInsertedWords )
+{
+   const String list( createWordList( "password", 1000 ) );
+   const String path( list + ".bloom" );
+
+   ASSERT_EQ( 1000u, utils::BloomFilter::build( list, path ) );
+
+   const utils::BloomFilter filter( path );
+   ASSERT_EQ( 1000u, filter.getWordCount() );
+   ASSERT_EQ( 13u, filter.getHashCount() );
+   for ( std::size_t i = 0; i < 1000; ++i )
+   {
+      StringStream word;
+      word << "password" << i;
+      ASSERT_TRUE( filter.contains( word.str() ) );
+   }
+   ASSERT_FALSE( filter.contains( "" ) );
+
+   unlink( list.c_str() );
+   unlink( path.c_str() );
+}
+
+TEST( BloomFilterTest, FalsePositiveRate )
+{
+   const String list( createWordList( "breached", 100000 ) );
+   const String path( list + ".bloom" );
+
+   ASSERT_EQ( 100000u, utils::BloomFilter::build( list, path, 0.01 ) );
+
+   const utils::BloomFilter filter( path );
+   std::size_t falsePositives( 0 );
+   for ( std::size_t i = 0; i < 100000; ++i )
+   {
+      StringStream word;
+      word << "fresh" << i;
+      falsePositives += filter.contains( word.str() ) ? 1 : 0;
+   }
+   ASSERT_LT( falsePositives, 1500u );
+
+   unlink( list.c_str() );
+   unlink( path.c_str() );
+}
+
+TEST( BloomFilterTest, RejectsInvalidFilter )
+{
+   const String list( createWordList( "word", 10 ) );
+
+   ASSERT_THROW( utils::BloomFilter filter( list ), std::runtime_error );
+   ASSERT_THROW( utils::BloomFilter filter( list + ".missing" ), std::runtime_error );
+   ASSERT_THROW( utils::BloomFilter::build( list, list + ".bloom", 0.0 ), std::runtime_error );
+
+   unlink( list.c_str() );
+}
+
+} }
@@ -0,0 +1,114 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/utils/filesystem.hpp"
+
+
+namespace sesame { namespace test {
+
+String readFile( const String& path )
+{
+   std::ifstream file( path.c_str(), std::ios_base::in | std::ios_base::binary );
+   return String( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+String createDirectory()
+{
+   char name[] = "/tmp/sesame_fs_test.XXXXXX";
+   EXPECT_NE( nullptr, mkdtemp( name ) );
+   return String( name );
+}
+
+TEST( FilesystemTest, GetDirectory )
+{
+   ASSERT_EQ( String( "." ), utils::getDirectory( "file.bin" ) );
+   ASSERT_EQ( String( "/" ), utils::getDirectory( "/file.bin" ) );
+   ASSERT_EQ( String( "/tmp/a" ), utils::getDirectory( "/tmp/a/file.bin" ) );
+   ASSERT_EQ( String( "a" ), utils::getDirectory( "a/file.bin" ) );
+}
+
+TEST( FilesystemTest, WriteFile )
+{
+   const String directory( createDirectory() );
+   const String path( directory + "/container.bin" );
+
+   const String first( "first version" );
+   utils::writeFile( path, first.data(), first.size() );
+   ASSERT_TRUE( utils::isFile( path ) );
+   ASSERT_EQ( first, readFile( path ) );
+
+   const String second( "second version, a bit longer" );
+   utils::writeFile( path, second.data(), second.size() );
+   ASSERT_EQ( second, readFile( path ) );
+
+   // No backups requested, no backups written.
+   ASSERT_FALSE( utils::exists( utils::getBackupFileName( path, 1 ) ) );
+
+   ASSERT_TRUE( utils::removeFile( path ) );
+   ASSERT_EQ( 0, rmdir( directory.c_str() ) );
+}
+
+TEST( FilesystemTest, WriteFileWithBackups )
+{
+   const String directory( createDirectory() );
+   const String path( directory + "/container.bin" );
+
+   for ( char version = '1'; version <= '5'; ++version )
+   {
+      const String content( 1, version );
+      utils::writeFile( path, content.data(), content.size(), 3 );
+   }
+
+   ASSERT_EQ( String( "5" ), readFile( path ) );
+   ASSERT_EQ( String( "4" ), readFile( utils::getBackupFileName( path, 1 ) ) );
+   ASSERT_EQ( String( "3" ), readFile( utils::getBackupFileName( path, 2 ) ) );
+   ASSERT_EQ( String( "2" ), readFile( utils::getBackupFileName( path, 3 ) ) );
+   ASSERT_FALSE( utils::exists( utils::getBackupFileName( path, 4 ) ) );
+
+   for ( std::size_t i = 1; i <= 3; ++i )
+   {
+      ASSERT_TRUE( utils::removeFile( utils::getBackupFileName( path, i ) ) );
+   }
+   ASSERT_TRUE( utils::removeFile( path ) );
+   ASSERT_EQ( 0, rmdir( directory.c_str() ) );
+}
+
+TEST( FilesystemTest, WriteFileFailsOnDirectory )
+{
+   const String directory( createDirectory() );
+   const String content( "content" );
+
+   ASSERT_THROW( utils::writeFile( directory, content.data(), content.size() ), std::runtime_error );
+
+   ASSERT_EQ( 0, rmdir( directory.c_str() ) );
+}
+
+} }
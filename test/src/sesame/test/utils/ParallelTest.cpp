@@ -0,0 +1,163 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/utils/parallel.hpp"
+
+
+namespace sesame { namespace test {
+
+namespace
+{
+   /** Tracks the costs of items processed at the same time. */
+   struct Usage
+   {
+      Usage() : m_Spent( 0 ), m_MaxSpent( 0 ), m_Running( 0 ) {}
+
+      void start( const uint64_t cost, const std::size_t index )
+      {
+         std::lock_guard<std::mutex> lock( m_Mutex );
+         m_Spent += cost;
+         m_MaxSpent = std::max( m_MaxSpent, m_Spent );
+         ++m_Running;
+         m_Started.push_back( index );
+         m_Alone.push_back( m_Running == 1 );
+      }
+
+      void stop( const uint64_t cost )
+      {
+         std::lock_guard<std::mutex> lock( m_Mutex );
+         m_Spent -= cost;
+         --m_Running;
+      }
+
+      std::mutex m_Mutex;
+      uint64_t m_Spent;
+      uint64_t m_MaxSpent;
+      std::size_t m_Running;
+      Vector<std::size_t> m_Started;
+      Vector<bool> m_Alone;
+   };
+
+   struct Item
+   {
+      std::size_t m_Index;
+      uint64_t m_Cost;
+   };
+
+   Vector<Item> createItems( const Vector<uint64_t>& costs )
+   {
+      Vector<Item> items;
+      for ( std::size_t i = 0; i < costs.size(); ++i )
+      {
+         items.push_back( { i, costs[ i ] } );
+      }
+      return items;
+   }
+}
+
+TEST( ParallelTest, Budget )
+{
+   Vector<Item> items( createItems( { 3, 1, 4, 1, 5, 2, 6, 5, 3, 5, 1, 2, 4, 1, 3, 2 } ) );
+   Usage usage;
+
+   utils::runBudgeted(
+      items,
+      [ & ]( Item& item )
+      {
+         usage.start( item.m_Cost, item.m_Index );
+         std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+         usage.stop( item.m_Cost );
+      },
+      []( const Item& item ) { return item.m_Cost; },
+      6 );
+
+   ASSERT_LE( usage.m_MaxSpent, 6U );
+   ASSERT_EQ( 0U, usage.m_Spent );
+
+   // Started in order, cheaper items don't overtake.
+   ASSERT_EQ( items.size(), usage.m_Started.size() );
+   for ( std::size_t i = 0; i < items.size(); ++i )
+   {
+      ASSERT_EQ( i, usage.m_Started[ i ] );
+   }
+}
+
+TEST( ParallelTest, OverBudget )
+{
+   Vector<Item> items( createItems( { 1, 1, 10, 1, 1, 12, 1 } ) );
+   Usage usage;
+
+   utils::runBudgeted(
+      items,
+      [ & ]( Item& item )
+      {
+         usage.start( item.m_Cost, item.m_Index );
+         std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+         usage.stop( item.m_Cost );
+      },
+      []( const Item& item ) { return item.m_Cost; },
+      4 );
+
+   // Items costing more than the budget run (alone).
+   ASSERT_EQ( items.size(), usage.m_Started.size() );
+   ASSERT_TRUE( usage.m_Alone[ 2 ] );
+   ASSERT_TRUE( usage.m_Alone[ 5 ] );
+   ASSERT_EQ( 12U, usage.m_MaxSpent );
+}
+
+TEST( ParallelTest, Error )
+{
+   Vector<Item> items( createItems( Vector<uint64_t>( 64, 1 ) ) );
+   Usage usage;
+
+   ASSERT_THROW(
+      utils::runBudgeted(
+         items,
+         [ & ]( Item& item )
+         {
+            usage.start( item.m_Cost, item.m_Index );
+            usage.stop( item.m_Cost );
+            if ( item.m_Index == 7 )
+            {
+               throw std::runtime_error( "failed" );
+            }
+         },
+         []( const Item& item ) { return item.m_Cost; },
+         2 ),
+      std::runtime_error );
+
+   // No more items are handed out after the error.
+   ASSERT_LT( usage.m_Started.size(), items.size() );
+   ASSERT_EQ( 0U, usage.m_Running );
+}
+
+} }
@@ -0,0 +1,97 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <algorithm>
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/utils/passwords.hpp"
+
+
+namespace sesame { namespace test {
+
+bool containsAnyOf( const String& password, const char* symbols )
+{
+   return password.find_first_of( symbols ) != String::npos;
+}
+
+TEST( PasswordsTest, GenerateRandom )
+{
+   ApgParams params;
+   params.minLength = 12;
+   params.maxLength = 20;
+
+   const Vector<String> passwords( utils::generatePasswords( params, 10000 ) );
+   ASSERT_EQ( 10000u, passwords.size() );
+
+   for ( const auto& password : passwords )
+   {
+      ASSERT_LE( 12u, password.size() );
+      ASSERT_GE( 20u, password.size() );
+      ASSERT_TRUE( containsAnyOf( password, "0123456789" ) );
+      ASSERT_TRUE( containsAnyOf( password, "abcdefghijklmnopqrstuvwxyz" ) );
+      ASSERT_TRUE( containsAnyOf( password, "ABCDEFGHIJKLMNOPQRSTUVWXYZ" ) );
+   }
+
+   // Workers must not share generator state.
+   Vector<String> sorted( passwords );
+   std::sort( sorted.begin(), sorted.end() );
+   ASSERT_EQ( sorted.end(), std::adjacent_find( sorted.begin(), sorted.end() ) );
+}
+
+TEST( PasswordsTest, GeneratePronounceable )
+{
+   ApgParams params;
+   params.algorithm = 0;
+   params.mode = "l";
+   params.minLength = 8;
+   params.maxLength = 8;
+
+   const Vector<String> passwords( utils::generatePasswords( params, 1000 ) );
+   for ( const auto& password : passwords )
+   {
+      ASSERT_EQ( 8u, password.size() );
+      ASSERT_EQ( String::npos, password.find_first_not_of( "abcdefghijklmnopqrstuvwxyz" ) );
+   }
+}
+
+TEST( PasswordsTest, InvalidParams )
+{
+   ApgParams params;
+   params.mode = "X";
+   ASSERT_THROW( utils::generatePasswords( params, 1 ), std::runtime_error );
+
+   params.mode = "SNCL";
+   params.minLength = 3;
+   params.maxLength = 3;
+   ASSERT_THROW( utils::generatePasswords( params, 1 ), std::runtime_error );
+
+   params.minLength = 10;
+   params.maxLength = 9;
+   ASSERT_THROW( utils::generatePasswords( params, 1 ), std::runtime_error );
+}
+
+} }
@@ -0,0 +1,96 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "sesame/utils/string.hpp"
+#include "sesame/utils/Reader.hpp"
+
+
+namespace sesame { namespace test {
+
+namespace
+{
+   // Batch mode is process wide, leave it after each test.
+   class ReaderTest : public ::testing::Test
+   {
+      protected:
+         virtual void TearDown()
+         {
+            utils::Reader::resetBatchMode();
+         }
+   };
+}
+
+TEST_F( ReaderTest, BatchMode )
+{
+   utils::setLocale();
+
+   int fds[ 2 ];
+   ASSERT_EQ( 0, pipe( fds ) );
+   ASSERT_EQ( 17, write( fds[ 1 ], " hello world\nrest", 17 ) );
+   close( fds[ 1 ] );
+
+   std::istringstream script( "add\nExample\n" );
+   ASSERT_FALSE( utils::Reader::isBatchMode() );
+   utils::Reader::setBatchMode( script, fds[ 0 ] );
+   close( fds[ 0 ] );
+   ASSERT_TRUE( utils::Reader::isBatchMode() );
+
+   utils::Reader reader( 1024 );
+   ASSERT_EQ( String( "add" ), reader.readLine( "" ) );
+   ASSERT_EQ( String( "hello world" ), reader.readLine( "password: ", true ) );
+   ASSERT_EQ( String( "hello world" ), reader.readLine( "please confirm: ", true ) );
+   ASSERT_EQ( String( "Example" ), reader.readLine( "Name: " ) );
+   ASSERT_THROW( reader.readLine( "" ), std::runtime_error );
+}
+
+TEST_F( ReaderTest, LineNumber )
+{
+   std::istringstream script( "add\nExample\n\nquit\n" );
+   utils::Reader::setBatchMode( script );
+   ASSERT_EQ( 0U, utils::Reader::getLineNumber() );
+
+   // Lines consumed as input by commands count, too.
+   utils::Reader reader( 1024 );
+   reader.readLine();
+   reader.readLine( "Name: " );
+   ASSERT_EQ( 2U, utils::Reader::getLineNumber() );
+   reader.readLine();
+   reader.readLine();
+   ASSERT_EQ( 4U, utils::Reader::getLineNumber() );
+   ASSERT_THROW( reader.readLine(), std::runtime_error );
+   ASSERT_EQ( 4U, utils::Reader::getLineNumber() );
+
+   utils::Reader::resetBatchMode();
+   ASSERT_FALSE( utils::Reader::isBatchMode() );
+   ASSERT_EQ( 0U, utils::Reader::getLineNumber() );
+}
+
+} }
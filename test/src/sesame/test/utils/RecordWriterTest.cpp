@@ -0,0 +1,100 @@
+// Copyright (c) 2015, Karsten Heinze <karsten.heinze@sidenotes.de>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <sstream>
+#include <stdexcept>
+#include "gtest/gtest.h"
+#include "types.hpp"
+#include "msgpack.hpp"
+#include "sesame/utils/RecordWriter.hpp"
+#include "sesame/utils/string.hpp"
+
+
+namespace sesame { namespace test {
+
+TEST( RecordWriterTest, Json )
+{
+   utils::setLocale();
+
+   std::ostringstream stream;
+   utils::RecordWriter writer( stream, OUTPUT_JSON );
+
+   writer.beginMap( 3 );
+   writer.value( "id" ).value( "ab\"c\\d" );
+   writer.value( "tags" ).beginArray( 2 ).value( "a\tb" ).value( "\x01" ).end();
+   writer.value( "size" ).beginArray( 2 ).value( uint64_t( 42 ) ).nil().end();
+   writer.end();
+   writer.beginArray( 0 ).end();
+
+   ASSERT_EQ( "{\"id\":\"ab\\\"c\\\\d\",\"tags\":[\"a\\tb\",\"\\u0001\"],\"size\":[42,null]}\n[]\n",
+              stream.str() );
+
+   // Escaping leaves fill and flags of the stream alone.
+   ASSERT_EQ( ' ', stream.fill() );
+   ASSERT_EQ( std::ios_base::dec, stream.flags() & std::ios_base::basefield );
+}
+
+TEST( RecordWriterTest, Msgpack )
+{
+   utils::setLocale();
+
+   std::ostringstream stream;
+   utils::RecordWriter writer( stream, OUTPUT_MSGPACK );
+
+   for ( uint64_t i = 0; i < 2; ++i )
+   {
+      writer.beginMap( 2 );
+      writer.value( "name" ).value( "entry" );
+      writer.value( "pos" ).value( i );
+      writer.end();
+   }
+
+   const std::string data( stream.str() );
+   std::size_t offset( 0 );
+   for ( uint64_t i = 0; i < 2; ++i )
+   {
+      msgpack::unpacked result;
+      msgpack::unpack( result, data.data(), data.size(), offset );
+
+      std::map<std::string,msgpack::object> record;
+      result.get().convert( &record );
+      ASSERT_EQ( 2, record.size() );
+      ASSERT_EQ( "entry", record[ "name" ].as<std::string>() );
+      ASSERT_EQ( i, record[ "pos" ].as<uint64_t>() );
+   }
+   ASSERT_EQ( data.size(), offset );
+}
+
+TEST( RecordWriterTest, Errors )
+{
+   std::ostringstream stream;
+   ASSERT_THROW( utils::RecordWriter( stream, OUTPUT_TEXT ), std::runtime_error );
+
+   utils::RecordWriter writer( stream, OUTPUT_JSON );
+   ASSERT_THROW( writer.end(), std::runtime_error );
+}
+
+} }
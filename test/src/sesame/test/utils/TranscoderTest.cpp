@@ -23,8 +23,12 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <atomic>
 #include <iostream>
 #include <locale>
+#include <random>
+#include <stdexcept>
+#include <thread>
 #include "gtest/gtest.h"
 #include "types.hpp"
 #include "sesame/utils/string.hpp"
@@ -140,4 +144,116 @@ TEST( TranscoderTest, LargeStrings )
    ASSERT_EQ( s2, s4 );
 }
 
+TEST( TranscoderTest, FastPath )
+{
+   utils::setLocale();
+
+   // Fast path must behave like iconv (result and errors).
+   const uint8_t bytes[] = {
+      0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbb, 0xbf,
+      0xc0, 0xc1, 0xc2, 0xdf, 0xe0, 0xe1, 0xed, 0xef, 0xf0, 0xf4,
+      0xf5, 0xff
+   };
+   std::mt19937 generator( 4711 );
+   std::uniform_int_distribution<std::size_t> byte( 0, sizeof( bytes ) - 1 );
+   std::uniform_int_distribution<std::size_t> size( 0, 12 );
+
+   for ( uint32_t i = 0; i < 100000; ++i )
+   {
+      String text( size( generator ), '\0' );
+      for ( char& c : text )
+      {
+         c = static_cast<char>( bytes[ byte( generator ) ] );
+      }
+      if ( i % 10 == 0 )
+      {
+         text.insert( 0, "\xef\xbb\xbf" );
+      }
+
+      for ( bool to : { true, false } )
+      {
+         String expected, got;
+         bool expectedThrow( false ), gotThrow( false );
+         try
+         {
+            utils::Transcoder transcoder(
+               to ? utils::getEncoding() : "UTF-8",
+               to ? "UTF-8" : utils::getEncoding() );
+            expected = transcoder.transcode( text );
+         }
+         catch ( std::runtime_error& )
+         {
+            expectedThrow = true;
+         }
+         try
+         {
+            got = to ? utils::toUtf8( text ) : utils::fromUtf8( text );
+         }
+         catch ( std::runtime_error& )
+         {
+            gotThrow = true;
+         }
+
+         ASSERT_EQ( expectedThrow, gotThrow );
+         ASSERT_EQ( expected, got );
+      }
+   }
+}
+
+TEST( TranscoderTest, Threads )
+{
+   utils::setLocale();
+
+   // Valid, truncated (dropped by iconv) and illegal input.
+   const Vector<String> texts = {
+      "Hello, world!", "\xc3\xa4\xc3\xb6\xc3\xbc", "abc\xc3", "abc\xff"
+   };
+
+   Vector<String> expected;
+   for ( const String& text : texts )
+   {
+      try
+      {
+         utils::Transcoder transcoder( utils::getEncoding(), "UTF-8" );
+         expected.push_back( transcoder.transcode( text ) );
+      }
+      catch ( std::runtime_error& )
+      {
+         expected.push_back( "error" );
+      }
+   }
+
+   std::atomic<uint32_t> mismatches( 0 );
+   Vector<std::thread> threads;
+   for ( uint32_t t = 0; t < 8; ++t )
+   {
+      threads.push_back( std::thread( [&]()
+         {
+            for ( uint32_t i = 0; i < 10000; ++i )
+            {
+               const std::size_t j( i % texts.size() );
+               String got;
+               try
+               {
+                  got = utils::toUtf8( texts[ j ] );
+               }
+               catch ( std::runtime_error& )
+               {
+                  got = "error";
+               }
+               if ( got != expected[ j ] )
+               {
+                  ++mismatches;
+               }
+            }
+         } ) );
+   }
+   for ( std::thread& thread : threads )
+   {
+      thread.join();
+   }
+
+   ASSERT_EQ( 0U, mismatches.load() );
+}
+
 } }